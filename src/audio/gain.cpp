@@ -11,6 +11,9 @@
 #include "gain.hpp"
 
 #include <algorithm>
+#include <cmath>
+
+#include "mix_kernels.hpp"
 
 using std::size_t;
 
@@ -19,18 +22,34 @@ using srb2::audio::Gain;
 using srb2::audio::Sample;
 
 constexpr const float kGainInterpolationAlpha = 0.8f;
+constexpr const float kGainSnapDistance = 1.f / 65536.f;
 
 template <size_t C>
 size_t Gain<C>::filter(tcb::span<Sample<C>> input_buffer, tcb::span<Sample<C>> buffer)
 {
 	size_t written = std::min(buffer.size(), input_buffer.size());
-	for (size_t i = 0; i < written; i++)
+	size_t i = 0;
+
+	// Glide to a new gain a sample at a time; once there, the rest is one flat multiply.
+	for (; i < written && gain_ != new_gain_; i++)
 	{
 		buffer[i] = input_buffer[i];
 		buffer[i] *= gain_;
 		gain_ += (new_gain_ - gain_) * kGainInterpolationAlpha;
+
+		if (std::abs(new_gain_ - gain_) < kGainSnapDistance)
+		{
+			gain_ = new_gain_;
+		}
 	}
 
+	srb2::audio::mix_scale(
+		srb2::audio::sample_floats(buffer.data() + i),
+		srb2::audio::sample_floats(input_buffer.data() + i),
+		gain_,
+		(written - i) * C
+	);
+
 	return written;
 }
 
@@ -0,0 +1,222 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "mix_kernels.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIX_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX needs a runtime check, which we only know how to do on GCC and Clang.
+#if defined(MIX_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MIX_AVX
+#include <immintrin.h>
+#endif
+
+using std::size_t;
+
+using namespace srb2::audio;
+
+namespace
+{
+
+struct Kernels
+{
+	void (*add)(float* dst, const float* src, size_t count);
+	void (*scale)(float* dst, const float* src, float gain, size_t count);
+	void (*pan)(float* dst, const float* src, float left, float right, size_t count);
+	void (*clamp)(float* buffer, size_t count);
+};
+
+void add_scalar(float* dst, const float* src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		dst[i] += src[i];
+	}
+}
+
+void scale_scalar(float* dst, const float* src, float gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		dst[i] = src[i] * gain;
+	}
+}
+
+void pan_scalar(float* dst, const float* src, float left, float right, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		dst[i * 2] = src[i] * left;
+		dst[i * 2 + 1] = src[i] * right;
+	}
+}
+
+void clamp_scalar(float* buffer, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		buffer[i] = std::clamp(buffer[i], -1.f, 1.f);
+	}
+}
+
+#ifdef MIX_SSE2
+void add_sse2(float* dst, const float* src, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+	}
+	add_scalar(dst + i, src + i, count - i);
+}
+
+void scale_sse2(float* dst, const float* src, float gain, size_t count)
+{
+	const __m128 g = _mm_set1_ps(gain);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+	}
+	scale_scalar(dst + i, src + i, gain, count - i);
+}
+
+void pan_sse2(float* dst, const float* src, float left, float right, size_t count)
+{
+	const __m128 lr = _mm_setr_ps(left, right, left, right);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 m = _mm_loadu_ps(src + i);
+		_mm_storeu_ps(dst + i * 2, _mm_mul_ps(_mm_unpacklo_ps(m, m), lr));
+		_mm_storeu_ps(dst + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(m, m), lr));
+	}
+	pan_scalar(dst + i * 2, src + i, left, right, count - i);
+}
+
+void clamp_sse2(float* buffer, size_t count)
+{
+	const __m128 lo = _mm_set1_ps(-1.f);
+	const __m128 hi = _mm_set1_ps(1.f);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(buffer + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(buffer + i), lo), hi));
+	}
+	clamp_scalar(buffer + i, count - i);
+}
+#endif
+
+#ifdef MIX_AVX
+// Each of these finishes its tail with the SSE2 version. Clear the upper halves
+// of the ymm registers first, or the legacy SSE instructions there (and in the
+// caller afterwards) pay the AVX to SSE transition penalty.
+
+__attribute__((target("avx"))) void add_avx(float* dst, const float* src, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+	}
+	_mm256_zeroupper();
+	add_sse2(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx"))) void scale_avx(float* dst, const float* src, float gain, size_t count)
+{
+	const __m256 g = _mm256_set1_ps(gain);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+	}
+	_mm256_zeroupper();
+	scale_sse2(dst + i, src + i, gain, count - i);
+}
+
+__attribute__((target("avx"))) void pan_avx(float* dst, const float* src, float left, float right, size_t count)
+{
+	const __m256 lr = _mm256_setr_ps(left, right, left, right, left, right, left, right);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		// unpack works within each 128-bit half, so put the halves back in order afterwards
+		const __m256 m = _mm256_loadu_ps(src + i);
+		const __m256 lo = _mm256_unpacklo_ps(m, m); // 0 0 1 1 | 4 4 5 5
+		const __m256 hi = _mm256_unpackhi_ps(m, m); // 2 2 3 3 | 6 6 7 7
+		_mm256_storeu_ps(dst + i * 2, _mm256_mul_ps(_mm256_permute2f128_ps(lo, hi, 0x20), lr));
+		_mm256_storeu_ps(dst + i * 2 + 8, _mm256_mul_ps(_mm256_permute2f128_ps(lo, hi, 0x31), lr));
+	}
+	_mm256_zeroupper();
+	pan_sse2(dst + i * 2, src + i, left, right, count - i);
+}
+
+__attribute__((target("avx"))) void clamp_avx(float* buffer, size_t count)
+{
+	const __m256 lo = _mm256_set1_ps(-1.f);
+	const __m256 hi = _mm256_set1_ps(1.f);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(buffer + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(buffer + i), lo), hi));
+	}
+	_mm256_zeroupper();
+	clamp_sse2(buffer + i, count - i);
+}
+#endif
+
+Kernels pick_kernels()
+{
+#ifdef MIX_AVX
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx"))
+	{
+		return {add_avx, scale_avx, pan_avx, clamp_avx};
+	}
+#endif
+#ifdef MIX_SSE2
+	return {add_sse2, scale_sse2, pan_sse2, clamp_sse2};
+#else
+	return {add_scalar, scale_scalar, pan_scalar, clamp_scalar};
+#endif
+}
+
+const Kernels& kernels()
+{
+	static const Kernels k = pick_kernels();
+	return k;
+}
+
+} // namespace
+
+void srb2::audio::mix_add(float* dst, const float* src, size_t count)
+{
+	kernels().add(dst, src, count);
+}
+
+void srb2::audio::mix_scale(float* dst, const float* src, float gain, size_t count)
+{
+	kernels().scale(dst, src, gain, count);
+}
+
+void srb2::audio::mix_pan(float* dst, const float* src, float left, float right, size_t count)
+{
+	kernels().pan(dst, src, left, right, count);
+}
+
+void srb2::audio::mix_clamp(float* buffer, size_t count)
+{
+	kernels().clamp(buffer, count);
+}
@@ -0,0 +1,54 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_AUDIO_MIX_KERNELS_HPP__
+#define __SRB2_AUDIO_MIX_KERNELS_HPP__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "sample.hpp"
+
+namespace srb2::audio
+{
+
+// Bulk sample arithmetic for the mixing path. Counts are in floats, not samples,
+// so Sample<C> buffers are passed as C * size floats. The best of AVX, SSE2 or
+// plain loops is chosen once, the first time any of these is called.
+
+/// @brief dst[i] += src[i]
+void mix_add(float* dst, const float* src, std::size_t count);
+
+/// @brief dst[i] = src[i] * gain. dst may be src.
+void mix_scale(float* dst, const float* src, float gain, std::size_t count);
+
+/// @brief Spreads count mono floats from src across 2 * count stereo floats in dst.
+void mix_pan(float* dst, const float* src, float left, float right, std::size_t count);
+
+/// @brief Clamps every float to [-1, 1].
+void mix_clamp(float* buffer, std::size_t count);
+
+template <size_t C>
+inline float* sample_floats(Sample<C>* samples) noexcept
+{
+	static_assert(sizeof(Sample<C>) == sizeof(float) * C);
+	return samples->amplitudes.data();
+}
+
+template <size_t C>
+inline const float* sample_floats(const Sample<C>* samples) noexcept
+{
+	static_assert(sizeof(Sample<C>) == sizeof(float) * C);
+	return samples->amplitudes.data();
+}
+
+} // namespace srb2::audio
+
+#endif // __SRB2_AUDIO_MIX_KERNELS_HPP__
@@ -12,6 +12,8 @@
 
 #include <algorithm>
 
+#include "mix_kernels.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 
@@ -31,10 +33,7 @@ void default_init_sample_buffer(Sample<C>* buffer, size_t size)
 template <size_t C>
 void mix_sample_buffers(Sample<C>* dst, size_t size, Sample<C>* src, size_t src_size)
 {
-	for (size_t i = 0; i < size && i < src_size; i++)
-	{
-		dst[i] += src[i];
-	}
+	srb2::audio::mix_add(srb2::audio::sample_floats(dst), srb2::audio::sample_floats(src), std::min(size, src_size) * C);
 }
 
 } // namespace
@@ -48,6 +47,10 @@ size_t Mixer<C>::generate(tcb::span<Sample<C>> buffer)
 
 	for (auto& source : sources_)
 	{
+		// Most sound effect channels are sitting finished at any given moment
+		if (source->idle())
+			continue;
+
 		size_t read = source->generate(buffer_);
 
 		mix_sample_buffers<C>(buffer.data(), buffer.size(), buffer_.data(), read);
@@ -14,6 +14,8 @@
 #include <cmath>
 #include <memory>
 
+#include "mix_kernels.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 
@@ -30,18 +32,22 @@ size_t SoundEffectPlayer::generate(tcb::span<Sample<2>> buffer)
 		return 0;
 	}
 
-	size_t written = 0;
-	for (; position_ < chunk_->samples.size() && written < buffer.size(); position_++)
-	{
-		float mono_sample = chunk_->samples[position_].amplitudes[0];
+	size_t written = std::min(chunk_->samples.size() - position_, buffer.size());
 
-		float sep_pan = ((sep_ + 1.f) / 2.f) * (3.14159 / 2.f);
+	float sep_pan = ((sep_ + 1.f) / 2.f) * (3.14159 / 2.f);
+
+	float left_scale = std::cos(sep_pan);
+	float right_scale = std::sin(sep_pan);
+
+	srb2::audio::mix_pan(
+		srb2::audio::sample_floats(buffer.data()),
+		srb2::audio::sample_floats(chunk_->samples.data() + position_),
+		volume_ * left_scale,
+		volume_ * right_scale,
+		written
+	);
+	position_ += written;
 
-		float left_scale = std::cos(sep_pan);
-		float right_scale = std::sin(sep_pan);
-		buffer[written] = {mono_sample * volume_ * left_scale, mono_sample * volume_ * right_scale};
-		written += 1;
-	}
 	return written;
 }
 
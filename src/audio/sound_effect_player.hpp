@@ -25,6 +25,7 @@ class SoundEffectPlayer : public Source<2>
 {
 public:
 	virtual std::size_t generate(tcb::span<Sample<2>> buffer) override final;
+	virtual bool idle() const override final { return finished(); }
 
 	virtual ~SoundEffectPlayer() final;
 
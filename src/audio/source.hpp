@@ -26,6 +26,9 @@ class Source
 public:
 	virtual std::size_t generate(tcb::span<Sample<C>> buffer) = 0;
 
+	/// @brief True if generate would produce nothing right now, so mixers can skip it.
+	virtual bool idle() const { return false; }
+
 	virtual ~Source() = default;
 };
 
@@ -0,0 +1,72 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_CORE_SPSC_QUEUE_HPP__
+#define __SRB2_CORE_SPSC_QUEUE_HPP__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+namespace srb2
+{
+
+/// @brief Fixed-capacity ring for handing values from exactly one thread to exactly one other thread,
+/// without locks or allocation. push must only be called by the producer, pop by the consumer.
+template <typename T, size_t Capacity>
+class SpScQueue
+{
+	static_assert(Capacity && !(Capacity & (Capacity - 1)), "Capacity must be a power of 2!");
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	std::array<T, Capacity> buffer_;
+	alignas(64) std::atomic<size_t> head_ {0}; // next slot to pop, written by the consumer
+	alignas(64) std::atomic<size_t> tail_ {0}; // next slot to push, written by the producer
+
+public:
+	/// @brief Returns false, leaving the queue unchanged, if the queue is full.
+	bool push(const T& value) noexcept
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+
+		if (tail - head_.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+
+		buffer_[tail & (Capacity - 1)] = value;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::optional<T> pop() noexcept
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+
+		if (head == tail_.load(std::memory_order_acquire))
+		{
+			return std::nullopt;
+		}
+
+		T value = buffer_[head & (Capacity - 1)];
+		head_.store(head + 1, std::memory_order_release);
+		return value;
+	}
+
+	bool empty() const noexcept
+	{
+		return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+	}
+};
+
+} // namespace srb2
+
+#endif // __SRB2_CORE_SPSC_QUEUE_HPP__
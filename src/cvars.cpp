@@ -437,6 +437,7 @@ consvar_t cv_renderer = Player("renderer", "Software").flags(CV_NOLUA).values(cv
 consvar_t cv_parallelsoftware = Player("parallelsoftware", "On").on_off();
 
 consvar_t cv_renderview = Player("renderview", "On").values({{0, "Off"}, {1, "On"}, {2, "Force"}}).dont_save();
+consvar_t cv_rewindmemory = Player("rewindmemory", "64").values(CV_Natural); // MiB kept for replay rewind points
 consvar_t cv_rollingdemos = Player("rollingdemos", "On").on_off();
 consvar_t cv_scr_depth = Player("scr_depth", "16 bits").values({{8, "8 bits"}, {16, "16 bits"}, {24, "24 bits"}, {32, "32 bits"}});
 
@@ -551,13 +552,20 @@ consvar_t cv_masterserver_update_rate = Server("masterserver_update_rate", "15")
 consvar_t cv_maxping = Server("maxdelay", "20").min_max(0, 30);
 consvar_t cv_menujam = Server("menujam", "_title").values({{0, "menu"}, {1, "menu2"}, {2, "menu3"}, {3, "_title"}});
 consvar_t cv_menujam_update = Server("menujam_update", "Off").on_off();
+consvar_t cv_netdeltatics = Server("netdeltatics", "On").on_off();
 consvar_t cv_netdemosyncquality = Server("netdemo_syncquality", "1").min_max(1, 35);
 consvar_t cv_netdemosize = Server("netdemo_size", "6").values(CV_Natural);
 
 void NetTimeout_OnChange(void);
 consvar_t cv_nettimeout = Server("nettimeout", "210").min_max(TICRATE/7, 60*TICRATE).onchange(NetTimeout_OnChange);
 
+consvar_t cv_parallelbots = Server("parallelbots", "On").on_off();
 consvar_t cv_pause = NetVar("pausepermission", "Server Admins").values({{0, "Server Admins"}, {1, "Everyone"}});
+
+// file under the home directory (.csv for CSV, JSON lines otherwise), or unix:<socket path>
+void PS_Export_OnChange(void);
+consvar_t cv_perfstats_export = Server("perfstats_export", "").onchange(PS_Export_OnChange);
+
 consvar_t cv_pingmeasurement = Server("pingmeasurement", "Frames").values({{0, "Frames"}, {1, "Milliseconds"}});
 consvar_t cv_playbackspeed = Server("playbackspeed", "1").min_max(1, 10).dont_save();
 
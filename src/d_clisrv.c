@@ -293,6 +293,337 @@ static inline void *G_ScpyTiccmd(ticcmd_t* dest, void* src, const size_t n)
 	return ret+n;
 }
 
+// Delta-coded ticcmds (SERVERTICS_DELTA): a byte of TD_ flags for the fields
+// that differ from the previous ticcmd, then only those fields. 16-bit fields
+// are sent as zigzagged varints of their difference, buttons as a varint.
+typedef enum
+{
+	TD_FORWARDMOVE = 1,
+	TD_TURNING     = 1<<1,
+	TD_ANGLE       = 1<<2,
+	TD_THROWDIR    = 1<<3,
+	TD_AIMING      = 1<<4,
+	TD_BUTTONS     = 1<<5,
+	TD_LATENCY     = 1<<6,
+	TD_FLAGS       = 1<<7, // and bot.itemconfirm
+} ticcmddelta_t;
+
+static const ticcmd_t emptyticcmd;
+
+static UINT8 *D_WriteVarint(UINT8 *p, UINT32 v)
+{
+	while (v >= 0x80)
+	{
+		*p++ = (UINT8)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (UINT8)v;
+	return p;
+}
+
+// Reading stops at end, so a short or corrupt packet can't run past it.
+// The readers return NULL if it would have.
+static UINT8 *D_ReadVarint(UINT8 *p, const UINT8 *end, UINT32 *v)
+{
+	UINT32 r = 0;
+	INT32 shift = 0;
+	UINT8 b;
+
+	do
+	{
+		if (p >= end)
+			return NULL;
+		b = *p++;
+		r |= (UINT32)(b & 0x7F) << shift;
+		shift += 7;
+	} while ((b & 0x80) && shift < 21);
+
+	*v = r;
+	return p;
+}
+
+static UINT8 *D_WriteShortDelta(UINT8 *p, INT16 prev, INT16 cur)
+{
+	const INT16 d = (INT16)(cur - prev);
+
+	// zigzag, in unsigned arithmetic: shifting a negative value left is undefined
+	return D_WriteVarint(p, (UINT16)(((UINT16)d << 1) ^ (UINT16)(d >> 15)));
+}
+
+static UINT8 *D_ReadShortDelta(UINT8 *p, const UINT8 *end, boolean sent, INT16 prev, INT16 *cur)
+{
+	UINT32 z;
+
+	*cur = prev;
+
+	if (!sent)
+		return p;
+
+	if ((p = D_ReadVarint(p, end, &z)) == NULL)
+		return NULL;
+
+	*cur = (INT16)(prev + (INT16)((z >> 1) ^ -(INT32)(z & 1)));
+	return p;
+}
+
+// bot.itemconfirm only goes over the wire for bots, see G_MoveTiccmd
+static inline SINT8 D_ItemConfirm(const ticcmd_t *cmd)
+{
+	return (cmd->flags & TICCMD_BOT) ? cmd->bot.itemconfirm : 0;
+}
+
+static UINT8 *D_WriteTiccmdDelta(UINT8 *p, const ticcmd_t *prev, const ticcmd_t *cur)
+{
+	UINT8 *mask = p++;
+
+	*mask = 0;
+
+	if (cur->forwardmove != prev->forwardmove)
+	{
+		*mask |= TD_FORWARDMOVE;
+		WRITESINT8(p, cur->forwardmove);
+	}
+	if (cur->turning != prev->turning)
+	{
+		*mask |= TD_TURNING;
+		p = D_WriteShortDelta(p, prev->turning, cur->turning);
+	}
+	if (cur->angle != prev->angle)
+	{
+		*mask |= TD_ANGLE;
+		p = D_WriteShortDelta(p, prev->angle, cur->angle);
+	}
+	if (cur->throwdir != prev->throwdir)
+	{
+		*mask |= TD_THROWDIR;
+		p = D_WriteShortDelta(p, prev->throwdir, cur->throwdir);
+	}
+	if (cur->aiming != prev->aiming)
+	{
+		*mask |= TD_AIMING;
+		p = D_WriteShortDelta(p, prev->aiming, cur->aiming);
+	}
+	if (cur->buttons != prev->buttons)
+	{
+		*mask |= TD_BUTTONS;
+		p = D_WriteVarint(p, cur->buttons);
+	}
+	if (cur->latency != prev->latency)
+	{
+		*mask |= TD_LATENCY;
+		WRITEUINT8(p, cur->latency);
+	}
+	if (cur->flags != prev->flags || D_ItemConfirm(cur) != D_ItemConfirm(prev))
+	{
+		*mask |= TD_FLAGS;
+		WRITEUINT8(p, cur->flags);
+		if (cur->flags & TICCMD_BOT)
+			WRITESINT8(p, cur->bot.itemconfirm);
+	}
+
+	return p;
+}
+
+static UINT8 *D_ReadTiccmdDelta(UINT8 *p, const UINT8 *end, const ticcmd_t *prev, ticcmd_t *cur)
+{
+	UINT8 mask;
+	UINT32 v;
+	INT16 turning, angle, throwdir, aiming;
+
+	if (p >= end)
+		return NULL;
+
+	mask = READUINT8(p);
+
+	if (mask & TD_FORWARDMOVE)
+	{
+		if (p >= end)
+			return NULL;
+		cur->forwardmove = READSINT8(p);
+	}
+	else
+		cur->forwardmove = prev->forwardmove;
+
+	// (through locals, since ticcmd_t is packed)
+	if ((p = D_ReadShortDelta(p, end, (mask & TD_TURNING), prev->turning, &turning)) == NULL
+		|| (p = D_ReadShortDelta(p, end, (mask & TD_ANGLE), prev->angle, &angle)) == NULL
+		|| (p = D_ReadShortDelta(p, end, (mask & TD_THROWDIR), prev->throwdir, &throwdir)) == NULL
+		|| (p = D_ReadShortDelta(p, end, (mask & TD_AIMING), prev->aiming, &aiming)) == NULL)
+		return NULL;
+
+	cur->turning = turning;
+	cur->angle = angle;
+	cur->throwdir = throwdir;
+	cur->aiming = aiming;
+
+	if (mask & TD_BUTTONS)
+	{
+		if ((p = D_ReadVarint(p, end, &v)) == NULL)
+			return NULL;
+		cur->buttons = (UINT16)v;
+	}
+	else
+		cur->buttons = prev->buttons;
+
+	if (mask & TD_LATENCY)
+	{
+		if (p >= end)
+			return NULL;
+		cur->latency = READUINT8(p);
+	}
+	else
+		cur->latency = prev->latency;
+
+	if (mask & TD_FLAGS)
+	{
+		if (p >= end)
+			return NULL;
+		cur->flags = READUINT8(p);
+
+		if (cur->flags & TICCMD_BOT)
+		{
+			if (p >= end)
+				return NULL;
+			cur->bot.itemconfirm = READSINT8(p);
+		}
+		else
+			cur->bot.itemconfirm = 0;
+	}
+	else
+	{
+		cur->flags = prev->flags;
+		cur->bot.itemconfirm = D_ItemConfirm(prev);
+	}
+
+	return p;
+}
+
+// prev is the previous tic's ticcmds, or NULL for the first tic in a packet.
+static UINT8 *D_WriteTiccmdDeltas(UINT8 *p, const ticcmd_t *prev, const ticcmd_t *cur, size_t numslots)
+{
+	size_t i;
+
+	for (i = 0; i < numslots; i++)
+		p = D_WriteTiccmdDelta(p, prev ? &prev[i] : &emptyticcmd, &cur[i]);
+
+	return p;
+}
+
+static UINT8 *D_ReadTiccmdDeltas(UINT8 *p, const UINT8 *end, const ticcmd_t *prev, ticcmd_t *cur, size_t numslots)
+{
+	size_t i;
+
+	for (i = 0; i < numslots && p != NULL; i++)
+		p = D_ReadTiccmdDelta(p, end, prev ? &prev[i] : &emptyticcmd, &cur[i]);
+
+	return p;
+}
+
+static size_t D_TiccmdDeltasSize(const ticcmd_t *prev, const ticcmd_t *cur, size_t numslots)
+{
+	UINT8 buf[MAXTICCMDPAKSIZE];
+	size_t i, size = 0;
+
+	for (i = 0; i < numslots; i++)
+		size += D_WriteTiccmdDelta(buf, prev ? &prev[i] : &emptyticcmd, &cur[i]) - buf;
+
+	return size;
+}
+
+// Finds the end of a packet's delta-coded ticcmds without keeping them.
+// How long a ticcmd is never depends on the one before it.
+UINT8 *D_SkipTiccmdDeltas(UINT8 *p, const UINT8 *end, size_t count)
+{
+	ticcmd_t scratch;
+	size_t i;
+
+	for (i = 0; i < count && p != NULL; i++)
+		p = D_ReadTiccmdDelta(p, end, &emptyticcmd, &scratch);
+
+	return p;
+}
+
+#ifdef DEVELOP
+static UINT32 D_TiccmdDeltaRandom(UINT32 *state)
+{
+	// xorshift32, so the check never touches the game's random numbers
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static void D_RandomTiccmd(ticcmd_t *cmd, const ticcmd_t *like, UINT32 *state)
+{
+	// Each field either matches like or is random, so every mask gets used.
+	#define FIELD(field, type) \
+		cmd->field = (D_TiccmdDeltaRandom(state) & 1) ? like->field : (type)D_TiccmdDeltaRandom(state)
+
+	FIELD(forwardmove, SINT8);
+	FIELD(turning, INT16);
+	FIELD(angle, INT16);
+	FIELD(throwdir, INT16);
+	FIELD(aiming, INT16);
+	FIELD(buttons, UINT16);
+	FIELD(latency, UINT8);
+	FIELD(flags, UINT8);
+	FIELD(bot.itemconfirm, SINT8);
+
+	#undef FIELD
+}
+
+static boolean D_TiccmdsMatch(const ticcmd_t *a, const ticcmd_t *b)
+{
+	return (a->forwardmove == b->forwardmove
+		&& a->turning == b->turning
+		&& a->angle == b->angle
+		&& a->throwdir == b->throwdir
+		&& a->aiming == b->aiming
+		&& a->buttons == b->buttons
+		&& a->latency == b->latency
+		&& a->flags == b->flags
+		&& D_ItemConfirm(a) == D_ItemConfirm(b));
+}
+
+// Round-trips random rows of ticcmds through the delta coder, bots
+// included, and makes sure every truncation of them is refused.
+static void D_CheckTiccmdDeltas(void)
+{
+	static ticcmd_t prev[MAXPLAYERS], cur[MAXPLAYERS], in[MAXPLAYERS], out[MAXPLAYERS];
+	static UINT8 buf[MAXPLAYERS * MAXTICCMDPAKSIZE];
+	UINT32 state = 0x5EED1234;
+	size_t i, round, len;
+	UINT8 *end;
+
+	for (round = 0; round < 2048; round++)
+	{
+		memcpy(prev, cur, sizeof prev);
+		for (i = 0; i < MAXPLAYERS; i++)
+			D_RandomTiccmd(&cur[i], &prev[i], &state);
+
+		// Alternate between a packet's first tic and the ones after it.
+		end = D_WriteTiccmdDeltas(buf, (round & 1) ? prev : NULL, cur, MAXPLAYERS);
+		len = end - buf;
+
+		if (len != D_TiccmdDeltasSize((round & 1) ? prev : NULL, cur, MAXPLAYERS))
+			I_Error("D_CheckTiccmdDeltas: size mismatch in round %s", sizeu1(round));
+
+		if (D_ReadTiccmdDeltas(buf, end, (round & 1) ? prev : NULL, out, MAXPLAYERS) != end
+			|| D_SkipTiccmdDeltas(buf, end, MAXPLAYERS) != end)
+			I_Error("D_CheckTiccmdDeltas: length mismatch in round %s", sizeu1(round));
+
+		for (i = 0; i < MAXPLAYERS; i++)
+		{
+			if (!D_TiccmdsMatch(&cur[i], &out[i]))
+				I_Error("D_CheckTiccmdDeltas: slot %s differs in round %s", sizeu1(i), sizeu2(round));
+		}
+
+		if (D_ReadTiccmdDeltas(buf, buf + D_TiccmdDeltaRandom(&state) % len, NULL, in, MAXPLAYERS) != NULL)
+			I_Error("D_CheckTiccmdDeltas: truncated row accepted in round %s", sizeu1(round));
+	}
+}
+#endif
+
 
 
 // Some software don't support largest packet
@@ -3270,6 +3601,10 @@ void D_ClientServerInit(void)
 #endif
 	COM_AddCommand("numnodes", Command_Numnodes);
 
+#ifdef DEVELOP
+	D_CheckTiccmdDeltas();
+#endif
+
 	RegisterNetXCmd(XD_KICK, Got_KickCmd);
 	RegisterNetXCmd(XD_ADDPLAYER, Got_AddPlayer);
 	RegisterNetXCmd(XD_REMOVEPLAYER, Got_RemovePlayer);
@@ -5078,7 +5413,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 				// doomcom->numslots+1 "+1" since doomcom->numslots can change within this time and sent time
 				j = software_MAXPACKETLENGTH
 					- (incoming_size + 3 + BASESERVERTICSSIZE
-					+ (doomcom->numslots+1)*sizeof(ticcmd_t));
+					+ (doomcom->numslots+1)*MAXTICCMDPAKSIZE);
 
 				// search a tic that have enougth space in the ticcmd
 				while ((textcmd = D_GetExistingTextcmd(tic, netconsole)),
@@ -5212,8 +5547,21 @@ static void HandlePacketFromPlayer(SINT8 node)
 			realend = realstart + netbuffer->u.serverpak.numtics;
 
 			if (!txtpak)
-				txtpak = (UINT8 *)&netbuffer->u.serverpak.cmds[netbuffer->u.serverpak.numslots
-					* netbuffer->u.serverpak.numtics];
+			{
+				if (netbuffer->u.serverpak.flags & SERVERTICS_DELTA)
+					txtpak = D_SkipTiccmdDeltas((UINT8 *)&netbuffer->u.serverpak.cmds,
+						(UINT8 *)netbuffer + doomcom->datalength,
+						netbuffer->u.serverpak.numslots * netbuffer->u.serverpak.numtics);
+				else
+					txtpak = (UINT8 *)&netbuffer->u.serverpak.cmds[netbuffer->u.serverpak.numslots
+						* netbuffer->u.serverpak.numtics];
+
+				if (!txtpak)
+				{
+					CONS_Alert(CONS_WARNING, M_GetText("Truncated %s from the server\n"), "PT_SERVERTICS");
+					break;
+				}
+			}
 
 			if (realend > gametic + CLIENTBACKUPTICS)
 				realend = gametic + CLIENTBACKUPTICS;
@@ -5230,8 +5578,12 @@ static void HandlePacketFromPlayer(SINT8 node)
 					D_Clearticcmd(i);
 
 					// copy the tics
-					pak = G_ScpyTiccmd(netcmds[i%BACKUPTICS], pak,
-						netbuffer->u.serverpak.numslots*sizeof (ticcmd_t));
+					if (netbuffer->u.serverpak.flags & SERVERTICS_DELTA)
+						pak = D_ReadTiccmdDeltas(pak, txtpak, (i > realstart) ? netcmds[(i-1)%BACKUPTICS] : NULL,
+							netcmds[i%BACKUPTICS], netbuffer->u.serverpak.numslots);
+					else
+						pak = G_ScpyTiccmd(netcmds[i%BACKUPTICS], pak,
+							netbuffer->u.serverpak.numslots*sizeof (ticcmd_t));
 
 					// copy the textcmds
 					numtxtpak = *txtpak++;
@@ -5852,6 +6204,7 @@ static void SV_SendTics(void)
 	size_t packsize;
 	UINT8 *bufpos;
 	UINT8 *ntextcmd;
+	const boolean delta = (cv_netdeltatics.value != 0);
 
 	// send to all client but not to me
 	// for each node create a packet with x tics and send it
@@ -5887,7 +6240,11 @@ static void SV_SendTics(void)
 			packsize = BASESERVERTICSSIZE;
 			for (i = realfirsttic; i < lasttictosend; i++)
 			{
-				packsize += sizeof (ticcmd_t) * doomcom->numslots;
+				if (delta)
+					packsize += D_TiccmdDeltasSize((i > realfirsttic) ? netcmds[(i-1)%BACKUPTICS] : NULL,
+						netcmds[i%BACKUPTICS], doomcom->numslots);
+				else
+					packsize += sizeof (ticcmd_t) * doomcom->numslots;
 				packsize += TotalTextCmdPerTic(i);
 
 				if (packsize > software_MAXPACKETLENGTH)
@@ -5921,11 +6278,16 @@ static void SV_SendTics(void)
 			netbuffer->u.serverpak.starttic = (UINT8)realfirsttic;
 			netbuffer->u.serverpak.numtics = (UINT8)(lasttictosend - realfirsttic);
 			netbuffer->u.serverpak.numslots = (UINT8)SHORT(doomcom->numslots);
+			netbuffer->u.serverpak.flags = delta ? SERVERTICS_DELTA : 0;
 			bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
 
 			for (i = realfirsttic; i < lasttictosend; i++)
 			{
-				bufpos = G_DcpyTiccmd(bufpos, netcmds[i%BACKUPTICS], doomcom->numslots * sizeof (ticcmd_t));
+				if (delta)
+					bufpos = D_WriteTiccmdDeltas(bufpos, (i > realfirsttic) ? netcmds[(i-1)%BACKUPTICS] : NULL,
+						netcmds[i%BACKUPTICS], doomcom->numslots);
+				else
+					bufpos = G_DcpyTiccmd(bufpos, netcmds[i%BACKUPTICS], doomcom->numslots * sizeof (ticcmd_t));
 			}
 
 			// add textcmds
@@ -6001,6 +6363,7 @@ static void SV_Maketic(void)
 	INT32 i;
 
 	PS_ResetBotInfo();
+	K_BuildBotTiccmds(netcmds[maketic%BACKUPTICS]);
 
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
@@ -6010,16 +6373,7 @@ static void SV_Maketic(void)
 			continue;
 
 		if (K_PlayerUsesBotMovement(&players[i]))
-		{
-			const precise_t t = I_GetPreciseTime();
-
-			K_BuildBotTiccmd(&players[i], &netcmds[maketic%BACKUPTICS][i]);
-
-			ps_bots[i].isBot = true;
-			ps_bots[i].total = I_GetPreciseTime() - t;
-			ps_botticcmd_time += ps_bots[i].total;
 			continue;
-		}
 
 		// We didn't receive this tic
 		if ((netcmds[maketic % BACKUPTICS][i].flags & TICCMD_RECEIVED) == 0)
@@ -6165,6 +6519,9 @@ boolean TryRunTics(tic_t realtics)
 
 			ps_tictime = I_GetPreciseTime() - ps_tictime;
 
+			G_SimBenchTic();
+			PS_RecordTicSample();
+
 			// Leave a certain amount of tics present in the net buffer as long as we've ran at least one tic this frame.
 			if (client && gamestate == GS_LEVEL && leveltime > 1 && neededtic <= gametic + cv_netticbuffer.value)
 			{
@@ -6560,6 +6917,10 @@ void NetKeepAlive(void)
 	tic_t nowtime;
 	INT32 realtics;
 
+	// Anything sent since the last update, e.g. from the menus
+	if (I_NetFlush)
+		I_NetFlush();
+
 	nowtime = I_GetTime();
 	realtics = nowtime - gametime;
 
@@ -6781,6 +7142,9 @@ void NetUpdate(void)
 	}
 
 	FileSendTicker();
+
+	if (I_NetFlush)
+		I_NetFlush();
 }
 
 /** Returns the number of players playing.
@@ -6824,38 +7188,197 @@ tic_t GetLag(INT32 node)
 }
 
 #define REWIND_POINT_INTERVAL 4*TICRATE + 16
+#define REWIND_KEYFRAME_INTERVAL 8 // rewind points per keyframe, counting the keyframe
 rewind_t *rewindhead;
 
+// Rewind points are kept newest first. Every few points is a keyframe,
+// and the points after it store their save XORed against its save, which
+// is mostly zeroes and compresses far better than the save on its own.
+// Each keyframe and its deltas form a group; the oldest groups are thrown
+// away to stay within cv_rewindmemory.
+static UINT8 *rewindsave; // current save being written or read
+static UINT8 *rewindpack; // compressed save before it is copied into a point
+static UINT8 *rewindkey; // uncompressed save of rewindkeyframe
+static size_t rewindkeysize;
+static rewind_t *rewindkeyframe; // keyframe rewindkey holds, if any
+static size_t rewindmemory; // bytes used by all rewind points
+
+static void CL_FreeRewind(rewind_t *rewind)
+{
+	if (rewind == rewindkeyframe)
+		rewindkeyframe = NULL;
+
+	rewindmemory -= sizeof (rewind_t) + rewind->datasize;
+	free(rewind->data);
+	free(rewind);
+}
+
+// Unpacks a rewind point's stored data into dest, which holds
+// NETSAVEGAMESIZE bytes, without applying its keyframe.
+static boolean CL_UnpackRewind(const rewind_t *rewind, UINT8 *dest)
+{
+	if (!rewind->compressed)
+	{
+		M_Memcpy(dest, rewind->data, rewind->savesize);
+		return true;
+	}
+
+	return (lzf_decompress(rewind->data, rewind->datasize, dest, NETSAVEGAMESIZE) == rewind->savesize);
+}
+
+// Makes rewindkey hold the save of a keyframe.
+static boolean CL_LoadRewindKeyframe(rewind_t *keyframe)
+{
+	if (rewindkeyframe == keyframe)
+		return true;
+
+	rewindkeyframe = NULL;
+
+	if (!CL_UnpackRewind(keyframe, rewindkey))
+		return false;
+
+	rewindkeysize = keyframe->savesize;
+	rewindkeyframe = keyframe;
+	return true;
+}
+
+static void CL_XORRewindKeyframe(UINT8 *save, size_t savesize)
+{
+	size_t length = min(savesize, rewindkeysize);
+	size_t i;
+
+	for (i = 0; i < length; i++)
+		save[i] ^= rewindkey[i];
+}
+
+// Throws away the oldest keyframe groups until the budget is met,
+// keeping at least the group the newest point belongs to.
+static void CL_TrimRewinds(void)
+{
+	const size_t budget = (size_t)cv_rewindmemory.value * 1024 * 1024;
+
+	while (rewindhead && rewindmemory > budget)
+	{
+		rewind_t *oldest, *prev = NULL, *rewind;
+
+		for (oldest = rewindhead; oldest->next; oldest = oldest->next)
+			;
+
+		// A group runs from its keyframe up to the next keyframe, so it's the tail of the list.
+		for (rewind = rewindhead; rewind; prev = rewind, rewind = rewind->next)
+		{
+			if (rewind == oldest || rewind->keyframe == oldest)
+				break;
+		}
+
+		if (prev == NULL)
+			break;
+
+		prev->next = NULL;
+		while (rewind)
+		{
+			rewind_t *next = rewind->next;
+			CL_FreeRewind(rewind);
+			rewind = next;
+		}
+	}
+}
+
 void CL_ClearRewinds(void)
 {
 	rewind_t *head;
 	while ((head = rewindhead))
 	{
 		rewindhead = rewindhead->next;
-		free(head);
+		CL_FreeRewind(head);
 	}
+
+	free(rewindsave);
+	free(rewindpack);
+	free(rewindkey);
+	rewindsave = rewindpack = rewindkey = NULL;
+	rewindkeyframe = NULL;
+	rewindmemory = 0;
 }
 
 rewind_t *CL_SaveRewindPoint(size_t demopos)
 {
 	savebuffer_t save = {0};
-	rewind_t *rewind;
+	rewind_t *rewind, *keyframe = NULL;
+	size_t savesize, packsize;
 
 	if (rewindhead && rewindhead->leveltime + REWIND_POINT_INTERVAL > leveltime)
 		return NULL;
 
+	if (!rewindsave)
+	{
+		rewindsave = malloc(NETSAVEGAMESIZE);
+		rewindpack = malloc(NETSAVEGAMESIZE);
+		rewindkey = malloc(NETSAVEGAMESIZE);
+		if (!rewindsave || !rewindpack || !rewindkey)
+		{
+			CL_ClearRewinds();
+			return NULL;
+		}
+	}
+
+	P_SaveBufferFromExisting(&save, rewindsave, NETSAVEGAMESIZE);
+	P_SaveNetGame(&save, false);
+	savesize = save.p - save.buffer;
+
+	// Delta against the newest keyframe, unless it's time for a new one.
+	if (rewindhead)
+	{
+		INT32 points = 1;
+
+		keyframe = rewindhead->keyframe ? rewindhead->keyframe : rewindhead;
+		for (rewind = rewindhead; rewind != keyframe; rewind = rewind->next)
+			points++;
+
+		if (points >= REWIND_KEYFRAME_INTERVAL || !CL_LoadRewindKeyframe(keyframe))
+			keyframe = NULL;
+	}
+
+	if (keyframe)
+		CL_XORRewindKeyframe(rewindsave, savesize);
+
 	rewind = (rewind_t *)malloc(sizeof (rewind_t));
 	if (!rewind)
 		return NULL;
 
-	P_SaveBufferFromExisting(&save, rewind->savebuffer, NETSAVEGAMESIZE);
-	P_SaveNetGame(&save, false);
+	packsize = lzf_compress(rewindsave, savesize, rewindpack, savesize - 1);
+	rewind->compressed = (packsize != 0);
+	if (!rewind->compressed)
+		packsize = savesize;
+
+	rewind->data = malloc(packsize);
+	if (!rewind->data)
+	{
+		free(rewind);
+		return NULL;
+	}
+
+	M_Memcpy(rewind->data, rewind->compressed ? rewindpack : rewindsave, packsize);
+	rewind->datasize = packsize;
+	rewind->savesize = savesize;
+	rewind->keyframe = keyframe;
+
+	// A new keyframe's save is already sitting in rewindsave.
+	if (!keyframe)
+	{
+		M_Memcpy(rewindkey, rewindsave, savesize);
+		rewindkeysize = savesize;
+		rewindkeyframe = rewind;
+	}
 
 	rewind->leveltime = leveltime;
 	rewind->next = rewindhead;
 	rewind->demopos = demopos;
 	rewindhead = rewind;
 
+	rewindmemory += sizeof (rewind_t) + packsize;
+	CL_TrimRewinds();
+
 	return rewind;
 }
 
@@ -6867,14 +7390,24 @@ rewind_t *CL_RewindToTime(tic_t time)
 	while (rewindhead && rewindhead->leveltime > time)
 	{
 		rewind = rewindhead->next;
-		free(rewindhead);
+		CL_FreeRewind(rewindhead);
 		rewindhead = rewind;
 	}
 
 	if (!rewindhead)
 		return NULL;
 
-	P_SaveBufferFromExisting(&save, rewindhead->savebuffer, NETSAVEGAMESIZE);
+	if (!CL_UnpackRewind(rewindhead, rewindsave)
+		|| (rewindhead->keyframe && !CL_LoadRewindKeyframe(rewindhead->keyframe)))
+	{
+		CL_ClearRewinds();
+		return NULL;
+	}
+
+	if (rewindhead->keyframe)
+		CL_XORRewindKeyframe(rewindsave, rewindhead->savesize);
+
+	P_SaveBufferFromExisting(&save, rewindsave, NETSAVEGAMESIZE);
 	P_LoadNetGame(&save, false);
 
 	wipegamestate = gamestate; // No fading back in!
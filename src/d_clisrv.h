@@ -34,7 +34,7 @@ The 'packet version' is used to distinguish packet formats.
 This version is independent of VERSION and SUBVERSION. Different
 applications may follow different packet versions.
 */
-#define PACKETVERSION 0
+#define PACKETVERSION 1
 
 // Network play related stuff.
 // There is a data struct that stores network
@@ -205,9 +205,14 @@ struct servertics_pak
 	UINT8 starttic;
 	UINT8 numtics;
 	UINT8 numslots; // "Slots filled": Highest player number in use plus one.
+	UINT8 flags; // SERVERTICS_ flags
 	ticcmd_t cmds[45]; // Normally [BACKUPTIC][MAXPLAYERS] but too large
 } ATTRPACK;
 
+// Each tic's ticcmds are written as changes from the tic before it
+// (from an empty ticcmd for the first tic) instead of in full.
+#define SERVERTICS_DELTA 1
+
 struct serverconfig_pak
 {
 	UINT8 version; // Different versions don't work
@@ -481,10 +486,12 @@ extern consvar_t cv_kicktime;
 
 extern consvar_t cv_showjoinaddress;
 extern consvar_t cv_playbackspeed;
+extern consvar_t cv_rewindmemory;
 
 #define BASEPACKETSIZE      offsetof(doomdata_t, u)
 #define FILETXHEADER        offsetof(filetx_pak, data)
 #define BASESERVERTICSSIZE  offsetof(doomdata_t, u.serverpak.cmds[0])
+#define MAXTICCMDPAKSIZE    20 // most bytes one ticcmd can take in a PT_SERVERTICS packet
 
 typedef enum
 {
@@ -556,6 +563,7 @@ extern consvar_t cv_mindelay;
 extern consvar_t cv_netticbuffer, cv_allownewplayer, cv_maxconnections, cv_joindelay;
 extern consvar_t cv_pingtimeout, cv_resynchattempts, cv_blamecfail;
 extern consvar_t cv_maxsend, cv_noticedownload, cv_downloadspeed;
+extern consvar_t cv_netdeltatics;
 
 #ifdef VANILLAJOINNEXTROUND
 extern consvar_t cv_joinnextround;
@@ -581,6 +589,7 @@ extern consvar_t cv_gamestochat;
 
 // Used in d_net, the only dependence
 tic_t ExpandTics(INT32 low, tic_t basetic);
+UINT8 *D_SkipTiccmdDeltas(UINT8 *p, const UINT8 *end, size_t count);
 void D_ClientServerInit(void);
 
 void GenerateChallenge(uint8_t *buf);
@@ -680,7 +689,14 @@ extern boolean hu_stopped;
 //
 
 struct rewind_t {
-	UINT8 savebuffer[NETSAVEGAMESIZE];
+	// Net save, LZF-compressed if that made it smaller. Points other
+	// than keyframes store it XORed against their keyframe's save.
+	UINT8 *data;
+	size_t datasize;
+	size_t savesize; // size before compression
+	boolean compressed;
+	rewind_t *keyframe; // NULL if this is a keyframe
+
 	tic_t leveltime;
 	size_t demopos;
 
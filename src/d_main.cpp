@@ -1867,7 +1867,8 @@ void D_SRB2Main(void)
 		digital_disabled = true;
 	}
 
-	if (M_CheckParm("-noaudio")) // combines -nosound and -nomusic
+	if (M_CheckParm("-noaudio") // combines -nosound and -nomusic
+		|| M_CheckParm("-simbench")) // the benchmark shouldn't wait on the mixer either
 	{
 		sound_disabled = true;
 		digital_disabled = true;
@@ -2005,6 +2006,8 @@ void D_SRB2Main(void)
 	p = M_CheckParm("-playdemo");
 	if (!p)
 		p = M_CheckParm("-timedemo");
+	if (!p)
+		p = M_CheckParm("-simbench");
 	if (p && M_IsNextParm())
 	{
 		char tmp[MAX_WADPATH];
@@ -2030,7 +2033,17 @@ void D_SRB2Main(void)
 			G_DeferedPlayDemo(tmp);
 		}
 		else
+		{
+			if (M_CheckParm("-simbench"))
+			{
+				// Headless timing run: simulate, write simbench.json and exit
+				demo.simbench = true;
+				timedemo_quit = true;
+				strlcpy(timedemo_name, tmp, sizeof(timedemo_name));
+			}
+
 			G_TimeDemo(tmp);
+		}
 
 		G_SetGamestate(GS_NULL);
 		wipegamestate = GS_NULL;
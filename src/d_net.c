@@ -76,6 +76,7 @@ boolean (*I_NetGet)(void) = NULL;
 void (*I_NetSend)(void) = NULL;
 boolean (*I_NetCanSend)(void) = NULL;
 boolean (*I_NetCanGet)(void) = NULL;
+void (*I_NetFlush)(void) = NULL;
 void (*I_NetCloseSocket)(void) = NULL;
 void (*I_NetFreeNodenum)(INT32 nodenum) = NULL;
 SINT8 (*I_NetMakeNodewPort)(const char *address, const char* port) = NULL;
@@ -844,8 +845,23 @@ static void DebugPrintpacket(const char *header)
 		case PT_SERVERTICS:
 		{
 			servertics_pak *serverpak = &netbuffer->u.serverpak;
-			UINT8 *cmd = (UINT8 *)(&serverpak->cmds[serverpak->numslots * serverpak->numtics]);
-			size_t ntxtcmd = &((UINT8 *)netbuffer)[doomcom->datalength] - cmd;
+			UINT8 *end = &((UINT8 *)netbuffer)[doomcom->datalength];
+			UINT8 *cmd;
+			size_t ntxtcmd;
+
+			if (serverpak->flags & SERVERTICS_DELTA)
+				cmd = D_SkipTiccmdDeltas((UINT8 *)serverpak->cmds, end, serverpak->numslots * serverpak->numtics);
+			else
+				cmd = (UINT8 *)(&serverpak->cmds[serverpak->numslots * serverpak->numtics]);
+
+			if (cmd == NULL || cmd > end)
+			{
+				fprintf(debugfile, "    firsttic %u ply %d tics %d truncated\n",
+					(UINT32)serverpak->starttic, serverpak->numslots, serverpak->numtics);
+				break;
+			}
+
+			ntxtcmd = end - cmd;
 
 			fprintf(debugfile, "    firsttic %u ply %d tics %d ntxtcmd %s\n",
 				(UINT32)serverpak->starttic, serverpak->numslots, serverpak->numtics, sizeu1(ntxtcmd));
@@ -1332,6 +1348,7 @@ boolean D_CheckNetGame(void)
 	I_NetGet = Internal_Get;
 	I_NetSend = Internal_Send;
 	I_NetCanSend = NULL;
+	I_NetFlush = NULL;
 	I_NetCloseSocket = NULL;
 	I_NetFreeNodenum = Internal_FreeNodenum;
 	I_NetMakeNodewPort = NULL;
@@ -1542,6 +1559,7 @@ void D_CloseConnection(void)
 		I_NetGet = Internal_Get;
 		I_NetSend = Internal_Send;
 		I_NetCanSend = NULL;
+		I_NetFlush = NULL;
 		I_NetCloseSocket = NULL;
 		I_NetFreeNodenum = Internal_FreeNodenum;
 		I_NetMakeNodewPort = NULL;
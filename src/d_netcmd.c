@@ -436,6 +436,7 @@ void D_RegisterServerCommands(void)
 	COM_AddDebugCommand("isgamemodified", Command_Isgamemodified_f); // test
 	COM_AddDebugCommand("showscores", Command_ShowScores_f);
 	COM_AddDebugCommand("showtime", Command_ShowTime_f);
+	COM_AddCommand("perfstats_report", Command_PerfstatsReport_f);
 #ifdef _DEBUG
 	COM_AddDebugCommand("togglemodified", Command_Togglemodified_f);
 	COM_AddDebugCommand("archivetest", Command_Archivetest_f);
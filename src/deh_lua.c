@@ -247,6 +247,9 @@ static int lib_dummysuper(lua_State *L)
 	return luaL_error(L, "Can't call super() outside of hardcode-replacing A_Action functions being called by state changes!"); // convoluted, I know. @_@;;
 }
 
+// INT_CONST by name, for lib_getenum in the main Lua state.
+static int int_const_ref = LUA_NOREF;
+
 static inline int lib_getenum(lua_State *L)
 {
 	const char *word, *p;
@@ -628,11 +631,24 @@ static inline int lib_getenum(lua_State *L)
 		return 0;
 	}
 
-	for (i = 0; INT_CONST[i].n; i++)
-		if (fastcmp(word,INT_CONST[i].n)) {
-			lua_pushinteger(L, INT_CONST[i].v);
+	if (!mathlib)
+	{
+		// O(1) by interned name, instead of scanning every constant
+		lua_rawgeti(L, LUA_REGISTRYINDEX, int_const_ref);
+		lua_pushvalue(L, 2);
+		lua_rawget(L, -2);
+		if (!lua_isnil(L, -1))
 			return 1;
-		}
+		lua_pop(L, 2);
+	}
+	else
+	{
+		for (i = 0; INT_CONST[i].n; i++)
+			if (fastcmp(word,INT_CONST[i].n)) {
+				lua_pushinteger(L, INT_CONST[i].v);
+				return 1;
+			}
+	}
 
 	if (mathlib) return luaL_error(L, "constant '%s' could not be parsed.\n", word);
 
@@ -647,6 +663,20 @@ int LUA_EnumLib(lua_State *L)
 	if (lua_gettop(L) == 0)
 		lua_pushboolean(L, 0);
 
+	// LUA_EvalMath makes a new state for every expression; don't make it build this.
+	if (!lua_toboolean(L, 1))
+	{
+		size_t i;
+
+		lua_newtable(L);
+		for (i = 0; INT_CONST[i].n; i++)
+		{
+			lua_pushinteger(L, INT_CONST[i].v);
+			lua_setfield(L, -2, INT_CONST[i].n);
+		}
+		int_const_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	}
+
 	// Set the global metatable
 	lua_createtable(L, 0, 1);
 	lua_pushvalue(L, 1); // boolean passed to LUA_EnumLib as first argument.
@@ -25,6 +25,12 @@ void I_FreeSfx(sfxinfo_t *sfx)
 	(void)sfx;
 }
 
+void I_PrecacheSfx(sfxinfo_t **sfx, size_t count)
+{
+	(void)sfx;
+	(void)count;
+}
+
 void I_StartupSound(void){}
 
 void I_ShutdownSound(void){}
@@ -14,6 +14,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <fstream>
 
 #include <tcb/span.hpp>
 #include <nlohmann/json.hpp>
@@ -61,6 +62,7 @@
 #include "k_battle.h"
 #include "k_respawn.h"
 #include "k_bot.h"
+#include "m_perfstats.h"
 #include "k_color.h"
 #include "k_follower.h"
 #include "k_vote.h"
@@ -3930,10 +3932,200 @@ fail:
 //
 static INT32 restorecv_vidwait;
 
+namespace
+{
+
+// Running totals for -simbench, in precise time units.
+struct SimBench
+{
+	UINT32 tics;
+	precise_t tic;
+	precise_t tic_max;
+	precise_t playerthink;
+	precise_t botticcmd;
+	bool bots_skipped;
+	precise_t thinkers;
+	precise_t thlist[NUM_ACTIVETHINKERLISTS];
+	precise_t acs;
+	precise_t lua_thinkframe;
+	UINT64 lua_mobjhooks;
+	UINT64 checkposition_calls;
+};
+
+SimBench g_simbench;
+
+template <typename T>
+void simbench_hash(UINT32& hash, T value)
+{
+	// FNV-1a, one byte at a time
+	const UINT8* p = reinterpret_cast<const UINT8*>(&value);
+	for (size_t i = 0; i < sizeof value; i++)
+	{
+		hash = (hash ^ p[i]) * 16777619u;
+	}
+}
+
+// Folds everything a desync would touch into one number, so two runs of
+// the same demo can be compared.
+UINT32 simbench_checksum(void)
+{
+	UINT32 hash = 2166136261u;
+	thinker_t *th;
+	INT32 i;
+
+	simbench_hash(hash, leveltime);
+
+	for (i = 0; i < PRNUMSYNCED; i++)
+	{
+		simbench_hash(hash, P_GetRandSeed(static_cast<pr_class_t>(i)));
+	}
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		if (!playeringame[i])
+			continue;
+
+		simbench_hash(hash, players[i].position);
+		simbench_hash(hash, players[i].laps);
+		simbench_hash(hash, players[i].distancetofinish);
+		simbench_hash(hash, players[i].itemtype);
+		simbench_hash(hash, players[i].itemamount);
+	}
+
+	if (gamestate != GS_LEVEL)
+		return hash;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+
+		const mobj_t *mo = (const mobj_t *)th;
+
+		simbench_hash(hash, mo->type);
+		simbench_hash(hash, mo->x);
+		simbench_hash(hash, mo->y);
+		simbench_hash(hash, mo->z);
+		simbench_hash(hash, mo->momx);
+		simbench_hash(hash, mo->momy);
+		simbench_hash(hash, mo->momz);
+		simbench_hash(hash, mo->angle);
+		simbench_hash(hash, mo->health);
+		simbench_hash(hash, (INT32)(mo->state ? mo->state - states : -1));
+	}
+
+	return hash;
+}
+
+double simbench_ms(precise_t t)
+{
+	return (double)t * 1000.0 / (double)I_GetPrecisePrecision();
+}
+
+void simbench_report(void)
+{
+	using json = nlohmann::json;
+
+	static const char *thlist_names[NUM_ACTIVETHINKERLISTS] = {"polyobj", "main", "mobj", "dynslope"};
+
+	const SimBench& b = g_simbench;
+	const double tics = std::max<UINT32>(b.tics, 1);
+
+	json thinkers = json::object();
+	for (INT32 i = 0; i < NUM_ACTIVETHINKERLISTS; i++)
+	{
+		thinkers[thlist_names[i]] = simbench_ms(b.thlist[i]) / tics;
+	}
+
+	json report = {
+		{"demo", timedemo_name},
+		{"tics", b.tics},
+		{"checksum", simbench_checksum()},
+		{"ms_per_tic", {
+			{"tic", simbench_ms(b.tic) / tics},
+			{"tic_max", simbench_ms(b.tic_max)},
+			{"playerthink", simbench_ms(b.playerthink) / tics},
+			{"bots", b.bots_skipped ? json(nullptr) : json(simbench_ms(b.botticcmd) / tics)},
+			{"thinkers", simbench_ms(b.thinkers) / tics},
+			{"thinker_lists", thinkers},
+			{"acs", simbench_ms(b.acs) / tics},
+			{"lua_thinkframe", simbench_ms(b.lua_thinkframe) / tics},
+		}},
+		{"per_tic", {
+			{"checkposition_calls", b.checkposition_calls / tics},
+			{"lua_mobjhooks", b.lua_mobjhooks / tics},
+		}},
+	};
+
+	const std::string path = va("%s" PATHSEP "%s", srb2home, "simbench.json");
+	std::ofstream out(path);
+
+	if (out)
+	{
+		out << report.dump(1, '\t') << '\n';
+		CONS_Printf("Simulation benchmark saved to '%s'\n", path.c_str());
+	}
+	else
+	{
+		CONS_Printf("%s\n", report.dump().c_str());
+	}
+}
+
+} // namespace
+
+// Called after every gametic while timing with -simbench.
+void G_SimBenchTic(void)
+{
+	// Paused tics, or ones that didn't run the level, have nothing new to add.
+	if (!demo.simbench || !demo.timing || gamestate != GS_LEVEL || !ps_ranthinkers)
+		return;
+
+	SimBench& b = g_simbench;
+
+	// The demo already holds the bots' ticcmds, so playback never builds
+	// them. Build them anyway into a row that's thrown away, so the bot AI
+	// is part of the run. This happens after the tic rather than before it
+	// like SV_Maketic, so it must not touch the simulation. The BotTiccmd
+	// hook can run any script, and kartdebugbots spawns prediction mobjs,
+	// so with either of those the bots go unmeasured for the whole run.
+	if (LUA_HookIsAvailable(HOOK(BotTiccmd)) || cv_kartdebugbots.value)
+	{
+		b.bots_skipped = true;
+	}
+
+	if (!b.bots_skipped)
+	{
+		static ticcmd_t botcmds[MAXPLAYERS];
+		PS_ResetBotInfo();
+		K_BuildBotTiccmds(botcmds);
+	}
+
+	b.tics++;
+	b.tic += ps_tictime;
+	b.tic_max = std::max(b.tic_max, ps_tictime);
+	b.playerthink += ps_playerthink_time;
+	b.botticcmd += ps_botticcmd_time;
+	b.thinkers += ps_thinkertime;
+	for (INT32 i = 0; i < NUM_ACTIVETHINKERLISTS; i++)
+	{
+		b.thlist[i] += ps_thlist_times[i];
+	}
+	b.acs += ps_acs_time;
+	b.lua_thinkframe += ps_lua_thinkframe_time;
+	b.lua_mobjhooks += ps_lua_mobjhooks;
+	b.checkposition_calls += ps_checkposition_calls;
+}
+
 void G_TimeDemo(const char *name)
 {
 	nodrawers = M_CheckParm("-nodraw");
 	noblit = M_CheckParm("-noblit");
+	if (demo.simbench)
+	{
+		// Only the simulation is being measured.
+		nodrawers = noblit = true;
+		g_simbench = {};
+	}
 	restorecv_vidwait = cv_vidwait.value;
 	if (cv_vidwait.value)
 		CV_Set(&cv_vidwait, "0");
@@ -3992,6 +4184,9 @@ static void G_StopTimingDemo(void)
 	CONS_Printf(M_GetText("timed %u gametics in %d realtics - %u frames\n%f seconds, %f avg fps\n"),
 		leveltime,demotime,(UINT32)framecount,f1/TICRATE,f2/f1);
 
+	if (demo.simbench)
+		simbench_report();
+
 	// CSV-readable timedemo results, for external parsing
 	if (timedemo_csv)
 	{
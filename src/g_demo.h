@@ -89,6 +89,7 @@ struct demovars_s {
 
 	boolean loadfiles, ignorefiles; // Demo file loading options
 	boolean quitafterplaying; // quit after playing a demo from cmdline
+	boolean simbench; // -simbench: time the simulation alone and write simbench.json
 	boolean deferstart; // don't start playing demo right away
 	boolean netgame; // multiplayer netgame
 	boolean waitingfortally; // demo ended but we're keeping the level open for the tally to finish
@@ -228,6 +229,7 @@ void G_DeferedPlayDemo(const char *demo);
 void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum);
 #define G_DoPlayDemo(defdemoname) G_DoPlayDemoEx(defdemoname, LUMPERROR)
 void G_TimeDemo(const char *name);
+void G_SimBenchTic(void);
 void G_AddGhost(savebuffer_t *buffer, const char *defdemoname);
 staffbrief_t *G_GetStaffGhostBrief(UINT8 *buffer);
 void G_FreeGhosts(void);
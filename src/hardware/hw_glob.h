@@ -98,7 +98,12 @@ typedef struct gl_vissprite_s
 	INT32 dispoffset; // copy of info->dispoffset, affects ordering but not drawing
 
 	patch_t *gpatch;
-	mobj_t *mobj; // NOTE: This is a precipmobj_t if precip is true !!! Watch out.
+	mobj_t *mobj; // NULL if precip is true
+
+	// precipitation drops aren't mobjs, so these stand in for them
+	sector_t *precipsector;
+	UINT32 precipframe;
+	fixed_t precipz; // interpolated
 } gl_vissprite_t;
 
 void HWR_ObjectLightLevelPost(gl_vissprite_t *spr, const sector_t *sector, INT32 *lightlevel, boolean model);
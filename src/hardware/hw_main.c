@@ -42,6 +42,7 @@
 #include "../r_things.h" // R_GetShadowZ
 #include "../d_main.h"
 #include "../p_slopes.h"
+#include "../p_precip.h"
 #include "hw_md2.h"
 
 // SRB2Kart
@@ -74,7 +75,7 @@ static void HWR_AddSprites(sector_t *sec);
 static void HWR_ProjectSprite(mobj_t *thing);
 #ifdef HWPRECIP
 static void HWR_AddPrecipitationSprites(void);
-static void HWR_ProjectPrecipitationSprite(precipmobj_t *thing);
+static void HWR_ProjectPrecipitationSprite(const precipcell_t *cell, size_t i);
 #endif
 static void HWR_ProjectBoundingBox(mobj_t *thing);
 static void HWR_RollTransform(FTransform *tr, angle_t roll);
@@ -3231,34 +3232,26 @@ static void HWR_DrawDropShadow(mobj_t *thing, fixed_t scale)
 static void HWR_RotateSpritePolyToAim(gl_vissprite_t *spr, FOutVector *wallVerts, const boolean precip)
 {
 	if (cv_glspritebillboarding.value
-		&& spr && spr->mobj && !R_ThingIsPaperSprite(spr->mobj)
-		&& wallVerts)
+		&& spr && wallVerts
+		&& (precip
+			? !(spr->precipframe & FF_PAPERSPRITE)
+			: (spr->mobj && !R_ThingIsPaperSprite(spr->mobj))))
 	{
 		// uncapped/interpolation
 		interpmobjstate_t interp = {0};
 
 		// do interpolation
-		if (R_UsingFrameInterpolation() && !paused)
+		if (precip)
 		{
-			if (spr->precip)
-			{
-				R_InterpolatePrecipMobjState((precipmobj_t *)spr->mobj, rendertimefrac, &interp);
-			}
-			else
-			{
-				R_InterpolateMobjState(spr->mobj, rendertimefrac, &interp);
-			}
+			interp.z = spr->precipz; // already interpolated
+		}
+		else if (R_UsingFrameInterpolation() && !paused)
+		{
+			R_InterpolateMobjState(spr->mobj, rendertimefrac, &interp);
 		}
 		else
 		{
-			if (spr->precip)
-			{
-				R_InterpolatePrecipMobjState((precipmobj_t *)spr->mobj, FRACUNIT, &interp);
-			}
-			else
-			{
-				R_InterpolateMobjState(spr->mobj, FRACUNIT, &interp);
-			}
+			R_InterpolateMobjState(spr->mobj, FRACUNIT, &interp);
 		}
 
 		float basey = FIXED_TO_FLOAT(interp.z);
@@ -3938,10 +3931,7 @@ static inline void HWR_DrawPrecipitationSprite(gl_vissprite_t *spr)
 	patch_t *gpatch;
 	FSurfaceInfo Surf;
 
-	if (!spr->mobj)
-		return;
-
-	if (!spr->mobj->subsector)
+	if (!spr->precipsector)
 		return;
 
 	// cache sprite graphics
@@ -3979,16 +3969,17 @@ static inline void HWR_DrawPrecipitationSprite(gl_vissprite_t *spr)
 
 	// colormap test
 	{
-		sector_t *sector = spr->mobj->subsector->sector;
+		sector_t *sector = spr->precipsector;
 		UINT8 lightlevel = 255;
 		extracolormap_t *colormap = sector->extra_colormap;
+		const boolean fullbright = ((spr->precipframe & FF_BRIGHTMASK) == FF_FULLBRIGHT);
 
 		if (sector->numlights)
 		{
 			// Always use the light at the top instead of whatever I was doing before
-			INT32 light = R_GetPlaneLight(sector, spr->mobj->z + spr->mobj->height, false);
+			INT32 light = R_GetPlaneLight(sector, spr->precipz + 4*FRACUNIT, false);
 
-			if (!R_ThingIsFullBright(spr->mobj))
+			if (!fullbright)
 				lightlevel = *sector->lightlist[light].lightlevel > 255 ? 255 : *sector->lightlist[light].lightlevel;
 
 			if (*sector->lightlist[light].extra_colormap)
@@ -3996,7 +3987,7 @@ static inline void HWR_DrawPrecipitationSprite(gl_vissprite_t *spr)
 		}
 		else
 		{
-			if (!R_ThingIsFullBright(spr->mobj))
+			if (!fullbright)
 				lightlevel = sector->lightlevel > 255 ? 255 : sector->lightlevel;
 
 			if (sector->extra_colormap)
@@ -4011,17 +4002,11 @@ static inline void HWR_DrawPrecipitationSprite(gl_vissprite_t *spr)
 	// Determine the blendmode and translucency value
 	{
 		UINT32 blendmode, trans;
-		if (spr->mobj->renderflags & RF_BLENDMASK)
-			blendmode = (spr->mobj->renderflags & RF_BLENDMASK) >> RF_BLENDSHIFT;
-		else
-			blendmode = (spr->mobj->frame & FF_BLENDMASK) >> FF_BLENDSHIFT;
+		blendmode = (spr->precipframe & FF_BLENDMASK) >> FF_BLENDSHIFT;
 		if (blendmode)
 			blendmode++; // realign to constants
 
-		if (spr->mobj->renderflags & RF_TRANSMASK)
-			trans = (spr->mobj->renderflags & RF_TRANSMASK) >> RF_TRANSSHIFT;
-		else
-			trans = (spr->mobj->frame & FF_TRANSMASK) >> FF_TRANSSHIFT;
+		trans = (spr->precipframe & FF_TRANSMASK) >> FF_TRANSSHIFT;
 		if (trans >= NUMTRANSMAPS)
 			return; // cap
 
@@ -4083,7 +4068,7 @@ static int CompareVisSprites(const void *p1, const void *p2)
 	if (spr1->bbox || spr2->bbox)
 		return 0;
 
-	// check for precip first, because then sprX->mobj is actually a precipmobj_t and does not have flags2 or tracer
+	// check for precip first, because then sprX->mobj is NULL
 	linkdraw1 = !spr1->precip && (spr1->mobj->flags2 & MF2_LINKDRAW) && spr1->mobj->tracer;
 	linkdraw2 = !spr2->precip && (spr2->mobj->flags2 & MF2_LINKDRAW) && spr2->mobj->tracer;
 
@@ -4121,10 +4106,10 @@ static int CompareVisSprites(const void *p1, const void *p2)
 	{
 		tz1 = spr1->tz;
 		renderflags1 = (spr1->precip ? 0 : spr1->mobj->renderflags);
-		frame1 = spr1->mobj->frame;
+		frame1 = (spr1->precip ? spr1->precipframe : spr1->mobj->frame);
 		tz2 = spr2->tz;
 		renderflags2 = (spr2->precip ? 0 : spr2->mobj->renderflags);
-		frame2 = spr2->mobj->frame;
+		frame2 = (spr2->precip ? spr2->precipframe : spr2->mobj->frame);
 	}
 
 	// first compare transparency flags, then compare tz, then compare dispoffset
@@ -4608,7 +4593,7 @@ static void HWR_AddPrecipitationSprites(void)
 	const fixed_t drawdist = cv_drawdist_precip.value * mapobjectscale;
 
 	INT32 xl, xh, yl, yh, bx, by;
-	precipmobj_t *th;
+	size_t i;
 
 	// no, no infinite draw distance for precipitation. this option at zero is supposed to turn it off
 	if (drawdist == 0)
@@ -4618,16 +4603,21 @@ static void HWR_AddPrecipitationSprites(void)
 
 	R_GetRenderBlockMapDimensions(drawdist, &xl, &xh, &yl, &yh);
 
+	// okay... this is a hack, but weather isn't networked, so it should be ok
+	P_ThinkPrecipitationBlocks(xl, xh, yl, yh);
+
 	for (bx = xl; bx <= xh; bx++)
 	{
 		for (by = yl; by <= yh; by++)
 		{
-			for (th = precipblocklinks[(by * bmapwidth) + bx]; th; th = th->bnext)
+			const precipcell_t *cell = &precipcells[(by * bmapwidth) + bx];
+
+			for (i = 0; i < cell->count; i++)
 			{
-				if (R_PrecipThingVisible(th))
-				{
-					HWR_ProjectPrecipitationSprite(th);
-				}
+				if (cell->flags[i] & PCF_INVISIBLE)
+					continue;
+
+				HWR_ProjectPrecipitationSprite(cell, i);
 			}
 		}
 	}
@@ -5140,7 +5130,7 @@ static void HWR_ProjectSprite(mobj_t *thing)
 
 #ifdef HWPRECIP
 // Precipitation projector for hardware mode
-static void HWR_ProjectPrecipitationSprite(precipmobj_t *thing)
+static void HWR_ProjectPrecipitationSprite(const precipcell_t *cell, size_t i)
 {
 	gl_vissprite_t *vis;
 	float tr_x, tr_y;
@@ -5155,26 +5145,20 @@ static void HWR_ProjectPrecipitationSprite(precipmobj_t *thing)
 	unsigned rot = 0;
 	UINT8 flip;
 
-	if (!thing)
-		return;
+	const spritenum_t sprite = states[cell->state[i]].sprite;
+	const UINT32 frame = cell->frame[i];
 
 	// uncapped/interpolation
 	interpmobjstate_t interp = {0};
 
-	// okay... this is a hack, but weather isn't networked, so it should be ok
-	if (!P_PrecipThinker(thing))
-	{
-		return;
-	}
-
 	// do interpolation
 	if (R_UsingFrameInterpolation() && !paused)
 	{
-		R_InterpolatePrecipMobjState(thing, rendertimefrac, &interp);
+		R_InterpolatePrecipDrop(cell, i, rendertimefrac, &interp);
 	}
 	else
 	{
-		R_InterpolatePrecipMobjState(thing, FRACUNIT, &interp);
+		R_InterpolatePrecipDrop(cell, i, FRACUNIT, &interp);
 	}
 
 	this_scale = FIXED_TO_FLOAT(interp.scale);
@@ -5194,23 +5178,23 @@ static void HWR_ProjectPrecipitationSprite(precipmobj_t *thing)
 	tr_y = FIXED_TO_FLOAT(interp.y);
 
 	// decide which patch to use for sprite relative to player
-	if ((unsigned)thing->sprite >= numsprites)
+	if ((unsigned)sprite >= numsprites)
 	{
 		CONS_Debug(DBG_RENDER, "HWR_ProjectPrecipitationSprite: invalid sprite number %i\n",
-		        thing->sprite);
+		        sprite);
 		return;
 	}
 
-	sprdef = &sprites[thing->sprite];
+	sprdef = &sprites[sprite];
 
-	if ((size_t)(thing->frame&FF_FRAMEMASK) >= sprdef->numframes)
+	if ((size_t)(frame&FF_FRAMEMASK) >= sprdef->numframes)
 	{
 		CONS_Debug(DBG_RENDER, "HWR_ProjectPrecipitationSprite: invalid sprite frame %i : %i for %s\n",
-		        thing->sprite, thing->frame, sprnames[thing->sprite]);
+		        sprite, frame, sprnames[sprite]);
 		return;
 	}
 
-	sprframe = &sprdef->spriteframes[ thing->frame & FF_FRAMEMASK];
+	sprframe = &sprdef->spriteframes[ frame & FF_FRAMEMASK];
 
 	// use single rotation for all views
 	lumpoff = sprframe->lumpid[0];
@@ -5249,11 +5233,14 @@ static void HWR_ProjectPrecipitationSprite(precipmobj_t *thing)
 	vis->dispoffset = 0; // Monster Iestyn: 23/11/15: HARDWARE SUPPORT AT LAST
 	vis->gpatch = (patch_t *)W_CachePatchNum(sprframe->lumppat[rot], PU_SPRITE);
 	vis->flip = flip;
-	vis->mobj = (mobj_t *)thing;
+	vis->mobj = NULL;
+	vis->precipsector = cell->sector[i];
+	vis->precipframe = frame;
+	vis->precipz = interp.z;
 
 	vis->colormap = NULL;
 
-	if (encoremap && !(thing->flags & MF_DONTENCOREMAP))
+	if (encoremap && !(mobjinfo[precipprops[curWeather].type].flags & MF_DONTENCOREMAP))
 		vis->colormap += COLORMAP_REMAPOFFSET;
 
 	// set top/bottom coords
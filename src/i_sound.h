@@ -48,6 +48,15 @@ void *I_GetSfx(sfxinfo_t *sfx);
 */
 void I_FreeSfx(sfxinfo_t *sfx);
 
+/**	\brief	The I_PrecacheSfx function
+
+	\param	sfx	sounds to set up, none of which have data yet
+	\param	count	number of sounds in sfx
+
+	\return	void, but every sound that loads gets its data set, as if by I_GetSfx
+*/
+void I_PrecacheSfx(sfxinfo_t **sfx, size_t count);
+
 /**	\brief Init at program start...
 */
 void I_StartupSound(void);
@@ -13,6 +13,10 @@
 ///        This is not really OS-dependent because all OSes have the same socket API.
 ///        Just use ifdef for OS-dependent parts.
 
+#if defined (__linux__) && !defined (_GNU_SOURCE)
+#define _GNU_SOURCE // recvmmsg, sendmmsg
+#endif
+
 #include "i_tcp_detail.h"
 #include "i_system.h"
 #include "i_time.h"
@@ -36,8 +40,19 @@
 
 #define SELECTTEST
 
+#if defined (__linux__) && !defined (NO_MMSG)
+#define USE_MMSG // move a whole batch of datagrams per system call
+#endif
+
 #define DEFAULTPORT "5029"
 
+/// \brief how many datagrams are received or sent in one go
+#define NET_BATCH 32
+
+/// \brief size of the address to node hash, a power of two
+#define NODEHASH_BITS 8
+#define NODEHASH_SIZE (1<<NODEHASH_BITS)
+
 #ifdef USE_WINSOCK
 	typedef SOCKET SOCKET_TYPE;
 	#define ERRSOCKET (SOCKET_ERROR)
@@ -55,6 +70,16 @@
 	typedef int socklen_t;
 #endif
 
+typedef struct
+{
+	char data[MAXPACKETLENGTH];
+	mysockaddr_t address;
+	socklen_t addrlen;
+	size_t length;
+	SOCKET_TYPE socket;
+	INT32 node; // for sends, -1 if errors can be ignored
+} datagram_t;
+
 typedef struct
 {
 	mysockaddr_t address;
@@ -72,6 +97,25 @@ mysockaddr_t clientaddress[MAXNETNODES+1];
 static mysockaddr_t broadcastaddress[MAXNETNODES+1];
 static size_t broadcastaddresses = 0;
 static boolean nodeconnected[MAXNETNODES+1];
+
+// Datagrams read from the sockets but not yet handed to HGetPacket,
+// and datagrams handed to SOCK_Send but not yet written.
+static datagram_t recvqueue[NET_BATCH];
+static size_t recvhead = 0, recvcount = 0;
+static size_t recvsocket = 0; // socket to read next, so none of them starve
+static datagram_t sendqueue[NET_BATCH];
+static size_t sendcount = 0;
+static INT32 cansend = -1; // select result for this batch, -1 if not asked yet
+
+// Chained hash of clientaddress, so incoming packets find their node without
+// comparing against every slot. Node 0 (self) is never hashed, so 0 ends a chain.
+#define NODE_UNHASHED 0
+#define NODE_HASHED 1
+#define NODE_WILDPORT 2 // no port, matches any; found by scanning instead
+static UINT8 nodehash[NODEHASH_SIZE];
+static UINT8 nodehashnext[MAXNETNODES+1];
+static UINT8 nodehashed[MAXNETNODES+1];
+static INT32 wildportnodes = 0;
 static const INT32 hole_punch_magic = MSBF_LONG (0x52eb11);
 
 static bannednode_t SOCK_bannednode[MAXNETNODES+1]; /// \note do we really need the +1?
@@ -309,13 +353,111 @@ boolean SOCK_cmpaddr(mysockaddr_t *a, mysockaddr_t *b, UINT8 mask)
 			&& (b->ip4.sin_port == 0 || (a->ip4.sin_port == b->ip4.sin_port));
 #ifdef HAVE_IPV6
 	else if (b->any.sa_family == AF_INET6)
-		return memcmp(&a->ip6.sin6_addr, &b->ip6.sin6_addr, sizeof(b->ip6.sin6_addr))
+		return !memcmp(&a->ip6.sin6_addr, &b->ip6.sin6_addr, sizeof(b->ip6.sin6_addr))
 			&& (b->ip6.sin6_port == 0 || (a->ip6.sin6_port == b->ip6.sin6_port));
 #endif
 	else
 		return false;
 }
 
+static UINT8 SOCK_HashAddr(const mysockaddr_t *sk)
+{
+	UINT32 h = 0;
+
+	if (sk->any.sa_family == AF_INET)
+		h = sk->ip4.sin_addr.s_addr ^ ((UINT32)sk->ip4.sin_port << 16);
+#ifdef HAVE_IPV6
+	else if (sk->any.sa_family == AF_INET6)
+	{
+		UINT32 w[4];
+		memcpy(w, &sk->ip6.sin6_addr, sizeof w);
+		h = w[0] ^ w[1] ^ w[2] ^ w[3] ^ ((UINT32)sk->ip6.sin6_port << 16);
+	}
+#endif
+
+	return (UINT8)((h * 2654435761u) >> (32 - NODEHASH_BITS));
+}
+
+static boolean SOCK_HasPort(const mysockaddr_t *sk)
+{
+#ifdef HAVE_IPV6
+	if (sk->any.sa_family == AF_INET6)
+		return sk->ip6.sin6_port != 0;
+#endif
+	return sk->ip4.sin_port != 0;
+}
+
+static void SOCK_UnhashNode(INT32 node)
+{
+	UINT8 *link;
+
+	if (nodehashed[node] == NODE_WILDPORT)
+		wildportnodes--;
+	else if (nodehashed[node] == NODE_HASHED)
+	{
+		link = &nodehash[SOCK_HashAddr(&clientaddress[node])];
+		while (*link != 0 && *link != node)
+			link = &nodehashnext[*link];
+		if (*link == node)
+			*link = nodehashnext[node];
+	}
+
+	nodehashed[node] = NODE_UNHASHED;
+}
+
+// Call after clientaddress[node] has been filled in.
+static void SOCK_HashNode(INT32 node)
+{
+	UINT8 h;
+
+	if (node <= 0 || node > MAXNETNODES)
+		return;
+
+	if (!SOCK_HasPort(&clientaddress[node]))
+	{
+		nodehashed[node] = NODE_WILDPORT;
+		wildportnodes++;
+		return;
+	}
+
+	h = SOCK_HashAddr(&clientaddress[node]);
+	nodehashnext[node] = nodehash[h];
+	nodehash[h] = (UINT8)node;
+	nodehashed[node] = NODE_HASHED;
+}
+
+static void SOCK_ClearNodeHash(void)
+{
+	memset(nodehash, 0, sizeof nodehash);
+	memset(nodehashnext, 0, sizeof nodehashnext);
+	memset(nodehashed, NODE_UNHASHED, sizeof nodehashed);
+	wildportnodes = 0;
+}
+
+// Returns the node a packet from this address belongs to, or 0 if there is none.
+static INT32 SOCK_FindNode(mysockaddr_t *sk)
+{
+	INT32 j, found = 0;
+
+	for (j = nodehash[SOCK_HashAddr(sk)]; j != 0; j = nodehashnext[j])
+	{
+		// Lowest node wins if an address is somehow listed twice.
+		if ((found == 0 || j < found) && SOCK_cmpaddr(sk, &clientaddress[j], 0))
+			found = j;
+	}
+
+	if (found == 0 && wildportnodes > 0)
+	{
+		for (j = 1; j <= MAXNETNODES; j++)
+		{
+			if (nodehashed[j] == NODE_WILDPORT && SOCK_cmpaddr(sk, &clientaddress[j], 0))
+				return j;
+		}
+	}
+
+	return found;
+}
+
 // This is a hack. For some reason, nodes aren't being freed properly.
 // This goes through and cleans up what nodes were supposed to be freed.
 /** \warning This function causes the file downloading to stop if someone joins.
@@ -420,63 +562,210 @@ static boolean hole_punch(ssize_t c)
 	}
 }
 
-// Returns true if a packet was received from a new node, false in all other cases
-static boolean SOCK_Get(void)
+static socklen_t SOCK_AddrLen(const mysockaddr_t *sockaddr)
 {
-	size_t n;
-	int j;
+	switch (sockaddr->any.sa_family)
+	{
+		case AF_INET:  return (socklen_t)sizeof(struct sockaddr_in);
+#ifdef HAVE_IPV6
+		case AF_INET6: return (socklen_t)sizeof(struct sockaddr_in6);
+#endif
+		default:       return (socklen_t)sizeof(mysockaddr_t);
+	}
+}
+
+// Refills recvqueue from the next socket that has anything waiting.
+static boolean SOCK_RecvBatch(void)
+{
+	size_t n, s;
+#ifdef USE_MMSG
+	struct mmsghdr msgs[NET_BATCH];
+	struct iovec iov[NET_BATCH];
+	size_t j;
+	int c;
+#else
 	ssize_t c;
-	mysockaddr_t fromaddress;
-	socklen_t fromlen;
+#endif
+
+	recvhead = recvcount = 0;
 
 	for (n = 0; n < mysocketses; n++)
 	{
-		fromlen = (socklen_t)sizeof(fromaddress);
-		c = recvfrom(mysockets[n], (char *)&doomcom->data, MAXPACKETLENGTH, 0,
-			(void *)&fromaddress, &fromlen);
+		s = (recvsocket + n) % mysocketses;
+
+#ifdef USE_MMSG
+		for (j = 0; j < NET_BATCH; j++)
+		{
+			iov[j].iov_base = recvqueue[j].data;
+			iov[j].iov_len = MAXPACKETLENGTH;
+			memset(&msgs[j], 0, sizeof msgs[j]);
+			msgs[j].msg_hdr.msg_name = &recvqueue[j].address;
+			msgs[j].msg_hdr.msg_namelen = (socklen_t)sizeof(mysockaddr_t);
+			msgs[j].msg_hdr.msg_iov = &iov[j];
+			msgs[j].msg_hdr.msg_iovlen = 1;
+		}
+
+		c = recvmmsg(mysockets[s], msgs, NET_BATCH, MSG_DONTWAIT, NULL);
+
+		for (j = 0; (int)j < c; j++)
+		{
+			recvqueue[j].length = msgs[j].msg_len;
+			recvqueue[j].addrlen = msgs[j].msg_hdr.msg_namelen;
+			recvqueue[j].socket = mysockets[s];
+		}
+
+		if (c > 0)
+			recvcount = (size_t)c;
+#else
+		recvqueue[0].addrlen = (socklen_t)sizeof(mysockaddr_t);
+		c = recvfrom(mysockets[s], recvqueue[0].data, MAXPACKETLENGTH, 0,
+			(void *)&recvqueue[0].address, &recvqueue[0].addrlen);
+
 		if (c > 0)
 		{
-#ifdef USE_STUN
-			if (STUN_got_response(doomcom->data, c))
-			{
-				break;
-			}
+			recvqueue[0].length = (size_t)c;
+			recvqueue[0].socket = mysockets[s];
+			recvcount = 1;
+		}
 #endif
 
-			if (hole_punch(c))
-			{
+		if (recvcount > 0)
+		{
+			recvsocket = (s + 1) % mysocketses;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void SOCK_SendFailed(const datagram_t *dg, int e)
+{
+	if (dg->node != -1 && e != ECONNREFUSED && e != EWOULDBLOCK)
+		I_Error("SOCK_Send, error sending to node %d (%s) #%u: %s", dg->node,
+			SOCK_AddrToStr((mysockaddr_t *)&dg->address), e, strerror(e));
+}
+
+// Writes out everything SOCK_Send has queued.
+static void SOCK_FlushSends(void)
+{
+	size_t i = 0;
+#ifdef USE_MMSG
+	struct mmsghdr msgs[NET_BATCH];
+	struct iovec iov[NET_BATCH];
+	size_t j, run;
+	int c;
+#endif
+
+	while (i < sendcount)
+	{
+#ifdef USE_MMSG
+		// sendmmsg takes a single socket, so each run of datagrams for the same socket goes together.
+		for (run = 1; i + run < sendcount && sendqueue[i + run].socket == sendqueue[i].socket; run++)
+			;
+
+		for (j = 0; j < run; j++)
+		{
+			datagram_t *dg = &sendqueue[i + j];
+
+			iov[j].iov_base = dg->data;
+			iov[j].iov_len = dg->length;
+			memset(&msgs[j], 0, sizeof msgs[j]);
+			msgs[j].msg_hdr.msg_name = &dg->address;
+			msgs[j].msg_hdr.msg_namelen = dg->addrlen;
+			msgs[j].msg_hdr.msg_iov = &iov[j];
+			msgs[j].msg_hdr.msg_iovlen = 1;
+		}
+
+		c = sendmmsg(sendqueue[i].socket, msgs, (unsigned int)run, 0);
+
+		if (c <= 0)
+		{
+			// The first datagram of the run failed; skip past it and try the rest.
+			if (c < 0)
+				SOCK_SendFailed(&sendqueue[i], errno);
+			i++;
+		}
+		else
+			i += (size_t)c;
+#else
+		if (sendto(sendqueue[i].socket, sendqueue[i].data, sendqueue[i].length, 0,
+			&sendqueue[i].address.any, sendqueue[i].addrlen) == ERRSOCKET)
+		{
+			SOCK_SendFailed(&sendqueue[i], errno);
+		}
+		i++;
+#endif
+	}
+
+	sendcount = 0;
+	cansend = -1;
+}
+
+// Returns true if a packet was received from a new node, false in all other cases
+static boolean SOCK_Get(void)
+{
+	datagram_t *dg;
+	INT32 j;
+
+	while (true)
+	{
+		if (recvhead == recvcount)
+		{
+			// Get anything we owe out of the door before asking for more.
+			SOCK_FlushSends();
+
+			if (!SOCK_RecvBatch())
 				break;
-			}
+		}
 
-			// find remote node number
-			for (j = 1; j <= MAXNETNODES; j++) //include LAN
-			{
-				if (SOCK_cmpaddr(&fromaddress, &clientaddress[j], 0))
-				{
-					doomcom->remotenode = (INT16)j; // good packet from a game player
-					doomcom->datalength = (INT16)c;
-					nodesocket[j] = mysockets[n];
-					return false;
-				}
-			}
-			// not found
+		dg = &recvqueue[recvhead++];
 
-			// find a free slot
-			j = getfreenode();
-			if (j > 0)
-			{
-				M_Memcpy(&clientaddress[j], &fromaddress, fromlen);
-				nodesocket[j] = mysockets[n];
-				DEBFILE(va("New node detected: node:%d address:%s\n", j,
-						SOCK_GetNodeAddress(j)));
-				doomcom->remotenode = (INT16)j; // good packet from a game player
-				doomcom->datalength = (INT16)c;
-
-				return true;
-			}
-			else
-				DEBFILE("New node detected: No more free slots\n");
+		if (dg->length == 0)
+			continue;
+
+		M_Memcpy(doomcom->data, dg->data, dg->length);
+
+#ifdef USE_STUN
+		if (STUN_got_response(doomcom->data, dg->length))
+		{
+			continue;
+		}
+#endif
+
+		if (hole_punch((ssize_t)dg->length))
+		{
+			continue;
 		}
+
+		// find remote node number
+		j = SOCK_FindNode(&dg->address);
+		if (j != 0)
+		{
+			doomcom->remotenode = (INT16)j; // good packet from a game player
+			doomcom->datalength = (INT16)dg->length;
+			nodesocket[j] = dg->socket;
+			return false;
+		}
+		// not found
+
+		// find a free slot
+		j = getfreenode();
+		if (j > 0)
+		{
+			SOCK_UnhashNode(j); // cleanupnodes may have left its old address behind
+			M_Memcpy(&clientaddress[j], &dg->address, dg->addrlen);
+			SOCK_HashNode(j);
+			nodesocket[j] = dg->socket;
+			DEBFILE(va("New node detected: node:%d address:%s\n", j,
+					SOCK_GetNodeAddress(j)));
+			doomcom->remotenode = (INT16)j; // good packet from a game player
+			doomcom->datalength = (INT16)dg->length;
+
+			return true;
+		}
+		else
+			DEBFILE("New node detected: No more free slots\n");
 	}
 
 	doomcom->remotenode = -1; // no packet
@@ -511,12 +800,17 @@ static boolean SOCK_CanSend(void)
 	fd_set tset;
 	int wselect;
 
+	// Sends go out in batches, so one look per batch is enough.
+	if (cansend != -1)
+		return (boolean)cansend;
+
+	cansend = false;
 	if(!FD_CPY(&masterset, &tset, mysockets, mysocketses))
 		return false;
 	wselect = select(255, NULL, &tset, NULL, &timeval_for_select);
 	if (wselect >= 1)
-		return true;
-	return false;
+		cansend = true;
+	return (boolean)cansend;
 }
 
 static boolean SOCK_CanGet(void)
@@ -525,6 +819,9 @@ static boolean SOCK_CanGet(void)
 	fd_set tset;
 	int rselect;
 
+	if (recvhead < recvcount)
+		return true;
+
 	if(!FD_CPY(&masterset, &tset, mysockets, mysocketses))
 		return false;
 	rselect = select(255, &tset, NULL, NULL, &timeval_for_select);
@@ -534,29 +831,25 @@ static boolean SOCK_CanGet(void)
 }
 #endif
 
-static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr)
+// Queues doomcom->data for sockaddr; node is -1 if a failure doesn't matter.
+static void SOCK_QueueSend(SOCKET_TYPE socket, mysockaddr_t *sockaddr, INT32 node)
 {
-	socklen_t d4 = (socklen_t)sizeof(struct sockaddr_in);
-#ifdef HAVE_IPV6
-	socklen_t d6 = (socklen_t)sizeof(struct sockaddr_in6);
-#endif
-	socklen_t d, da = (socklen_t)sizeof(mysockaddr_t);
-
-	switch (sockaddr->any.sa_family)
-	{
-		case AF_INET:  d = d4; break;
-#ifdef HAVE_IPV6
-		case AF_INET6: d = d6; break;
-#endif
-		default:       d = da; break;
-	}
-
-	return sendto(socket, (char *)&doomcom->data, doomcom->datalength, 0, &sockaddr->any, d);
+	datagram_t *dg;
+
+	if (sendcount == NET_BATCH)
+		SOCK_FlushSends();
+
+	dg = &sendqueue[sendcount++];
+	M_Memcpy(dg->data, doomcom->data, doomcom->datalength);
+	dg->length = (size_t)doomcom->datalength;
+	dg->address = *sockaddr;
+	dg->addrlen = SOCK_AddrLen(sockaddr);
+	dg->socket = socket;
+	dg->node = node;
 }
 
 static void SOCK_Send(void)
 {
-	ssize_t c = ERRSOCKET;
 	size_t i, j;
 
 	if (!nodeconnected[doomcom->remotenode])
@@ -569,31 +862,21 @@ static void SOCK_Send(void)
 			for (j = 0; j < broadcastaddresses; j++)
 			{
 				if (myfamily[i] == broadcastaddress[j].any.sa_family)
-					SOCK_SendToAddr(mysockets[i], &broadcastaddress[j]);
+					SOCK_QueueSend(mysockets[i], &broadcastaddress[j], -1);
 			}
 		}
-		return;
 	}
 	else if (nodesocket[doomcom->remotenode] == (SOCKET_TYPE)ERRSOCKET)
 	{
 		for (i = 0; i < mysocketses; i++)
 		{
 			if (myfamily[i] == clientaddress[doomcom->remotenode].any.sa_family)
-				SOCK_SendToAddr(mysockets[i], &clientaddress[doomcom->remotenode]);
+				SOCK_QueueSend(mysockets[i], &clientaddress[doomcom->remotenode], -1);
 		}
-		return;
 	}
 	else
 	{
-		c = SOCK_SendToAddr(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode]);
-	}
-
-	if (c == ERRSOCKET)
-	{
-		int e = errno; // save error code so it can't be modified later
-		if (e != ECONNREFUSED && e != EWOULDBLOCK)
-			I_Error("SOCK_Send, error sending to node %d (%s) #%u: %s", doomcom->remotenode,
-				SOCK_GetNodeAddress(doomcom->remotenode), e, strerror(e));
+		SOCK_QueueSend(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode], doomcom->remotenode);
 	}
 }
 
@@ -609,6 +892,7 @@ static void SOCK_FreeNodenum(INT32 numnode)
 	nodesocket[numnode] = ERRSOCKET;
 
 	// put invalid address
+	SOCK_UnhashNode(numnode);
 	memset(&clientaddress[numnode], 0, sizeof (clientaddress[numnode]));
 }
 
@@ -875,6 +1159,7 @@ static boolean UDP_Socket(void)
 		while (runp != NULL && s < MAXNETNODES+1)
 		{
 			memcpy(&clientaddress[s], runp->ai_addr, runp->ai_addrlen);
+			SOCK_HashNode(s); // skips node 0
 			s++;
 			runp = runp->ai_next;
 		}
@@ -1009,6 +1294,11 @@ boolean I_InitTcpDriver(void)
 static void SOCK_CloseSocket(void)
 {
 	size_t i;
+
+	SOCK_FlushSends();
+	recvhead = recvcount = 0;
+	recvsocket = 0;
+
 	for (i=0; i < MAXNETNODES+1; i++)
 	{
 		if (mysockets[i] != (SOCKET_TYPE)ERRSOCKET
@@ -1085,11 +1375,13 @@ static SINT8 SOCK_NetMakeNodewPort(const char *address, const char *port)
 
 	if (newnode != -1)
 	{
+		SOCK_UnhashNode(newnode);
 		if (!SOCK_GetAddr(&clientaddress[newnode].ip4, address, port, true))
 		{
 			nodeconnected[newnode] = false;
 			return -1;
 		}
+		SOCK_HashNode(newnode);
 	}
 
 	return newnode;
@@ -1152,6 +1444,7 @@ static boolean SOCK_OpenSocket(void)
 	size_t i;
 
 	memset(clientaddress, 0, sizeof (clientaddress));
+	SOCK_ClearNodeHash();
 
 	nodeconnected[0] = true; // always connected to self
 	for (i = 1; i < MAXNETNODES; i++)
@@ -1159,6 +1452,7 @@ static boolean SOCK_OpenSocket(void)
 	nodeconnected[BROADCASTADDR] = true;
 	I_NetSend = SOCK_Send;
 	I_NetGet = SOCK_Get;
+	I_NetFlush = SOCK_FlushSends;
 	I_NetCloseSocket = SOCK_CloseSocket;
 	I_NetFreeNodenum = SOCK_FreeNodenum;
 	I_NetMakeNodewPort = SOCK_NetMakeNodewPort;
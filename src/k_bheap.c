@@ -12,7 +12,6 @@
 
 #include "k_bheap.h"
 
-#include "z_zone.h"
 
 /*--------------------------------------------------
 	static boolean K_BHeapItemValidate(bheap_t *heap, bheapitem_t *item)
@@ -322,7 +321,7 @@ boolean K_BHeapInit(bheap_t *const heap, size_t initialcapacity)
 	}
 	else
 	{
-		heap->array = Z_Calloc(initialcapacity * sizeof(bheapitem_t), PU_STATIC, NULL);
+		heap->array = calloc(initialcapacity, sizeof(bheapitem_t));
 
 		if (heap->array == NULL)
 		{
@@ -394,7 +393,7 @@ boolean K_BHeapPush(bheap_t *const heap, void *const item, UINT32 value, updatei
 		if (heap->count >= heap->capacity)
 		{
 			size_t newarraycapacity = heap->capacity * 2;
-			heap->array = Z_Realloc(heap->array, newarraycapacity, PU_STATIC, NULL);
+			heap->array = realloc(heap->array, newarraycapacity * sizeof(bheapitem_t));
 
 			if (heap->array == NULL)
 			{
@@ -588,7 +587,7 @@ boolean K_BHeapFree(bheap_t *const heap)
 	}
 	else
 	{
-		Z_Free(heap->array);
+		free(heap->array);
 		heap->array    = NULL;
 		heap->capacity = 0U;
 		heap->count    = 0U;
@@ -45,9 +45,24 @@
 #include "discord.h" // DRPC_UpdatePresence
 #endif
 #include "i_net.h" // doomcom
+#include "core/thread_pool.h"
 
 extern "C" consvar_t cv_forcebots;
 
+// Scratch space each bot slot keeps between ticcmds, so that bots never share anything while
+// being built, whether that's on the main thread or the thread pool.
+struct BotScratch
+{
+	sightmarks_t *marks;
+	pathfindarena_t *arena;
+};
+
+static BotScratch g_botScratch[MAXPLAYERS];
+
+// Sight marks and pathfinding arena of the bot being built on this thread, only set by K_BuildBotTiccmds.
+static thread_local sightmarks_t *g_botSightMarks = nullptr;
+static thread_local pathfindarena_t *g_botPathfindArena = nullptr;
+
 /*--------------------------------------------------
 	void K_SetNameForBot(UINT8 playerNum, UINT8 skinnum)
 
@@ -971,7 +986,7 @@ static botprediction_t *K_CreateBotPrediction(const player_t *player)
 		return nullptr;
 	}
 
-	predict = static_cast<botprediction_t *>(Z_Calloc(sizeof(botprediction_t), PU_LEVEL, nullptr));
+	predict = static_cast<botprediction_t *>(calloc(1, sizeof(botprediction_t)));
 
 	// Init defaults in case of pathfind failure
 	angletonext = R_PointToAngle2(prevwpmobj->x, prevwpmobj->y, wp->mobj->x, wp->mobj->y);
@@ -979,10 +994,12 @@ static botprediction_t *K_CreateBotPrediction(const player_t *player)
 	nextslope = wp->mobj->standingslope;
 	distscaled = K_ScaleWPDistWithSlope(disttonext, angletonext, nextslope, P_MobjFlip(wp->mobj)) / FRACUNIT;
 
-	pathfindsuccess = K_PathfindThruCircuit(
+	// Each bot searches its own arena, so this can run alongside the other bots.
+	pathfindsuccess = K_PathfindThruCircuitOnArena(
 		wp, (unsigned)distanceleft,
 		&pathtofinish,
-		useshortcuts, huntbackwards
+		useshortcuts, huntbackwards,
+		g_botPathfindArena
 	);
 
 	// Go through the waypoints until we've traveled the distance we wanted to predict ahead!
@@ -1006,7 +1023,7 @@ static botprediction_t *K_CreateBotPrediction(const player_t *player)
 			nextslope = wp->mobj->standingslope;
 			distscaled = K_ScaleWPDistWithSlope(disttonext, angletonext, nextslope, P_MobjFlip(wp->mobj)) / FRACUNIT;
 
-			if (P_TraceBotTraversal(player->mo, wp->mobj) == false)
+			if (P_TraceBotTraversalMarked(player->mo, wp->mobj, K_BotSightMarks()) == false)
 			{
 				// If we can't get a direct path to this waypoint, reduce our prediction drastically.
 				distscaled *= 4;
@@ -1023,7 +1040,11 @@ static botprediction_t *K_CreateBotPrediction(const player_t *player)
 			}
 		}
 
-		Z_Free(pathtofinish.array);
+		if (g_botPathfindArena == nullptr)
+		{
+			// Not in K_BuildBotTiccmds, so this came from the shared arena.
+			Z_Free(pathtofinish.array);
+		}
 	}
 
 	// Set our predicted point's coordinates,
@@ -1696,7 +1717,7 @@ static void K_BuildBotTiccmdNormal(const player_t *player, ticcmd_t *cmd)
 	precise_t t = 0;
 
 	botprediction_t *predict = nullptr;
-	auto predict_finally = srb2::finally([&predict]() { Z_Free(predict); });
+	auto predict_finally = srb2::finally([&predict]() { free(predict); });
 
 	boolean trySpindash = true;
 	angle_t destangle = 0;
@@ -1756,7 +1777,7 @@ static void K_BuildBotTiccmdNormal(const player_t *player, ticcmd_t *cmd)
 		const fixed_t dist = DEFAULT_WAYPOINT_RADIUS * player->mo->scale;
 
 		// Overwritten prediction
-		predict = static_cast<botprediction_t *>(Z_Calloc(sizeof(botprediction_t), PU_STATIC, nullptr));
+		predict = static_cast<botprediction_t *>(calloc(1, sizeof(botprediction_t)));
 
 		predict->x = player->mo->x + FixedMul(dist, FINECOSINE(botController->forceAngle >> ANGLETOFINESHIFT));
 		predict->y = player->mo->y + FixedMul(dist, FINESINE(botController->forceAngle >> ANGLETOFINESHIFT));
@@ -2030,6 +2051,136 @@ void K_BuildBotTiccmd(
 	}
 }
 
+/*--------------------------------------------------
+	static boolean K_CanBuildBotTiccmdsInParallel(UINT8 numBots)
+
+		Checks if bot ticcmds can be built off the main thread.
+		Lua hooks and the prediction debug both need the main
+		thread, so they turn it off.
+
+	Input Arguments:-
+		numBots - How many bots need a ticcmd.
+
+	Return:-
+		true if it's safe and worth it, otherwise false.
+--------------------------------------------------*/
+static boolean K_CanBuildBotTiccmdsInParallel(UINT8 numBots)
+{
+	if (srb2::g_main_threadpool == nullptr || cv_parallelbots.value == 0)
+	{
+		return false;
+	}
+
+	if (numBots < 2)
+	{
+		return false;
+	}
+
+	if (LUA_HookIsAvailable(HOOK(BotTiccmd)) == true)
+	{
+		return false;
+	}
+
+	if (cv_kartdebugbots.value != 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/*--------------------------------------------------
+	void K_BuildBotTiccmds(ticcmd_t *cmds)
+
+		See header file for description.
+--------------------------------------------------*/
+void K_BuildBotTiccmds(ticcmd_t *cmds)
+{
+	ZoneScoped;
+
+	UINT8 bots[MAXPLAYERS];
+	UINT8 numBots = 0;
+	UINT8 i;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		BotScratch *scratch = &g_botScratch[i];
+
+		if (playeringame[i] && K_PlayerUsesBotMovement(&players[i]))
+		{
+			bots[numBots++] = i;
+
+			if (scratch->marks == nullptr)
+			{
+				scratch->marks = P_NewSightMarks();
+				scratch->arena = K_NewPathfindArena();
+			}
+
+			P_ClearSightCache(scratch->marks);
+		}
+		else if (scratch->marks != nullptr)
+		{
+			// No longer a bot, so give its scratch back.
+			P_FreeSightMarks(scratch->marks);
+			K_FreePathfindArena(scratch->arena);
+			scratch->marks = nullptr;
+			scratch->arena = nullptr;
+		}
+	}
+
+	// Both paths build each bot with its own scratch, so they give exactly the same ticcmds.
+	auto build = [cmds](UINT8 num) -> void
+	{
+		const precise_t t = I_GetPreciseTime();
+
+		g_botSightMarks = g_botScratch[num].marks;
+		g_botPathfindArena = g_botScratch[num].arena;
+		K_BuildBotTiccmd(&players[num], &cmds[num]);
+		g_botSightMarks = nullptr;
+		g_botPathfindArena = nullptr;
+
+		ps_bots[num].total = I_GetPreciseTime() - t;
+	};
+
+	if (K_CanBuildBotTiccmdsInParallel(numBots) == false)
+	{
+		for (i = 0; i < numBots; i++)
+		{
+			build(bots[i]);
+		}
+	}
+	else
+	{
+		srb2::g_main_threadpool->begin_sema();
+
+		for (i = 0; i < numBots; i++)
+		{
+			srb2::g_main_threadpool->schedule([build, num = bots[i]]() -> void { build(num); });
+		}
+
+		srb2::ThreadPool::Sema sema = srb2::g_main_threadpool->end_sema();
+		srb2::g_main_threadpool->notify_sema(sema);
+		srb2::g_main_threadpool->wait_sema(sema);
+	}
+
+	for (i = 0; i < numBots; i++)
+	{
+		ps_bots[bots[i]].isBot = true;
+		ps_botticcmd_time += ps_bots[bots[i]].total;
+		P_AddSightCacheStats(g_botScratch[bots[i]].marks);
+	}
+}
+
+/*--------------------------------------------------
+	sightmarks_t *K_BotSightMarks(void)
+
+		See header file for description.
+--------------------------------------------------*/
+sightmarks_t *K_BotSightMarks(void)
+{
+	return g_botSightMarks;
+}
+
 /*--------------------------------------------------
 	void K_UpdateBotGameplayVars(player_t *player);
 
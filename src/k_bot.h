@@ -26,6 +26,8 @@ extern "C" {
 	extern consvar_t cv_botcontrol;
 #endif
 
+extern consvar_t cv_parallelbots;
+
 // Maximum value of botvars.difficulty
 #define MAXBOTDIFFICULTY (13)
 
@@ -328,6 +330,40 @@ INT32 K_PositionBully(const player_t *player);
 void K_BuildBotTiccmd(player_t *player, ticcmd_t *cmd);
 
 
+/*--------------------------------------------------
+	void K_BuildBotTiccmds(ticcmd_t *cmds);
+
+		Creates the ticcmds of every bot in the game, and
+		fills in ps_bots for them. Bots are spread across
+		the thread pool when it is safe to do so.
+
+	Input Arguments:-
+		cmds - A full MAXPLAYERS row of ticcmds to modify.
+
+	Return:-
+		None
+--------------------------------------------------*/
+
+void K_BuildBotTiccmds(ticcmd_t *cmds);
+
+
+/*--------------------------------------------------
+	sightmarks_t *K_BotSightMarks(void);
+
+		Gets the sight marks for the bot being built on
+		this thread, for P_CheckSightMarked and friends.
+
+	Input Arguments:-
+		None
+
+	Return:-
+		The marks while K_BuildBotTiccmds is building
+		a bot, otherwise NULL.
+--------------------------------------------------*/
+
+sightmarks_t *K_BotSightMarks(void);
+
+
 /*--------------------------------------------------
 	void K_UpdateBotGameplayVarsItemUsage(player_t *player)
 
@@ -223,7 +223,7 @@ static player_t *K_PlayerInCone(const player_t *player, fixed_t radius, UINT16 c
 		if (target->mo == NULL || P_MobjWasRemoved(target->mo)
 			|| player == target || target->spectator
 			|| target->flashing
-			|| !P_CheckSight(player->mo, target->mo))
+			|| !P_CheckSightMarked(player->mo, target->mo, K_BotSightMarks()))
 		{
 			continue;
 		}
@@ -10144,12 +10144,11 @@ static void K_UpdateDistanceFromFinishLine(player_t *const player)
 		else if ((player->currentwaypoint != NULL) && (player->nextwaypoint != NULL) && (finishline != NULL))
 		{
 			const boolean useshortcuts = false;
-			const boolean huntbackwards = false;
 			boolean pathfindsuccess = false;
-			path_t pathtofinish = {0};
+			UINT32 disttofinish = 0;
 
 			pathfindsuccess =
-				K_PathfindToWaypoint(player->nextwaypoint, finishline, &pathtofinish, useshortcuts, huntbackwards);
+				K_GetWaypointDistanceToFinish(player->nextwaypoint, useshortcuts, &disttofinish);
 
 			// Update the player's distance to the finish line if a path was found.
 			// Using shortcuts won't find a path, so distance won't be updated until the player gets back on track
@@ -10276,9 +10275,9 @@ static void K_UpdateDistanceFromFinishLine(player_t *const player)
 
 				if (pathBackwardsReverse == false)
 				{
-					if (pathtofinish.totaldist > adddist)
+					if (disttofinish > adddist)
 					{
-						player->distancetofinish = pathtofinish.totaldist - adddist;
+						player->distancetofinish = disttofinish - adddist;
 					}
 					else
 					{
@@ -10287,9 +10286,8 @@ static void K_UpdateDistanceFromFinishLine(player_t *const player)
 				}
 				else
 				{
-					player->distancetofinish = pathtofinish.totaldist + adddist;
+					player->distancetofinish = disttofinish + adddist;
 				}
-				Z_Free(pathtofinish.array);
 
 				// distancetofinish is currently a flat distance to the finish line, but in order to be fully
 				// correct we need to add to it the length of the entire circuit multiplied by the number of laps
@@ -18,8 +18,38 @@
 
 static const size_t DEFAULT_NODEARRAY_CAPACITY = 8U;
 static const size_t DEFAULT_OPENSET_CAPACITY   = 8U;
-static const size_t DEFAULT_CLOSEDSET_CAPACITY = 8U;
 
+// Nodes are allocated in chunks of this many, so a node never moves once it has been created
+#define PATHFIND_NODECHUNK_SIZE (256U)
+
+// A slot in the node lookup table. Slots are only in use if their generation matches the arena's, so the
+// whole table is emptied between searches by bumping the generation.
+typedef struct
+{
+	void           *nodedata;
+	pathfindnode_t *node;
+	UINT32         generation;
+	boolean        closed;     // Whether the node has been evaluated and is in the closed set
+} pathfindslot_t;
+
+// Node state kept between searches, so pathfinding doesn't allocate anything once it has grown to fit the graph.
+// Everything in it is malloc'd rather than zone allocated, so a private arena can be searched off the main thread.
+struct pathfindarena_t
+{
+	pathfindnode_t **nodechunks;
+	size_t         numnodechunks;
+	size_t         nodescount;
+	pathfindslot_t *slots;
+	size_t         slotscapacity; // Always a power of 2
+	size_t         slotscount;
+	UINT32         generation;
+	bheap_t        openset;
+	pathfindnode_t *path;         // Returned paths for a private arena, reused by every search
+	size_t         pathcapacity;
+};
+
+// Used by every search that doesn't bring its own arena
+static pathfindarena_t sharedarena;
 
 /*--------------------------------------------------
 	static UINT32 K_NodeGetFScore(const pathfindnode_t *const node)
@@ -70,79 +100,225 @@ static void K_NodeUpdateHeapIndex(void *const node, const size_t newheapindex)
 }
 
 /*--------------------------------------------------
-	static pathfindnode_t *K_NodesArrayContainsNodeData(
-		pathfindnode_t *nodesarray,
-		void* nodedata,
-		size_t nodesarraycount)
+	static size_t K_PathfindHashNodeData(const pathfindarena_t *const arena, const void *const nodedata)
 
-		Checks whether the Nodes Array contains a node with a waypoint. Searches from the end to the start for speed
-			reasons.
+		Hashes a node's data pointer into the node lookup table.
 
 	Input Arguments:-
-		nodesarray      - The nodes array within the A* algorithm
-		waypoint        - The waypoint to check is within the nodes array
-		nodesarraycount - The current size of the nodes array
+		arena    - The arena being searched
+		nodedata - The node data to hash
 
 	Return:-
-		The pathfind node that has the waypoint if there is one. NULL if the waypoint is not in the nodes array.
+		The first slot index to check for the node data.
 --------------------------------------------------*/
-static pathfindnode_t *K_NodesArrayContainsNodeData(
-	pathfindnode_t *nodesarray,
-	void* nodedata,
-	size_t nodesarraycount)
+static size_t K_PathfindHashNodeData(const pathfindarena_t *const arena, const void *const nodedata)
 {
-	pathfindnode_t *foundnode = NULL;
+	// Fibonacci hashing, the low bits of the pointer are mostly alignment
+	const UINT64 hash = (UINT64)(uintptr_t)nodedata * UINT64_C(0x9E3779B97F4A7C15);
+
+	return (size_t)(hash >> 32) & (arena->slotscapacity - 1U);
+}
+
+/*--------------------------------------------------
+	static pathfindslot_t *K_PathfindFindSlot(pathfindarena_t *const arena, const void *const nodedata)
+
+		Finds the slot in the node lookup table that holds a node's data, or the
+		empty slot it would be placed into.
+
+	Input Arguments:-
+		arena    - The arena being searched
+		nodedata - The node data to look for
+
+	Return:-
+		The slot for the node data. Its generation only matches the arena's if the node data has been seen this search.
+--------------------------------------------------*/
+static pathfindslot_t *K_PathfindFindSlot(pathfindarena_t *const arena, const void *const nodedata)
+{
+	const size_t mask = arena->slotscapacity - 1U;
+	size_t i = K_PathfindHashNodeData(arena, nodedata);
+
+	while (arena->slots[i].generation == arena->generation
+		&& arena->slots[i].nodedata != nodedata)
+	{
+		i = (i + 1U) & mask;
+	}
+
+	return &arena->slots[i];
+}
+
+/*--------------------------------------------------
+	static void K_PathfindReserveSlots(pathfindarena_t *const arena, const size_t numnodes)
+
+		Makes sure the node lookup table has room for a number of nodes while
+		staying at most half full. Slots in use are moved over if it grows.
+
+	Input Arguments:-
+		arena    - The arena being searched
+		numnodes - The number of nodes that need to fit
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_PathfindReserveSlots(pathfindarena_t *const arena, const size_t numnodes)
+{
+	pathfindslot_t *oldslots = arena->slots;
+	const size_t oldcapacity = arena->slotscapacity;
+	size_t newcapacity = (oldcapacity > 0U) ? oldcapacity : 16U;
 	size_t i = 0U;
 
-	I_Assert(nodesarray != NULL);
-	I_Assert(nodedata != NULL);
+	while (newcapacity < numnodes * 2U)
+	{
+		newcapacity *= 2U;
+	}
+
+	if (newcapacity == oldcapacity)
+	{
+		return;
+	}
+
+	arena->slots = calloc(newcapacity, sizeof(pathfindslot_t));
+	if (arena->slots == NULL)
+	{
+		I_Error("K_PathfindReserveSlots: Out of memory.");
+	}
+	arena->slotscapacity = newcapacity;
+
+	if (oldslots != NULL)
+	{
+		for (i = 0U; i < oldcapacity; i++)
+		{
+			if (oldslots[i].generation == arena->generation)
+			{
+				*K_PathfindFindSlot(arena, oldslots[i].nodedata) = oldslots[i];
+			}
+		}
+
+		free(oldslots);
+	}
+}
+
+/*--------------------------------------------------
+	static void K_PathfindReserveNodes(pathfindarena_t *const arena, const size_t numnodes)
+
+		Makes sure there are enough node chunks allocated for a number of nodes.
+		Existing nodes never move.
+
+	Input Arguments:-
+		arena    - The arena being searched
+		numnodes - The number of nodes that need to fit
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_PathfindReserveNodes(pathfindarena_t *const arena, const size_t numnodes)
+{
+	const size_t numchunks = (numnodes + PATHFIND_NODECHUNK_SIZE - 1U) / PATHFIND_NODECHUNK_SIZE;
 
-	// It is more likely that we'll find the node we are looking for from the end of the array
-	// Yes, the for loop looks weird, remember that size_t is unsigned and we want to check 0, after it hits 0 it
-	// will loop back up to SIZE_MAX
-	for (i = nodesarraycount - 1U; i < nodesarraycount; i--)
+	if (numchunks <= arena->numnodechunks)
 	{
-		if (nodesarray[i].nodedata == nodedata)
+		return;
+	}
+
+	arena->nodechunks = realloc(arena->nodechunks, numchunks * sizeof(pathfindnode_t*));
+	if (arena->nodechunks == NULL)
+	{
+		I_Error("K_PathfindReserveNodes: Out of memory.");
+	}
+
+	while (arena->numnodechunks < numchunks)
+	{
+		pathfindnode_t *chunk = malloc(PATHFIND_NODECHUNK_SIZE * sizeof(pathfindnode_t));
+		if (chunk == NULL)
 		{
-			foundnode = &nodesarray[i];
-			break;
+			I_Error("K_PathfindReserveNodes: Out of memory.");
 		}
+
+		arena->nodechunks[arena->numnodechunks] = chunk;
+		arena->numnodechunks++;
 	}
-	return foundnode;
 }
 
 /*--------------------------------------------------
-	static boolean K_ClosedsetContainsNode(pathfindnode_t **closedset, pathfindnode_t *node, size_t closedsetcount)
+	static void K_PathfindBeginSearch(pathfindarena_t *const arena, pathfindsetup_t *const pathfindsetup)
 
-		Checks whether the Closedset contains a node. Searches from the end to the start for speed reasons.
+		Empties the arena for a new search and grows it to the capacities asked
+		for by the pathfinding setup.
 
 	Input Arguments:-
-		closedset      - The closed set within the A* algorithm
-		node           - The node to check is within the closed set
-		closedsetcount - The current size of the closedset
+		arena         - The arena to search
+		pathfindsetup - The setup for the pathfinding
 
 	Return:-
-		True if the node is in the closed set, false if it isn't
+		None
 --------------------------------------------------*/
-static boolean K_ClosedsetContainsNode(pathfindnode_t **closedset, pathfindnode_t *node, size_t closedsetcount)
+static void K_PathfindBeginSearch(pathfindarena_t *const arena, pathfindsetup_t *const pathfindsetup)
 {
-	boolean nodeisinclosedset = false;
 	size_t i = 0U;
 
-	I_Assert(closedset != NULL);
-	I_Assert(node != NULL);
-	// It is more likely that we'll find the node we are looking for from the end of the array
-	// Yes, the for loop looks weird, remember that size_t is unsigned and we want to check 0, after it hits 0 it
-	// will loop back up to SIZE_MAX
-	for (i = closedsetcount - 1U; i < closedsetcount; i--)
+	arena->generation++;
+	if (arena->generation == 0U)
 	{
-		if (closedset[i] == node)
+		// Wrapped around, clear out every stamp so nothing from 4 billion searches ago looks in use
+		for (i = 0U; i < arena->slotscapacity; i++)
 		{
-			nodeisinclosedset = true;
-			break;
+			arena->slots[i].generation = 0U;
 		}
+		arena->generation = 1U;
+	}
+
+	arena->nodescount = 0U;
+	arena->slotscount = 0U;
+
+	K_PathfindReserveNodes(arena, pathfindsetup->nodesarraycapacity);
+	K_PathfindReserveSlots(arena, pathfindsetup->nodesarraycapacity);
+
+	if (arena->openset.array == NULL)
+	{
+		K_BHeapInit(&arena->openset, pathfindsetup->opensetcapacity);
+	}
+	arena->openset.count = 0U;
+}
+
+/*--------------------------------------------------
+	static pathfindnode_t *K_PathfindNewNode(pathfindarena_t *const arena, pathfindslot_t *slot, void *const nodedata)
+
+		Creates a node for node data that hasn't been seen yet this search.
+
+	Input Arguments:-
+		arena    - The arena being searched
+		slot     - The empty slot from K_PathfindFindSlot for the node data
+		nodedata - The node data the node is for
+
+	Return:-
+		The new node, the caller must fill in the rest of it.
+--------------------------------------------------*/
+static pathfindnode_t *K_PathfindNewNode(pathfindarena_t *const arena, pathfindslot_t *slot, void *const nodedata)
+{
+	pathfindnode_t *newnode = NULL;
+
+	I_Assert(slot != NULL);
+	I_Assert(slot->generation != arena->generation);
+
+	if (arena->slotscount + 1U > arena->slotscapacity / 2U)
+	{
+		K_PathfindReserveSlots(arena, arena->slotscount + 1U);
+		slot = K_PathfindFindSlot(arena, nodedata);
 	}
-	return nodeisinclosedset;
+
+	K_PathfindReserveNodes(arena, arena->nodescount + 1U);
+
+	newnode = &arena->nodechunks[arena->nodescount / PATHFIND_NODECHUNK_SIZE]
+		[arena->nodescount % PATHFIND_NODECHUNK_SIZE];
+	newnode->nodedata = nodedata;
+	arena->nodescount++;
+
+	slot->nodedata   = nodedata;
+	slot->node       = newnode;
+	slot->generation = arena->generation;
+	slot->closed     = false;
+	arena->slotscount++;
+
+	return newnode;
 }
 
 /*--------------------------------------------------
@@ -218,7 +394,7 @@ static boolean K_PathfindSetupValid(const pathfindsetup_t *const pathfindsetup)
 	return pathfindsetupvalid;
 }
 
-static boolean K_ReconstructPath(path_t *const path, pathfindnode_t *const destinationnode)
+static boolean K_ReconstructPath(pathfindarena_t *const arena, path_t *const path, pathfindnode_t *const destinationnode)
 {
 	boolean reconstructsuccess = false;
 
@@ -230,7 +406,8 @@ static boolean K_ReconstructPath(path_t *const path, pathfindnode_t *const desti
 		pathfindnode_t *thisnode = destinationnode;
 
 		// If the path we're placing our new path into already has data, free it
-		if (path->array != NULL)
+		// (a private arena's paths are its own, so there's nothing to free)
+		if (path->array != NULL && arena == &sharedarena)
 		{
 			Z_Free(path->array);
 			path->numnodes = 0U;
@@ -246,8 +423,21 @@ static boolean K_ReconstructPath(path_t *const path, pathfindnode_t *const desti
 		if (numnodes > 0U)
 		{
 			// Allocate memory for the path
+			if (arena == &sharedarena)
+			{
+				path->array = Z_Calloc(numnodes * sizeof(pathfindnode_t), PU_STATIC, NULL);
+			}
+			else
+			{
+				if (numnodes > arena->pathcapacity)
+				{
+					free(arena->path);
+					arena->path = malloc(numnodes * sizeof(pathfindnode_t));
+					arena->pathcapacity = numnodes;
+				}
+				path->array = arena->path;
+			}
 			path->numnodes  = numnodes;
-			path->array     = Z_Calloc(numnodes * sizeof(pathfindnode_t), PU_STATIC, NULL);
 			path->totaldist = destinationnode->gscore;
 			if (path->array == NULL)
 			{
@@ -278,6 +468,54 @@ static boolean K_ReconstructPath(path_t *const path, pathfindnode_t *const desti
 	return reconstructsuccess;
 }
 
+/*--------------------------------------------------
+	pathfindarena_t *K_NewPathfindArena(void)
+
+		See header file for description.
+--------------------------------------------------*/
+pathfindarena_t *K_NewPathfindArena(void)
+{
+	pathfindarena_t *arena = calloc(1, sizeof(pathfindarena_t));
+
+	if (arena == NULL)
+	{
+		I_Error("K_NewPathfindArena: Out of memory.");
+	}
+
+	return arena;
+}
+
+/*--------------------------------------------------
+	void K_FreePathfindArena(pathfindarena_t *arena)
+
+		See header file for description.
+--------------------------------------------------*/
+void K_FreePathfindArena(pathfindarena_t *arena)
+{
+	size_t i = 0U;
+
+	if (arena == NULL || arena == &sharedarena)
+	{
+		return;
+	}
+
+	for (i = 0U; i < arena->numnodechunks; i++)
+	{
+		free(arena->nodechunks[i]);
+	}
+
+	free(arena->nodechunks);
+	free(arena->slots);
+	free(arena->path);
+
+	if (arena->openset.array != NULL)
+	{
+		K_BHeapFree(&arena->openset);
+	}
+
+	free(arena);
+}
+
 /*--------------------------------------------------
 	boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup)
 
@@ -286,6 +524,8 @@ static boolean K_ReconstructPath(path_t *const path, pathfindnode_t *const desti
 boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup)
 {
 	boolean pathfindsuccess = false;
+	pathfindarena_t *const arena = (pathfindsetup != NULL && pathfindsetup->arena != NULL)
+		? pathfindsetup->arena : &sharedarena;
 
 	if (path == NULL)
 	{
@@ -311,15 +551,14 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 		if (pathfindsetup->getfinished(&singlenode, pathfindsetup) == true)
 		{
 			// At the destination, return a simple 1 node path
-			K_ReconstructPath(path, &singlenode);
+			K_ReconstructPath(arena, path, &singlenode);
 			pathfindsuccess = true;
 		}
 		else
 		{
-			bheap_t        openset                 = {0};
+			bheap_t        *const openset          = &arena->openset;
 			bheapitem_t    poppedbheapitem         = {0};
-			pathfindnode_t *nodesarray             = NULL;
-			pathfindnode_t **closedset             = NULL;
+			pathfindslot_t *slot                   = NULL;
 			pathfindnode_t *newnode                = NULL;
 			pathfindnode_t *currentnode            = NULL;
 			pathfindnode_t *connectingnode         = NULL;
@@ -328,8 +567,6 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 			UINT32         *connectingnodecosts    = NULL;
 			size_t         numconnectingnodes      = 0U;
 			size_t         connectingnodeheapindex = 0U;
-			size_t         nodesarraycount         = 0U;
-			size_t         closedsetcount          = 0U;
 			size_t         i                       = 0U;
 			UINT32         tentativegscore         = 0U;
 
@@ -342,68 +579,34 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 			{
 				pathfindsetup->opensetcapacity = DEFAULT_OPENSET_CAPACITY;
 			}
-			if (pathfindsetup->closedsetcapacity == 0U)
-			{
-				pathfindsetup->closedsetcapacity = DEFAULT_CLOSEDSET_CAPACITY;
-			}
 
-			// Allocate the necessary memory
-			nodesarray = Z_Calloc(pathfindsetup->nodesarraycapacity * sizeof(pathfindnode_t), PU_STATIC, NULL);
-			if (nodesarray == NULL)
-			{
-				I_Error("K_PathfindAStar: Out of memory allocating nodes array.");
-			}
-			closedset = Z_Calloc(pathfindsetup->closedsetcapacity * sizeof(pathfindnode_t*), PU_STATIC, NULL);
-			if (closedset == NULL)
-			{
-				I_Error("K_PathfindAStar: Out of memory allocating closed set.");
-			}
-			K_BHeapInit(&openset, pathfindsetup->opensetcapacity);
+			K_PathfindBeginSearch(arena, pathfindsetup);
 
 			// Create the first node and add it to the open set
-			newnode            = &nodesarray[nodesarraycount];
+			slot               = K_PathfindFindSlot(arena, pathfindsetup->startnodedata);
+			newnode            = K_PathfindNewNode(arena, slot, pathfindsetup->startnodedata);
 			newnode->heapindex = SIZE_MAX;
-			newnode->nodedata  = pathfindsetup->startnodedata;
 			newnode->camefrom  = NULL;
 			newnode->gscore    = 0U;
 			newnode->hscore    = pathfindsetup->getheuristic(newnode->nodedata, pathfindsetup->endnodedata);
-			nodesarraycount++;
-			K_BHeapPush(&openset, newnode, K_NodeGetFScore(newnode), K_NodeUpdateHeapIndex);
-
-			// update openset capacity if it changed
-			if (openset.capacity != pathfindsetup->opensetcapacity)
-			{
-				pathfindsetup->opensetcapacity = openset.capacity;
-			}
+			K_BHeapPush(openset, newnode, K_NodeGetFScore(newnode), K_NodeUpdateHeapIndex);
 
 			// Go through each node in the openset, adding new ones from each node to it
 			// this continues until a path is found or there are no more nodes to check
-			while (openset.count > 0U)
+			while (openset->count > 0U)
 			{
 				// pop the best node off of the openset
-				K_BHeapPop(&openset, &poppedbheapitem);
+				K_BHeapPop(openset, &poppedbheapitem);
 				currentnode = (pathfindnode_t*)poppedbheapitem.data;
 
 				if (pathfindsetup->getfinished(currentnode, pathfindsetup) == true)
 				{
-					pathfindsuccess = K_ReconstructPath(path, currentnode);
+					pathfindsuccess = K_ReconstructPath(arena, path, currentnode);
 					break;
 				}
 
 				// Place the node we just popped into the closed set, as we are now evaluating it
-				if (closedsetcount >= pathfindsetup->closedsetcapacity)
-				{
-					// Need to reallocate closedset to fit another node
-					pathfindsetup->closedsetcapacity = pathfindsetup->closedsetcapacity * 2;
-					closedset =
-						Z_Realloc(closedset, pathfindsetup->closedsetcapacity * sizeof(pathfindnode_t*), PU_STATIC, NULL);
-					if (closedset == NULL)
-					{
-						I_Error("K_PathfindAStar: Out of memory reallocating closed set.");
-					}
-				}
-				closedset[closedsetcount] = currentnode;
-				closedsetcount++;
+				K_PathfindFindSlot(arena, currentnode->nodedata)->closed = true;
 
 				// Get the needed data for the next nodes from the current node
 				connectingnodesdata = pathfindsetup->getconnectednodes(currentnode->nodedata, &numconnectingnodes);
@@ -440,14 +643,16 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 							// Figure out what the gscore of this route for the connecting node is
 							tentativegscore = currentnode->gscore + connectingnodecosts[i];
 
-							// find this data in the nodes array if it's been generated before
-							connectingnode = K_NodesArrayContainsNodeData(nodesarray, checknodedata, nodesarraycount);
+							// find this data in the arena if it's been generated before
+							slot = K_PathfindFindSlot(arena, checknodedata);
 
-							if (connectingnode != NULL)
+							if (slot->generation == arena->generation)
 							{
 								// The connecting node has been seen before, so it must be in either the closedset (skip it)
 								// or the openset (re-evaluate it's gscore)
-								if (K_ClosedsetContainsNode(closedset, connectingnode, closedsetcount) == true)
+								connectingnode = slot->node;
+
+								if (slot->closed == true)
 								{
 									continue;
 								}
@@ -458,11 +663,11 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 									connectingnode->camefrom = currentnode;
 
 									connectingnodeheapindex =
-										K_BHeapContains(&openset, connectingnode, connectingnode->heapindex);
+										K_BHeapContains(openset, connectingnode, connectingnode->heapindex);
 									if (connectingnodeheapindex != SIZE_MAX)
 									{
 										K_UpdateBHeapItemValue(
-											&openset.array[connectingnodeheapindex], K_NodeGetFScore(connectingnode));
+											&openset->array[connectingnodeheapindex], K_NodeGetFScore(connectingnode));
 									}
 									else
 									{
@@ -474,68 +679,23 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 							else
 							{
 								// Node is not created yet, so it hasn't been seen so far
-								// Reallocate nodesarray if it's full
-								if (nodesarraycount >= pathfindsetup->nodesarraycapacity)
-								{
-									pathfindnode_t *nodesarrayrealloc = NULL;
-									pathfindsetup->nodesarraycapacity = pathfindsetup->nodesarraycapacity * 2;
-									nodesarrayrealloc = Z_Realloc(nodesarray, pathfindsetup->nodesarraycapacity * sizeof(pathfindnode_t), PU_STATIC, NULL);
-
-									if (nodesarrayrealloc == NULL)
-									{
-										I_Error("K_PathfindAStar: Out of memory reallocating nodes array.");
-									}
-
-									// Need to update pointers in closedset, openset, and node "camefrom" if nodesarray moved.
-									if (nodesarray != nodesarrayrealloc)
-									{
-										size_t j = 0U;
-										size_t arrayindex = 0U;
-										for (j = 0U; j < closedsetcount; j++)
-										{
-											arrayindex = closedset[j] - nodesarray;
-											closedset[j] = &nodesarrayrealloc[arrayindex];
-										}
-										for (j = 0U; j < openset.count; j++)
-										{
-											arrayindex = ((pathfindnode_t *)(openset.array[j].data)) - nodesarray;
-											openset.array[j].data = &nodesarrayrealloc[arrayindex];
-										}
-										for (j = 0U; j < nodesarraycount; j++)
-										{
-											if (nodesarrayrealloc[j].camefrom != NULL)
-											{
-												arrayindex = nodesarrayrealloc[j].camefrom - nodesarray;
-												nodesarrayrealloc[j].camefrom = &nodesarrayrealloc[arrayindex];
-											}
-										}
-
-										arrayindex = currentnode - nodesarray;
-										currentnode = &nodesarrayrealloc[arrayindex];
-									}
-
-									nodesarray = nodesarrayrealloc;
-								}
-
-								// Create the new node and add it to the nodes array and open set
-								newnode            = &nodesarray[nodesarraycount];
+								// Create the new node and add it to the arena and open set
+								newnode            = K_PathfindNewNode(arena, slot, checknodedata);
 								newnode->heapindex = SIZE_MAX;
-								newnode->nodedata  = checknodedata;
 								newnode->camefrom  = currentnode;
 								newnode->gscore    = tentativegscore;
 								newnode->hscore    = pathfindsetup->getheuristic(newnode->nodedata, pathfindsetup->endnodedata);
-								nodesarraycount++;
-								K_BHeapPush(&openset, newnode, K_NodeGetFScore(newnode), K_NodeUpdateHeapIndex);
+								K_BHeapPush(openset, newnode, K_NodeGetFScore(newnode), K_NodeUpdateHeapIndex);
 							}
 						}
 					}
 				}
 			}
 
-			// Clean up the memory
-			K_BHeapFree(&openset);
-			Z_Free(closedset);
-			Z_Free(nodesarray);
+			// Report back how big the arena has grown, so the caller can ask for enough up front next time
+			pathfindsetup->opensetcapacity    = openset->capacity;
+			pathfindsetup->nodesarraycapacity = arena->numnodechunks * PATHFIND_NODECHUNK_SIZE;
+			pathfindsetup->closedsetcapacity  = pathfindsetup->nodesarraycapacity;
 		}
 	}
 
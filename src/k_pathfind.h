@@ -59,6 +59,7 @@ struct path_t {
 // should be setup by the caller before starting pathfinding
 // base capacities will be 8 if they aren't setup, missing callback functions will cause an error.
 // Can be accessed after the pathfinding is complete to get the final capacities of them
+// The node storage is kept between searches, so the capacities only ever grow it
 struct pathfindsetup_t {
 	size_t opensetcapacity;
 	size_t closedsetcapacity;
@@ -71,13 +72,48 @@ struct pathfindsetup_t {
 	getnodeheuristicfunc getheuristic;
 	getnodetraversablefunc gettraversable;
 	getpathfindfinishedfunc getfinished;
+	pathfindarena_t *arena;    // NULL to use the shared arena, which only the main thread may search
 };
 
 
+/*--------------------------------------------------
+	pathfindarena_t *K_NewPathfindArena(void);
+
+		Creates an arena of node state for searches of its own. Searches on different arenas can run on
+		different threads at the same time. A path found on a private arena is owned by the arena: it stays
+		valid until the arena's next search, and must not be freed.
+
+	Input Arguments:-
+		None
+
+	Return:-
+		The new arena, for pathfindsetup_t's arena.
+--------------------------------------------------*/
+
+pathfindarena_t *K_NewPathfindArena(void);
+
+
+/*--------------------------------------------------
+	void K_FreePathfindArena(pathfindarena_t *arena);
+
+		Frees an arena from K_NewPathfindArena, and every path found on it.
+
+	Input Arguments:-
+		arena - The arena to free, may be NULL
+
+	Return:-
+		None
+--------------------------------------------------*/
+
+void K_FreePathfindArena(pathfindarena_t *arena);
+
+
 /*--------------------------------------------------
 	boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup);
 
 		From a source waypoint and destination waypoint, find the best path between them using the A* algorithm.
+		Node state is kept in an arena that is reused by every search on it, so this is not reentrant. Searches with
+		no arena of their own share one.
 
 	Input Arguments:-
 		path          - The return location of the found path
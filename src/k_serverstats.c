@@ -26,6 +26,20 @@ static size_t numtracked = 0;
 static size_t numallocated = 0;
 static boolean initialized = false;
 
+// Open addressing over trackedList, keyed on the whole public key.
+// Slots hold a trackedList index + 1, so 0 is empty.
+static UINT32 *statsindex;
+static size_t indexsize = 0; // power of 2, at least twice numtracked
+
+// Records appended to the journal since the last full save
+static size_t journalrecords = 0;
+
+// Rewrite the whole stats file once the journal holds more
+// records than this, or than there are tracked players.
+#define SERVERSTATSCOMPACTMIN 4096
+
+#define SERVERSTATSRECORDSIZE (PUBKEYLENGTH + sizeof(UINT32) + (PWRLV_NUMTYPES * sizeof(UINT16)) + sizeof(UINT32))
+
 UINT16 guestpwr[PWRLV_NUMTYPES]; // All-zero power level to reference for guests
 
 static void SV_InitializeStats(void)
@@ -70,23 +84,239 @@ static void SV_ExpandStats(size_t needed)
 
 }
 
+static UINT32 SV_KeyIndexHash(const uint8_t *key)
+{
+	// FNV-1a over every byte; the record hash stops at the first zero.
+	UINT32 x = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < PUBKEYLENGTH; i++)
+	{
+		x = (x ^ key[i]) * 16777619u;
+	}
+
+	return x;
+}
+
+static void SV_IndexInsert(size_t num)
+{
+	size_t slot = SV_KeyIndexHash(trackedList[num].public_key) & (indexsize - 1);
+
+	while (statsindex[slot] != 0)
+	{
+		slot = (slot + 1) & (indexsize - 1);
+	}
+
+	statsindex[slot] = num + 1;
+}
+
+// Grow the index when needed, and rebuild it from trackedList
+static void SV_RebuildIndex(size_t needed)
+{
+	size_t newsize = (indexsize ? indexsize : 64);
+	size_t i;
+
+	while (newsize < needed * 2)
+	{
+		newsize *= 2;
+	}
+
+	if (newsize != indexsize)
+	{
+		Z_Free(statsindex);
+		indexsize = newsize;
+		statsindex = Z_Malloc(sizeof(*statsindex) * indexsize, PU_STATIC, NULL);
+	}
+
+	memset(statsindex, 0, sizeof(*statsindex) * indexsize);
+
+	for (i = 0; i < numtracked; i++)
+	{
+		SV_IndexInsert(i);
+	}
+}
+
+static serverplayer_t *SV_FindStats(const uint8_t *key)
+{
+	size_t slot;
+
+	if (indexsize == 0)
+		return NULL;
+
+	slot = SV_KeyIndexHash(key) & (indexsize - 1);
+
+	while (statsindex[slot] != 0)
+	{
+		serverplayer_t *stat = &trackedList[statsindex[slot] - 1];
+
+		if (memcmp(stat->public_key, key, PUBKEYLENGTH) == 0)
+			return stat;
+
+		slot = (slot + 1) & (indexsize - 1);
+	}
+
+	return NULL;
+}
+
+static serverplayer_t *SV_AddStats(const uint8_t *key)
+{
+	serverplayer_t *stat;
+
+	SV_ExpandStats(numtracked+1);
+
+	stat = &trackedList[numtracked];
+	memset(stat, 0, sizeof(*stat));
+	memcpy(stat->public_key, key, PUBKEYLENGTH);
+	stat->hash = quickncasehash((const char*)key, PUBKEYLENGTH);
+
+	numtracked++;
+
+	if (numtracked * 2 > indexsize)
+		SV_RebuildIndex(numtracked);
+	else
+		SV_IndexInsert(numtracked - 1);
+
+	return stat;
+}
+
+static void SV_ReadStatsRecord(UINT8 **p, serverplayer_t *stat, UINT8 version)
+{
+	unsigned int j;
+
+	READMEM(*p, &stat->lastseen, sizeof(stat->lastseen));
+	for(j = 0; j < PWRLV_NUMTYPES; j++)
+	{
+		stat->powerlevels[j] = READUINT16(*p);
+	}
+
+	// Migration 1 -> 2: Add finishedrounds
+	if (version < 2)
+		stat->finishedrounds = 0;
+	else
+		stat->finishedrounds = READUINT32(*p);
+}
+
+static void SV_WriteStatsRecord(UINT8 **p, const serverplayer_t *stat)
+{
+	unsigned int j;
+
+	WRITEMEM(*p, stat->public_key, PUBKEYLENGTH);
+	WRITEMEM(*p, &stat->lastseen, sizeof(stat->lastseen));
+	for(j = 0; j < PWRLV_NUMTYPES; j++)
+	{
+		WRITEUINT16(*p, stat->powerlevels[j]);
+	}
+	WRITEUINT32(*p, stat->finishedrounds);
+}
+
+// Apply records written since the last full save. Later records replace earlier ones.
+static void SV_ReplayJournal(void)
+{
+	const size_t headerlen = strlen(SERVERSTATSJOURNALHEADER);
+	savebuffer_t save = {0};
+	uint8_t key[PUBKEYLENGTH];
+
+	if (P_SaveBufferFromFile(&save, va(pandf, srb2home, SERVERSTATSJOURNAL)) == false)
+	{
+		return;
+	}
+
+	if (save.size < headerlen + 1 || strncmp(SERVERSTATSJOURNALHEADER, (const char *)save.buffer, headerlen))
+	{
+		// Not ours, or cut off before the header. Nothing in it can be trusted.
+		CONS_Alert(CONS_WARNING, "Ignoring invalid %s\n", SERVERSTATSJOURNAL);
+		P_SaveBufferFree(&save);
+		return;
+	}
+
+	save.p += headerlen;
+	UINT8 version = READUINT8(save.p);
+	if (version > SERVERSTATSVER)
+	{
+		P_SaveBufferFree(&save);
+		I_Error("Existing %s is from the future! (expected %d, got %d)", SERVERSTATSJOURNAL, SERVERSTATSVER, version);
+	}
+
+	// A record cut short by a crash mid-write is dropped.
+	while ((size_t)(save.p - save.buffer) + SERVERSTATSRECORDSIZE <= save.size)
+	{
+		serverplayer_t *stat;
+
+		READMEM(save.p, key, PUBKEYLENGTH);
+
+		stat = SV_FindStats(key);
+		if (stat == NULL)
+			stat = SV_AddStats(key);
+
+		SV_ReadStatsRecord(&save.p, stat, version);
+		journalrecords++;
+	}
+
+	P_SaveBufferFree(&save);
+}
+
+// Append every changed record to the journal
+static void SV_FlushStats(void)
+{
+	const size_t headerlen = strlen(SERVERSTATSJOURNALHEADER);
+	const char *path = va(pandf, srb2home, SERVERSTATSJOURNAL);
+	UINT8 buf[SERVERSTATSRECORDSIZE];
+	boolean fresh = !FIL_FileExists(path);
+	FILE *f = NULL;
+	size_t i;
+
+	for (i = 0; i < numtracked; i++)
+	{
+		UINT8 *p = buf;
+
+		if (!trackedList[i].dirty)
+			continue;
+
+		if (f == NULL)
+		{
+			f = fopen(path, "ab");
+			if (f == NULL)
+			{
+				I_Error("Couldn't save server stats. Are you out of disk space / playing in a protected folder?");
+				return;
+			}
+
+			if (fresh)
+			{
+				fwrite(SERVERSTATSJOURNALHEADER, 1, headerlen, f);
+				fputc(SERVERSTATSVER, f);
+			}
+		}
+
+		SV_WriteStatsRecord(&p, &trackedList[i]);
+		fwrite(buf, 1, p - buf, f);
+
+		trackedList[i].dirty = false;
+		journalrecords++;
+	}
+
+	if (f != NULL)
+		fclose(f);
+}
+
 // Read stats file to trackedList for ingame use
 void SV_LoadStats(void)
 {
 	const size_t headerlen = strlen(SERVERSTATSHEADER);
 	savebuffer_t save = {0};
-	unsigned int i, j;
+	unsigned int i;
 
 	if (!server)
 		return;
 
+	SV_InitializeStats();
+
 	if (P_SaveBufferFromFile(&save, va(pandf, srb2home, SERVERSTATSFILE)) == false)
 	{
+		SV_ReplayJournal();
 		return;
 	}
 
-	SV_InitializeStats();
-
 	if (strncmp(SERVERSTATSHEADER, (const char *)save.buffer, headerlen))
 	{
 		const char *gdfolder = "the Ring Racers folder";
@@ -117,20 +347,17 @@ void SV_LoadStats(void)
 	for(i = 0; i < numtracked; i++)
 	{
 		READMEM(save.p, trackedList[i].public_key, PUBKEYLENGTH);
-		READMEM(save.p, &trackedList[i].lastseen, sizeof(trackedList[i].lastseen));
-		for(j = 0; j < PWRLV_NUMTYPES; j++)
-		{
-			trackedList[i].powerlevels[j] = READUINT16(save.p);
-		}
-
-		// Migration 1 -> 2: Add finishedrounds
-		if (version < 2)
-			trackedList[i].finishedrounds = 0;
-		else
-			trackedList[i].finishedrounds = READUINT32(save.p);
+		SV_ReadStatsRecord(&save.p, &trackedList[i], version);
 
 		trackedList[i].hash = quickncasehash((char*)trackedList[i].public_key, PUBKEYLENGTH);
+		trackedList[i].dirty = false;
 	}
+
+	P_SaveBufferFree(&save);
+
+	SV_RebuildIndex(numtracked);
+
+	SV_ReplayJournal();
 }
 
 // Save trackedList to disc
@@ -139,7 +366,7 @@ void SV_SaveStats(void)
 	size_t length = 0;
 	const size_t headerlen = strlen(SERVERSTATSHEADER);
 	savebuffer_t save = {0};
-	unsigned int i, j;
+	unsigned int i;
 
 	if (!server)
 		return;
@@ -160,13 +387,8 @@ void SV_SaveStats(void)
 
 	for(i = 0; i < numtracked; i++)
 	{
-		WRITEMEM(save.p, trackedList[i].public_key, PUBKEYLENGTH);
-		WRITEMEM(save.p, &trackedList[i].lastseen, sizeof(trackedList[i].lastseen));
-		for(j = 0; j < PWRLV_NUMTYPES; j++)
-		{
-			WRITEUINT16(save.p, trackedList[i].powerlevels[j]);
-		}
-		WRITEUINT32(save.p, trackedList[i].finishedrounds);
+		SV_WriteStatsRecord(&save.p, &trackedList[i]);
+		trackedList[i].dirty = false;
 	}
 
 	length = save.p - save.buffer;
@@ -177,45 +399,41 @@ void SV_SaveStats(void)
 		I_Error("Couldn't save server stats. Are you out of disk space / playing in a protected folder?");
 	}
 	P_SaveBufferFree(&save);
+
+	// Everything in the journal is in the stats file now.
+	remove(va(pandf, srb2home, SERVERSTATSJOURNAL));
+	journalrecords = 0;
 }
 
 // New player, grab their stats from trackedList or initialize new ones if they're new
 serverplayer_t *SV_GetStatsByKey(uint8_t *key)
 {
-	UINT32 j, hash;
+	serverplayer_t *stat;
+	UINT32 j;
 
 	SV_InitializeStats();
 
-	hash = quickncasehash((char*)key, PUBKEYLENGTH);
-
 	// Existing record?
-	for(j = 0; j < numtracked; j++)
-	{
-		if (hash != trackedList[j].hash) // Not crypto magic, just an early out with a faster comparison
-			continue;
-		if (memcmp(trackedList[j].public_key, key, PUBKEYLENGTH) == 0)
-			return &trackedList[j];
-	}
+	stat = SV_FindStats(key);
+	if (stat != NULL)
+		return stat;
 
 	// Untracked below this point, make a new record
-	SV_ExpandStats(numtracked+1);
+	stat = SV_AddStats(key);
 
 	// Default stats
 	// (NB: This will make a GUEST record if someone tries to retrieve GUEST stats, because
 	// at the very least we should try to provide other codepaths the right  _data type_,
 	// but it will not be written back.)
-	trackedList[numtracked].lastseen = time(NULL);
-	memcpy(&trackedList[numtracked].public_key, key, PUBKEYLENGTH);
+	stat->lastseen = time(NULL);
 	for(j = 0; j < PWRLV_NUMTYPES; j++)
 	{
-		trackedList[numtracked].powerlevels[j] = PR_IsKeyGuest(key) ? 0 : PWRLVRECORD_START;
+		stat->powerlevels[j] = PR_IsKeyGuest(key) ? 0 : PWRLVRECORD_START;
 	}
-	trackedList[numtracked].finishedrounds = 0;
-	trackedList[numtracked].hash = quickncasehash((char*)key, PUBKEYLENGTH);
-
-	numtracked++;
+	stat->finishedrounds = 0;
+	stat->dirty = !PR_IsKeyGuest(key);
 
-	return &trackedList[numtracked - 1];
+	return stat;
 }
 
 serverplayer_t *SV_GetStatsByPlayerIndex(UINT8 p)
@@ -228,11 +446,13 @@ serverplayer_t *SV_GetStats(player_t *player)
 	return SV_GetStatsByKey(player->public_key);
 }
 
-// Write clientpowerlevels and timestamps back to matching trackedList entries, then save trackedList to disk
-// (NB: Stats changes can be made directly to trackedList through other paths, but will only write to disk here)
+// Write clientpowerlevels and timestamps back to matching trackedList entries, then journal the changes to disk
+// (NB: Stats changes can be made directly to trackedList through other paths, but will only write to disk here,
+// and only if they were marked dirty)
 void SV_UpdateStats(void)
 {	
-	UINT32 i, j, hash;
+	UINT32 i;
+	serverplayer_t *stat;
 
 	if (!server)
 		return;
@@ -247,25 +467,23 @@ void SV_UpdateStats(void)
 		if (PR_IsKeyGuest(players[i].public_key))
 			continue;
 
-		hash = quickncasehash((char*)players[i].public_key, PUBKEYLENGTH);
+		stat = SV_FindStats(players[i].public_key);
 
-		for(j = 0; j < numtracked; j++)
-		{	
-			if (hash != trackedList[j].hash) // Not crypto magic, just an early out with a faster comparison
-				continue;
-			if (memcmp(&trackedList[j].public_key, players[i].public_key, PUBKEYLENGTH) == 0)
-			{
-				trackedList[j].lastseen = time(NULL);
-				memcpy(&trackedList[j].powerlevels, clientpowerlevels[i], sizeof(trackedList[j].powerlevels));
-				break;
-			}
+		if (stat != NULL)
+		{
+			stat->lastseen = time(NULL);
+			memcpy(&stat->powerlevels, clientpowerlevels[i], sizeof(stat->powerlevels));
+			stat->dirty = true;
 		}
 
 		// SV_RetrievePWR should always be called for a key before SV_UpdateStats runs,
-		// so this shouldn't be reachable.
+		// so stat shouldn't be NULL.
 	}
 
-	SV_SaveStats();
+	if (journalrecords > max(numtracked, SERVERSTATSCOMPACTMIN))
+		SV_SaveStats();
+	else
+		SV_FlushStats();
 }
 
 void SV_BumpMatchStats(void)
@@ -301,6 +519,9 @@ void SV_BumpMatchStats(void)
 		}
 
 		if (participated)
+		{
 			stat->finishedrounds++;
+			stat->dirty = true;
+		}
 	}
 }
\ No newline at end of file
@@ -26,6 +26,10 @@ extern "C" {
 #define SERVERSTATSHEADER "Doctor Robotnik's Ring Racers Server Stats"
 #define SERVERSTATSVER 2
 
+// Changed records are appended here between full saves of SERVERSTATSFILE
+#define SERVERSTATSJOURNAL "srvstats.jnl"
+#define SERVERSTATSJOURNALHEADER "Doctor Robotnik's Ring Racers Server Stats Journal"
+
 struct serverplayer_t
 {
 	uint8_t public_key[PUBKEYLENGTH];
@@ -34,6 +38,7 @@ struct serverplayer_t
 	UINT32 finishedrounds;
 
 	UINT32 hash; // Not persisted! Used for early outs during key comparisons
+	boolean dirty; // Not persisted! Changed since it was last written to disk
 };
 
 void SV_SaveStats(void);
@@ -24,6 +24,11 @@
 #include "cxxutil.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
 #include <vector>
 
 #include <fmt/format.h>
@@ -53,6 +58,53 @@ static size_t baseopensetsize    = OPENSET_BASE_SIZE;
 static size_t baseclosedsetsize  = CLOSEDSET_BASE_SIZE;
 static size_t basenodesarraysize = NODESARRAY_BASE_SIZE;
 
+// Distance to the finish line from every waypoint, one field per shortcut mode.
+// Rebuilt lazily when any waypoint's enabled or shortcut state changes.
+namespace
+{
+
+struct finishdistancefield_t
+{
+	std::vector<UINT32> distances; // Indexed by waypoint heap index, UINT32_MAX if the finish can't be reached
+	bool valid = false;
+};
+
+std::array<finishdistancefield_t, 2> finishdistancefields;
+std::vector<UINT8> finishdistanceflags;
+tic_t finishdistancetic = 0U;
+bool finishdistancedirty = true;
+
+}; // namespace
+
+// Smallest cell size of the waypoint grid, in map units
+#define WAYPOINTGRID_MIN_CELL_SIZE (256)
+
+// Uniform grid over the waypoint mobjs' x/y, in the same whole map units as the distance checks that use it.
+// Rebuilt when a waypoint mobj moves to another cell.
+namespace
+{
+
+struct waypointgrid_t
+{
+	std::vector<size_t> cellstart;     // Start of each cell in cellwaypoints, with one extra entry for the end
+	std::vector<UINT32> cellwaypoints; // Waypoint heap indices, ascending within each cell
+	std::vector<INT32> positions;      // x/y pairs of every waypoint when the grid was built
+	INT32 originx = 0;
+	INT32 originy = 0;
+	INT32 cellsize = WAYPOINTGRID_MIN_CELL_SIZE;
+	INT32 width = 0;
+	INT32 height = 0;
+	INT32 maxradius = 0;               // Largest waypoint radius, in map units
+	bool valid = false;
+};
+
+waypointgrid_t waypointgrid;
+std::vector<UINT32> waypointgridcandidates;
+tic_t waypointgridtic = 0U;
+bool waypointgriddirty = true;
+
+}; // namespace
+
 
 /*--------------------------------------------------
 	waypoint_t *K_GetFinishLineWaypoint(void)
@@ -299,6 +351,217 @@ INT32 K_GetTrackComplexity(void)
 	return trackcomplexity;
 }
 
+/*--------------------------------------------------
+	static INT64 K_GetWaypointGridCell(const INT32 pos, const INT32 origin)
+
+		Gets which column or row of the waypoint grid a position falls in.
+		The result can be outside of the grid.
+
+	Input Arguments:-
+		pos    - The x or y position, in map units
+		origin - The grid's originx or originy
+
+	Return:-
+		The column or row of the position
+--------------------------------------------------*/
+static INT64 K_GetWaypointGridCell(const INT32 pos, const INT32 origin)
+{
+	const INT64 offset = (INT64)pos - origin;
+
+	if (offset < 0)
+	{
+		return -((-offset + waypointgrid.cellsize - 1) / waypointgrid.cellsize);
+	}
+
+	return offset / waypointgrid.cellsize;
+}
+
+/*--------------------------------------------------
+	static void K_BuildWaypointGrid(void)
+
+		Buckets every waypoint in the heap into the waypoint grid, sized so
+		there is roughly one waypoint per cell.
+--------------------------------------------------*/
+static void K_BuildWaypointGrid(void)
+{
+	waypointgrid_t &grid = waypointgrid;
+	INT32 minx = INT32_MAX;
+	INT32 miny = INT32_MAX;
+	INT32 maxx = INT32_MIN;
+	INT32 maxy = INT32_MIN;
+	size_t i;
+
+	grid.positions.resize(numwaypoints * 2U);
+	grid.maxradius = 0;
+
+	for (i = 0U; i < numwaypoints; i++)
+	{
+		const mobj_t *const mobj = waypointheap[i].mobj;
+		const INT32 x = mobj->x / FRACUNIT;
+		const INT32 y = mobj->y / FRACUNIT;
+
+		grid.positions[i * 2U] = x;
+		grid.positions[(i * 2U) + 1U] = y;
+
+		minx = std::min(minx, x);
+		miny = std::min(miny, y);
+		maxx = std::max(maxx, x);
+		maxy = std::max(maxy, y);
+		grid.maxradius = std::max(grid.maxradius, (INT32)(mobj->radius / FRACUNIT));
+	}
+
+	if (numwaypoints == 0U)
+	{
+		grid.cellstart.clear();
+		grid.cellwaypoints.clear();
+		grid.width = grid.height = 0;
+		grid.valid = false;
+		return;
+	}
+
+	const double spanx = (double)maxx - minx + 1.0;
+	const double spany = (double)maxy - miny + 1.0;
+	const double cellsize = std::ceil(std::sqrt((spanx * spany) / numwaypoints));
+
+	grid.originx = minx;
+	grid.originy = miny;
+	grid.cellsize = (INT32)std::min(std::max(cellsize, (double)WAYPOINTGRID_MIN_CELL_SIZE), (double)INT32_MAX);
+	grid.width = (INT32)(K_GetWaypointGridCell(maxx, minx) + 1);
+	grid.height = (INT32)(K_GetWaypointGridCell(maxy, miny) + 1);
+
+	const size_t numcells = (size_t)grid.width * (size_t)grid.height;
+	std::vector<size_t> cellcursor(numcells, 0U);
+
+	grid.cellstart.assign(numcells + 1U, 0U);
+	grid.cellwaypoints.resize(numwaypoints);
+
+	for (i = 0U; i < numwaypoints; i++)
+	{
+		const size_t cell =
+			(size_t)K_GetWaypointGridCell(grid.positions[(i * 2U) + 1U], grid.originy) * grid.width
+			+ (size_t)K_GetWaypointGridCell(grid.positions[i * 2U], grid.originx);
+		grid.cellstart[cell + 1U]++;
+	}
+
+	for (i = 0U; i < numcells; i++)
+	{
+		grid.cellstart[i + 1U] += grid.cellstart[i];
+		cellcursor[i] = grid.cellstart[i];
+	}
+
+	// Heap order is kept within each cell, so ties can be broken the same way as a scan of the heap would
+	for (i = 0U; i < numwaypoints; i++)
+	{
+		const size_t cell =
+			(size_t)K_GetWaypointGridCell(grid.positions[(i * 2U) + 1U], grid.originy) * grid.width
+			+ (size_t)K_GetWaypointGridCell(grid.positions[i * 2U], grid.originx);
+		grid.cellwaypoints[cellcursor[cell]++] = (UINT32)i;
+	}
+
+	grid.valid = true;
+}
+
+/*--------------------------------------------------
+	static boolean K_ValidateWaypointGrid(void)
+
+		Rebuilds the waypoint grid if any waypoint has moved since it was
+		built, and refreshes the largest waypoint radius. The full check is
+		only done once per tic, or after K_InvalidateWaypointGrid.
+
+	Return:-
+		true if the grid can be used, otherwise false
+--------------------------------------------------*/
+static boolean K_ValidateWaypointGrid(void)
+{
+	waypointgrid_t &grid = waypointgrid;
+
+	if (numwaypoints == 0U)
+	{
+		return false;
+	}
+
+	if (waypointgriddirty == false && waypointgridtic == leveltime && grid.valid == true)
+	{
+		return true;
+	}
+
+	bool moved = (grid.valid == false || grid.positions.size() != numwaypoints * 2U);
+	INT32 maxradius = 0;
+	size_t i;
+
+	for (i = 0U; i < numwaypoints; i++)
+	{
+		const mobj_t *const mobj = waypointheap[i].mobj;
+
+		if (moved == false
+			&& (grid.positions[i * 2U] != mobj->x / FRACUNIT
+			|| grid.positions[(i * 2U) + 1U] != mobj->y / FRACUNIT))
+		{
+			moved = true;
+		}
+
+		maxradius = std::max(maxradius, (INT32)(mobj->radius / FRACUNIT));
+	}
+
+	if (moved == true)
+	{
+		K_BuildWaypointGrid();
+	}
+	else
+	{
+		grid.maxradius = maxradius;
+	}
+
+	waypointgridtic = leveltime;
+	waypointgriddirty = false;
+
+	return grid.valid;
+}
+
+/*--------------------------------------------------
+	template <typename F>
+	static void K_IterateWaypointGridCells(
+		INT64 mincx, INT64 mincy,
+		INT64 maxcx, INT64 maxcy,
+		INT64 stepx, F func)
+
+		Calls func with the heap index of every waypoint in a block of grid
+		cells. Cells outside of the grid are skipped.
+
+	Input Arguments:-
+		mincx, mincy - The first column and row of the block
+		maxcx, maxcy - The last column and row of the block
+		stepx        - The column step for rows between the first and last,
+		               so only the edges of a ring can be visited
+		func         - Called with each waypoint's heap index
+--------------------------------------------------*/
+template <typename F>
+static void K_IterateWaypointGridCells(INT64 mincx, INT64 mincy, INT64 maxcx, INT64 maxcy, INT64 stepx, F func)
+{
+	const waypointgrid_t &grid = waypointgrid;
+	INT64 cx, cy;
+
+	for (cy = std::max<INT64>(mincy, 0); cy <= std::min<INT64>(maxcy, grid.height - 1); cy++)
+	{
+		const INT64 step = (cy == mincy || cy == maxcy) ? 1 : stepx;
+
+		for (cx = mincx; cx <= maxcx; cx += step)
+		{
+			if (cx < 0 || cx >= grid.width)
+			{
+				continue;
+			}
+
+			const size_t cell = (size_t)cy * grid.width + (size_t)cx;
+
+			for (size_t i = grid.cellstart[cell]; i < grid.cellstart[cell + 1U]; i++)
+			{
+				func(grid.cellwaypoints[i]);
+			}
+		}
+	}
+}
+
 /*--------------------------------------------------
 	waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj)
 
@@ -312,27 +575,49 @@ waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj)
 	{
 		CONS_Debug(DBG_GAMELOGIC, "NULL mobj in K_GetClosestWaypointToMobj.\n");
 	}
-	else
+	else if (K_ValidateWaypointGrid() == true)
 	{
-		size_t     i              = 0U;
-		waypoint_t *checkwaypoint = NULL;
+		const waypointgrid_t &grid = waypointgrid;
+		const INT64 qcx = K_GetWaypointGridCell(mobj->x / FRACUNIT, grid.originx);
+		const INT64 qcy = K_GetWaypointGridCell(mobj->y / FRACUNIT, grid.originy);
+		const INT64 lastring = std::max(
+			std::max(qcx, (INT64)grid.width - 1 - qcx),
+			std::max(qcy, (INT64)grid.height - 1 - qcy));
+		size_t     closestindex   = SIZE_MAX;
 		fixed_t    closestdist    = INT32_MAX;
 		fixed_t    checkdist      = INT32_MAX;
+		INT64      ring           = 0;
 
-		for (i = 0; i < numwaypoints; i++)
+		auto check_waypoint = [&](const UINT32 i)
 		{
-			checkwaypoint = &waypointheap[i];
+			waypoint_t *const checkwaypoint = &waypointheap[i];
 
 			checkdist = P_AproxDistance(
 				(mobj->x / FRACUNIT) - (checkwaypoint->mobj->x / FRACUNIT),
 				(mobj->y / FRACUNIT) - (checkwaypoint->mobj->y / FRACUNIT));
 			checkdist = P_AproxDistance(checkdist, (mobj->z / FRACUNIT) - (checkwaypoint->mobj->z / FRACUNIT));
 
-			if (checkdist < closestdist)
+			// Ties go to the lowest heap index, same as scanning the whole heap in order
+			if (checkdist < closestdist || (checkdist == closestdist && i < closestindex && closestwaypoint != NULL))
 			{
 				closestwaypoint = checkwaypoint;
+				closestindex = i;
 				closestdist = checkdist;
 			}
+		};
+
+		// Search outwards a ring of cells at a time. Anything outside of the rings searched so far is more than
+		// (ring - 1) cells away on x or y, and the distance can't be shorter than that.
+		for (ring = 0; ring <= lastring; ring++)
+		{
+			if (closestwaypoint != NULL && (INT64)closestdist <= (ring - 1) * grid.cellsize)
+			{
+				break;
+			}
+
+			K_IterateWaypointGridCells(
+				qcx - ring, qcy - ring, qcx + ring, qcy + ring,
+				std::max<INT64>(ring * 2, 1), check_waypoint);
 		}
 	}
 
@@ -354,9 +639,8 @@ static void K_CompareOverlappingWaypoint
 		fixed_t     *const bestfindist)
 {
 	const boolean useshortcuts = false;
-	const boolean huntbackwards = false;
 	boolean pathfindsuccess = false;
-	path_t pathtofinish = {0};
+	UINT32 disttofinish = 0U;
 
 	if (K_GetWaypointIsShortcut(*bestwaypoint) == false
 		&& K_GetWaypointIsShortcut(checkwaypoint) == true)
@@ -366,17 +650,15 @@ static void K_CompareOverlappingWaypoint
 	}
 
 	pathfindsuccess =
-		K_PathfindToWaypoint(checkwaypoint, finishline, &pathtofinish, useshortcuts, huntbackwards);
+		K_GetWaypointDistanceToFinish(checkwaypoint, useshortcuts, &disttofinish);
 
 	if (pathfindsuccess == true)
 	{
-		if ((INT32)(pathtofinish.totaldist) < *bestfindist)
+		if ((INT32)(disttofinish) < *bestfindist)
 		{
 			*bestwaypoint = checkwaypoint;
-			*bestfindist = pathtofinish.totaldist;
+			*bestfindist = disttofinish;
 		}
-
-		Z_Free(pathtofinish.array);
 	}
 }
 
@@ -494,9 +776,40 @@ waypoint_t *K_GetBestWaypointForMobj(mobj_t *const mobj, waypoint_t *const hint)
 			sort_waypoint(hint);
 		}
 
-		for (size_t i = 0U; i < numwaypoints; i++)
+		if (closestdist != INT32_MAX && K_ValidateWaypointGrid() == true)
 		{
-			sort_waypoint(&waypointheap[i]);
+			// closestdist only shrinks from here, so a waypoint can only still change the result if it's closer than
+			// that or inside of its own radius. Both are bounded by the larger x/y distance, so only the cells within
+			// that range need checking. They're still visited in heap order, so the result is the same as checking
+			// every waypoint.
+			const waypointgrid_t &grid = waypointgrid;
+			const INT64 range = std::max<INT64>(closestdist, grid.maxradius);
+			const INT32 mx = mobj->x / FRACUNIT;
+			const INT32 my = mobj->y / FRACUNIT;
+
+			waypointgridcandidates.clear();
+
+			K_IterateWaypointGridCells(
+				K_GetWaypointGridCell((INT32)std::max<INT64>(mx - range, INT32_MIN), grid.originx),
+				K_GetWaypointGridCell((INT32)std::max<INT64>(my - range, INT32_MIN), grid.originy),
+				K_GetWaypointGridCell((INT32)std::min<INT64>(mx + range, INT32_MAX), grid.originx),
+				K_GetWaypointGridCell((INT32)std::min<INT64>(my + range, INT32_MAX), grid.originy),
+				1,
+				[](const UINT32 i) { waypointgridcandidates.push_back(i); });
+
+			std::sort(waypointgridcandidates.begin(), waypointgridcandidates.end());
+
+			for (const UINT32 i : waypointgridcandidates)
+			{
+				sort_waypoint(&waypointheap[i]);
+			}
+		}
+		else
+		{
+			for (size_t i = 0U; i < numwaypoints; i++)
+			{
+				sort_waypoint(&waypointheap[i]);
+			}
 		}
 	}
 
@@ -1392,22 +1705,44 @@ boolean K_PathfindThruCircuit(
 	path_t *const     returnpath,
 	const boolean     useshortcuts,
 	const boolean     huntbackwards)
+{
+	return K_PathfindThruCircuitOnArena(sourcewaypoint, traveldistance, returnpath, useshortcuts, huntbackwards, NULL);
+}
+
+/*--------------------------------------------------
+	boolean K_PathfindThruCircuitOnArena(
+		waypoint_t *const      sourcewaypoint,
+		const UINT32           traveldistance,
+		path_t *const          returnpath,
+		const boolean          useshortcuts,
+		const boolean          huntbackwards,
+		pathfindarena_t *const arena)
+
+		See header file for description.
+--------------------------------------------------*/
+boolean K_PathfindThruCircuitOnArena(
+	waypoint_t *const      sourcewaypoint,
+	const UINT32           traveldistance,
+	path_t *const          returnpath,
+	const boolean          useshortcuts,
+	const boolean          huntbackwards,
+	pathfindarena_t *const arena)
 {
 	boolean pathfound = false;
 
 	if (sourcewaypoint == NULL)
 	{
-		CONS_Debug(DBG_GAMELOGIC, "NULL sourcewaypoint in K_PathfindThruCircuit.\n");
+		CONS_Debug(DBG_GAMELOGIC, "NULL sourcewaypoint in K_PathfindThruCircuitOnArena.\n");
 	}
 	else if (finishline == NULL)
 	{
-		CONS_Debug(DBG_GAMELOGIC, "NULL finishline in K_PathfindThruCircuit.\n");
+		CONS_Debug(DBG_GAMELOGIC, "NULL finishline in K_PathfindThruCircuitOnArena.\n");
 	}
 	else if (((huntbackwards == false) && (sourcewaypoint->numnextwaypoints == 0))
 		|| ((huntbackwards == true) && (sourcewaypoint->numprevwaypoints == 0)))
 	{
 		CONS_Debug(DBG_GAMELOGIC,
-			"K_PathfindThruCircuit: sourcewaypoint with ID %d has no next waypoint\n",
+			"K_PathfindThruCircuitOnArena: sourcewaypoint with ID %d has no next waypoint\n",
 			K_GetWaypointID(sourcewaypoint));
 	}
 	else
@@ -1441,12 +1776,17 @@ boolean K_PathfindThruCircuit(
 		pathfindsetup.getheuristic       = heuristicfunc;
 		pathfindsetup.gettraversable     = traversablefunc;
 		pathfindsetup.getfinished        = finishedfunc;
+		pathfindsetup.arena              = arena;
 
 		pathfound = K_PathfindAStar(returnpath, &pathfindsetup);
 
-		K_UpdateOpensetBaseSize(pathfindsetup.opensetcapacity);
-		K_UpdateClosedsetBaseSize(pathfindsetup.closedsetcapacity);
-		K_UpdateNodesArrayBaseSize(pathfindsetup.nodesarraycapacity);
+		if (arena == NULL)
+		{
+			// A private arena keeps its own size, and may be searched off the main thread.
+			K_UpdateOpensetBaseSize(pathfindsetup.opensetcapacity);
+			K_UpdateClosedsetBaseSize(pathfindsetup.closedsetcapacity);
+			K_UpdateNodesArrayBaseSize(pathfindsetup.nodesarraycapacity);
+		}
 	}
 
 	return pathfound;
@@ -1528,6 +1868,230 @@ boolean K_PathfindThruCircuitSpawnable(
 	return pathfound;
 }
 
+/*--------------------------------------------------
+	static UINT8 K_GetFinishDistanceFlags(waypoint_t *const waypoint)
+
+		Packs the waypoint state that affects traversability for the finish
+		distance fields.
+
+	Input Arguments:-
+		waypoint - The waypoint to get the flags of
+
+	Return:-
+		Bit 0 set if the waypoint is enabled, bit 1 set if it is a shortcut.
+--------------------------------------------------*/
+static UINT8 K_GetFinishDistanceFlags(waypoint_t *const waypoint)
+{
+	return (K_GetWaypointIsEnabled(waypoint) ? 1U : 0U) | (K_GetWaypointIsShortcut(waypoint) ? 2U : 0U);
+}
+
+/*--------------------------------------------------
+	static void K_ValidateFinishDistances(void)
+
+		Throws away the finish distance fields if any waypoint's enabled or
+		shortcut state has changed since they were built. The full check is
+		only done once per tic, or after K_InvalidateFinishDistances.
+--------------------------------------------------*/
+static void K_ValidateFinishDistances(void)
+{
+	size_t i;
+	bool changed = false;
+
+	if (finishdistancedirty == false && finishdistancetic == leveltime)
+	{
+		return;
+	}
+
+	if (finishdistanceflags.size() != numwaypoints)
+	{
+		finishdistanceflags.assign(numwaypoints, 0U);
+		changed = true;
+	}
+
+	for (i = 0U; i < numwaypoints; i++)
+	{
+		const UINT8 flags = K_GetFinishDistanceFlags(&waypointheap[i]);
+
+		if (finishdistanceflags[i] != flags)
+		{
+			finishdistanceflags[i] = flags;
+			changed = true;
+		}
+	}
+
+	if (changed == true)
+	{
+		for (finishdistancefield_t &field : finishdistancefields)
+		{
+			field.valid = false;
+		}
+	}
+
+	finishdistancetic = leveltime;
+	finishdistancedirty = false;
+}
+
+/*--------------------------------------------------
+	static void K_BuildFinishDistanceField(finishdistancefield_t &field, const boolean useshortcuts)
+
+		Runs Dijkstra backwards from the finish line over the previous waypoint
+		connections. Traversability is the same as K_PathfindToWaypoint's: a
+		waypoint can be entered if it is enabled, and if shortcuts aren't
+		allowed, only from another shortcut if it is a shortcut itself. That only
+		depends on the two ends of each connection, so distances from every
+		waypoint can be shared.
+
+	Input Arguments:-
+		field        - The field to fill in
+		useshortcuts - Whether shortcut waypoints are freely traversable
+--------------------------------------------------*/
+static void K_BuildFinishDistanceField(finishdistancefield_t &field, const boolean useshortcuts)
+{
+	using queueitem_t = std::pair<UINT32, size_t>;
+	std::priority_queue<queueitem_t, std::vector<queueitem_t>, std::greater<queueitem_t>> openset;
+	const size_t finishindex = K_GetWaypointHeapIndex(finishline);
+
+	field.distances.assign(numwaypoints, UINT32_MAX);
+	field.valid = true;
+
+	if (finishindex >= numwaypoints)
+	{
+		return;
+	}
+
+	field.distances[finishindex] = 0U;
+	openset.emplace(0U, finishindex);
+
+	while (openset.empty() == false)
+	{
+		const queueitem_t item = openset.top();
+		openset.pop();
+
+		if (item.first > field.distances[item.second])
+		{
+			// Stale entry, this waypoint was already reached cheaper
+			continue;
+		}
+
+		waypoint_t *const waypoint = &waypointheap[item.second];
+		const UINT8 flags = finishdistanceflags[item.second];
+
+		if ((flags & 1U) == 0U)
+		{
+			// Disabled waypoints can't be entered, so nothing can path through them
+			continue;
+		}
+
+		for (size_t i = 0U; i < waypoint->numprevwaypoints; i++)
+		{
+			waypoint_t *const prevwaypoint = waypoint->prevwaypoints[i];
+			const size_t previndex = K_GetWaypointHeapIndex(prevwaypoint);
+
+			if (previndex >= numwaypoints)
+			{
+				continue;
+			}
+
+			if (useshortcuts == false && (flags & 2U) && (finishdistanceflags[previndex] & 2U) == 0U)
+			{
+				// Shortcuts can only be entered from other shortcuts
+				continue;
+			}
+
+			const UINT32 dist = item.first + waypoint->prevwaypointdistances[i];
+
+			if (dist < field.distances[previndex])
+			{
+				field.distances[previndex] = dist;
+				openset.emplace(dist, previndex);
+			}
+		}
+	}
+}
+
+/*--------------------------------------------------
+	boolean K_GetWaypointDistanceToFinish(
+		waypoint_t *const waypoint,
+		const boolean     useshortcuts,
+		UINT32 *const     returndist)
+
+		See header file for description.
+--------------------------------------------------*/
+boolean K_GetWaypointDistanceToFinish(
+	waypoint_t *const waypoint,
+	const boolean     useshortcuts,
+	UINT32 *const     returndist)
+{
+	size_t waypointindex = SIZE_MAX;
+	UINT32 dist = UINT32_MAX;
+
+	if (waypoint == NULL)
+	{
+		CONS_Debug(DBG_GAMELOGIC, "NULL waypoint in K_GetWaypointDistanceToFinish.\n");
+		return false;
+	}
+
+	if (finishline == NULL)
+	{
+		return false;
+	}
+
+	// Same early outs as K_PathfindToWaypoint would have
+	if (waypoint->numnextwaypoints == 0U
+		|| finishline->numprevwaypoints == 0U
+		|| finishline->numnextwaypoints == 0U)
+	{
+		return false;
+	}
+
+	waypointindex = K_GetWaypointHeapIndex(waypoint);
+	if (waypointindex >= numwaypoints)
+	{
+		return false;
+	}
+
+	K_ValidateFinishDistances();
+
+	finishdistancefield_t &field = finishdistancefields[useshortcuts ? 1 : 0];
+	if (field.valid == false)
+	{
+		K_BuildFinishDistanceField(field, useshortcuts);
+	}
+
+	dist = field.distances[waypointindex];
+	if (dist == UINT32_MAX)
+	{
+		return false;
+	}
+
+	if (returndist != NULL)
+	{
+		*returndist = dist;
+	}
+
+	return true;
+}
+
+/*--------------------------------------------------
+	void K_InvalidateFinishDistances(void)
+
+		See header file for description.
+--------------------------------------------------*/
+void K_InvalidateFinishDistances(void)
+{
+	finishdistancedirty = true;
+}
+
+/*--------------------------------------------------
+	void K_InvalidateWaypointGrid(void)
+
+		See header file for description.
+--------------------------------------------------*/
+void K_InvalidateWaypointGrid(void)
+{
+	waypointgriddirty = true;
+}
+
 /*--------------------------------------------------
 	waypoint_t *K_GetNextWaypointToDestination(
 		waypoint_t *const sourcewaypoint,
@@ -1951,6 +2515,12 @@ waypoint_t *K_SearchWaypointHeapForMobj(mobj_t *const mobj)
 	{
 		CONS_Debug(DBG_GAMELOGIC, "Non MT_WAYPOINT mobj in K_SearchWaypointHeapForMobj. Type=%d.\n", mobj->type);
 	}
+	else if (mobj->cusval >= 0 && (size_t)mobj->cusval < numwaypoints
+		&& waypointheap[mobj->cusval].mobj == mobj)
+	{
+		// cusval is set to the heap index in K_SetupWaypointList
+		foundwaypoint = &waypointheap[mobj->cusval];
+	}
 	else
 	{
 		foundwaypoint = K_SearchWaypointHeap(K_CheckWaypointForMobj, (void *)mobj);
@@ -2785,6 +3355,10 @@ boolean K_SetupWaypointList(void)
 					K_CalculateTrackComplexity();
 				}
 
+				K_BuildWaypointGrid();
+				waypointgridtic = leveltime;
+				waypointgriddirty = false;
+
 				setupsuccessful = true;
 			}
 		}
@@ -2808,6 +3382,18 @@ void K_ClearWaypoints(void)
 	numwaypointmobjs = 0U;
 	circuitlength    = 0U;
 	trackcomplexity  = 0U;
+
+	for (finishdistancefield_t &field : finishdistancefields)
+	{
+		field.distances.clear();
+		field.valid = false;
+	}
+	finishdistanceflags.clear();
+	finishdistancedirty = true;
+
+	waypointgrid = {};
+	waypointgridcandidates.clear();
+	waypointgriddirty = true;
 }
 
 /*--------------------------------------------------
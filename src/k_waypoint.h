@@ -298,6 +298,39 @@ boolean K_PathfindThruCircuit(
 	const boolean     huntbackwards);
 
 
+/*--------------------------------------------------
+	boolean K_PathfindThruCircuitOnArena(
+		waypoint_t *const      sourcewaypoint,
+		const UINT32           traveldistance,
+		path_t *const          returnpath,
+		const boolean          useshortcuts,
+		const boolean          huntbackwards,
+		pathfindarena_t *const arena)
+
+		K_PathfindThruCircuit, searching a private arena from K_NewPathfindArena so that it can run off the main
+		thread. The returned path belongs to the arena, see K_NewPathfindArena.
+
+	Input Arguments:-
+		sourcewaypoint      - The waypoint to start searching from
+		traveldistance      - How far along the circuit it will try to pathfind.
+		returnpath          - The path_t that will contain the final found path
+		useshortcuts        - Whether to use waypoints that are marked as being shortcuts in the search
+		huntbackwards       - Goes through the waypoints backwards if true
+		arena               - The arena to search, or NULL for the same as K_PathfindThruCircuit
+
+	Return:-
+		True if a circuit path could be constructed, false if it couldn't.
+--------------------------------------------------*/
+
+boolean K_PathfindThruCircuitOnArena(
+	waypoint_t *const      sourcewaypoint,
+	const UINT32           traveldistance,
+	path_t *const          returnpath,
+	const boolean          useshortcuts,
+	const boolean          huntbackwards,
+	pathfindarena_t *const arena);
+
+
 /*--------------------------------------------------
 	boolean K_PathfindThruCircuitSpawnable(
 		waypoint_t *const sourcewaypoint,
@@ -328,6 +361,31 @@ boolean K_PathfindThruCircuitSpawnable(
 	const boolean     huntbackwards);
 
 
+/*--------------------------------------------------
+	boolean K_GetWaypointDistanceToFinish(
+		waypoint_t *const waypoint,
+		const boolean     useshortcuts,
+		UINT32 *const     returndist)
+
+		Gets the distance from a waypoint to the finish line. This is the same as the totaldist of
+		K_PathfindToWaypoint(waypoint, K_GetFinishLineWaypoint(), ..., useshortcuts, false), but it is looked up
+		from a field that is only rebuilt when waypoints are enabled, disabled or change shortcut status.
+
+	Input Arguments:-
+		waypoint     - The waypoint to get the distance from
+		useshortcuts - Whether to use waypoints that are marked as being shortcuts
+		returndist   - Where to put the distance to the finish line
+
+	Return:-
+		True if the finish line can be reached from the waypoint, false if it can't.
+--------------------------------------------------*/
+
+boolean K_GetWaypointDistanceToFinish(
+	waypoint_t *const waypoint,
+	const boolean     useshortcuts,
+	UINT32 *const     returndist);
+
+
 /*--------------------------------------------------
 	waypoint_t *K_GetNextWaypointToDestination(
 		waypoint_t *const sourcewaypoint,
@@ -429,6 +487,26 @@ size_t K_GetNumWaypoints(void);
 waypoint_t *K_GetWaypointFromIndex(size_t waypointindex);
 
 
+/*--------------------------------------------------
+	void K_InvalidateFinishDistances(void)
+
+		Tells the finish line distance field to recheck the waypoints' enabled and shortcut states on its next use.
+		Call this after changing either of those on a waypoint mobj.
+--------------------------------------------------*/
+
+void K_InvalidateFinishDistances(void);
+
+
+/*--------------------------------------------------
+	void K_InvalidateWaypointGrid(void)
+
+		Tells the waypoint position grid to recheck the waypoints' positions on its next use.
+		Call this after moving a waypoint mobj.
+--------------------------------------------------*/
+
+void K_InvalidateWaypointGrid(void);
+
+
 /*--------------------------------------------------
 	void K_DebugWaypointsVisualise()
 
@@ -0,0 +1,269 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_alloc.cpp
+/// \brief Memory allocator for Lua states
+///
+/// Lua makes huge numbers of small allocations (strings, tables, closures)
+/// and always tells the allocator how big a block was when it frees it.
+/// Small blocks are carved out of slabs by size class, so they need no
+/// header and no zone bookkeeping, and closing a state releases a handful
+/// of slabs instead of every block. Bigger blocks go straight to malloc.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "lua_alloc.h"
+
+namespace
+{
+
+constexpr std::size_t kSlabSize = 64 * 1024;
+constexpr std::size_t kMaxSmallSize = 512;
+
+// 16-byte steps up to 256 bytes, then 64-byte steps up to kMaxSmallSize.
+constexpr std::size_t kNumClasses = 256 / 16 + (kMaxSmallSize - 256) / 64;
+
+constexpr std::size_t size_class(std::size_t size)
+{
+	if (size <= 256)
+	{
+		return (size + 15) / 16 - 1;
+	}
+
+	return 256 / 16 + (size - 256 + 63) / 64 - 1;
+}
+
+constexpr std::size_t class_size(std::size_t sc)
+{
+	if (sc < 256 / 16)
+	{
+		return (sc + 1) * 16;
+	}
+
+	return 256 + (sc - 256 / 16 + 1) * 64;
+}
+
+static_assert(size_class(kMaxSmallSize) == kNumClasses - 1);
+static_assert(class_size(size_class(kMaxSmallSize)) == kMaxSmallSize);
+
+struct FreeBlock
+{
+	FreeBlock* next;
+};
+
+struct SizeClass
+{
+	FreeBlock* free = nullptr;
+
+	// Unused tail of the newest slab of this class.
+	std::byte* bump = nullptr;
+	std::byte* bump_end = nullptr;
+};
+
+}; // namespace
+
+struct lua_heap_t
+{
+	std::array<SizeClass, kNumClasses> classes;
+	std::vector<void*> slabs;
+	lua_heapstats_t stats = {};
+};
+
+namespace
+{
+
+void* alloc_small(lua_heap_t* heap, std::size_t size)
+{
+	SizeClass& sc = heap->classes[size_class(size)];
+	const std::size_t block = class_size(size_class(size));
+
+	if (sc.free != nullptr)
+	{
+		FreeBlock* b = sc.free;
+		sc.free = b->next;
+		return b;
+	}
+
+	if (sc.bump == sc.bump_end)
+	{
+		std::byte* slab = static_cast<std::byte*>(std::malloc(kSlabSize));
+
+		if (slab == nullptr)
+		{
+			return nullptr;
+		}
+
+		heap->slabs.push_back(slab);
+		heap->stats.reserved += kSlabSize;
+
+		sc.bump = slab;
+		sc.bump_end = slab + (kSlabSize / block) * block;
+	}
+
+	void* p = sc.bump;
+	sc.bump += block;
+	return p;
+}
+
+void free_small(lua_heap_t* heap, void* ptr, std::size_t size)
+{
+	SizeClass& sc = heap->classes[size_class(size)];
+	FreeBlock* b = static_cast<FreeBlock*>(ptr);
+
+	b->next = sc.free;
+	sc.free = b;
+}
+
+void* alloc_block(lua_heap_t* heap, std::size_t size)
+{
+	if (size <= kMaxSmallSize)
+	{
+		return alloc_small(heap, size);
+	}
+
+	void* p = std::malloc(size);
+
+	if (p != nullptr)
+	{
+		heap->stats.reserved += size;
+	}
+
+	return p;
+}
+
+void free_block(lua_heap_t* heap, void* ptr, std::size_t size)
+{
+	if (size <= kMaxSmallSize)
+	{
+		free_small(heap, ptr, size);
+		return;
+	}
+
+	std::free(ptr);
+	heap->stats.reserved -= size;
+}
+
+void* realloc_block(lua_heap_t* heap, void* ptr, std::size_t osize, std::size_t nsize)
+{
+	if (ptr == nullptr || osize == 0)
+	{
+		return alloc_block(heap, nsize);
+	}
+
+	if (osize > kMaxSmallSize && nsize > kMaxSmallSize)
+	{
+		void* p = std::realloc(ptr, nsize);
+
+		if (p != nullptr)
+		{
+			heap->stats.reserved += nsize;
+			heap->stats.reserved -= osize;
+		}
+
+		return p;
+	}
+
+	if (osize <= kMaxSmallSize && nsize <= kMaxSmallSize && size_class(osize) == size_class(nsize))
+	{
+		return ptr;
+	}
+
+	void* p = alloc_block(heap, nsize);
+
+	if (p == nullptr)
+	{
+		return nullptr;
+	}
+
+	std::memcpy(p, ptr, std::min(osize, nsize));
+	free_block(heap, ptr, osize);
+	return p;
+}
+
+}; // namespace
+
+lua_heap_t* LUA_NewHeap(void)
+{
+	return new lua_heap_t;
+}
+
+void LUA_DeleteHeap(lua_heap_t* heap)
+{
+	if (heap == nullptr)
+	{
+		return;
+	}
+
+	for (void* slab : heap->slabs)
+	{
+		std::free(slab);
+	}
+
+	delete heap;
+}
+
+void* LUA_HeapAlloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize)
+{
+	lua_heap_t* heap = static_cast<lua_heap_t*>(ud);
+	lua_heapstats_t& stats = heap->stats;
+
+	if (nsize == 0)
+	{
+		if (ptr != nullptr && osize != 0)
+		{
+			free_block(heap, ptr, osize);
+			stats.live -= osize;
+		}
+
+		return nullptr;
+	}
+
+	void* p = realloc_block(heap, ptr, ptr ? osize : 0, nsize);
+
+	// Lua raises a memory error if this fails, and leaves the old block alone.
+	if (p == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (ptr == nullptr)
+	{
+		stats.allocs++;
+		stats.live += nsize;
+	}
+	else
+	{
+		stats.live += nsize;
+		stats.live -= osize;
+	}
+
+	stats.peak = std::max(stats.peak, stats.live);
+
+	return p;
+}
+
+const lua_heapstats_t* LUA_HeapStats(const lua_heap_t* heap)
+{
+	return &heap->stats;
+}
+
+void LUA_HeapTicker(lua_heap_t* heap)
+{
+	if (heap == nullptr)
+	{
+		return;
+	}
+
+	heap->stats.ticallocs = heap->stats.allocs;
+	heap->stats.allocs = 0;
+}
@@ -0,0 +1,48 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_alloc.h
+/// \brief Memory allocator for Lua states
+
+#ifndef lua_alloc_h
+#define lua_alloc_h
+
+#include "doomtype.h"
+#include "typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct lua_heap_t;
+
+struct lua_heapstats_t
+{
+	size_t live; // bytes Lua is using
+	size_t peak; // most bytes Lua has used at once
+	size_t reserved; // bytes taken from the system, including unused slab space
+	UINT32 allocs; // allocations made so far this tic
+	UINT32 ticallocs; // allocations made during the last tic
+};
+
+extern lua_heap_t *gLheap; // heap of gL
+
+lua_heap_t *LUA_NewHeap(void);
+void LUA_DeleteHeap(lua_heap_t *heap); // after lua_close, releases everything at once
+
+// lua_Alloc for lua_newstate, with the heap as its userdata
+void *LUA_HeapAlloc(void *ud, void *ptr, size_t osize, size_t nsize);
+
+const lua_heapstats_t *LUA_HeapStats(const lua_heap_t *heap);
+void LUA_HeapTicker(lua_heap_t *heap);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif/*lua_alloc_h*/
@@ -24,6 +24,7 @@ static const char *const search_opt[] = {
 	"lines",
 	"polyobjs",
 	NULL};
+static int search_fields_ref = LUA_NOREF;
 
 // a quickly-made function pointer typedef used by lib_searchBlockmap...
 // return values:
@@ -226,7 +227,7 @@ static UINT8 lib_searchBlockmap_PolyObjs(lua_State *L, INT32 x, INT32 y, mobj_t
 //   false = searching of at least one block stopped mid-way (including if the whole search was stopped)
 static int lib_searchBlockmap(lua_State *L)
 {
-	int searchtype = luaL_checkoption(L, 1, "objects", search_opt);
+	int searchtype = Lua_checkoption(L, 1, 0, search_fields_ref);
 	int n;
 	mobj_t *mobj;
 	INT32 xl, xh, yl, yh, bx, by;
@@ -311,6 +312,8 @@ static int lib_searchBlockmap(lua_State *L)
 
 int LUA_BlockmapLib(lua_State *L)
 {
+	search_fields_ref = Lua_CreateFieldTable(L, search_opt);
+
 	lua_register(L, "searchBlockmap", lib_searchBlockmap);
 	return 0;
 }
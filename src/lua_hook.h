@@ -118,6 +118,7 @@ ENUM (STRING_HOOK);
 
 extern boolean hook_cmd_running;
 
+boolean LUA_HookIsAvailable(int hook); // any hooks of this type added
 void LUA_HookVoid(int hook);
 void LUA_HookHUD(huddrawlist_h, int hook);
 
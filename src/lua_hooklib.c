@@ -323,6 +323,11 @@ static boolean init_hook_type
 		return false;
 }
 
+boolean LUA_HookIsAvailable(int hook_type)
+{
+	return (hookIds[hook_type].numHooks > 0);
+}
+
 static boolean prepare_hook
 (
 		Hook_State * hook,
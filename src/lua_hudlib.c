@@ -77,6 +77,7 @@ static const char *const patch_opt[] = {
 	"leftoffset",
 	"topoffset",
 	NULL};
+static int patch_fields_ref = LUA_NOREF;
 
 // alignment types for v.drawString
 enum align {
@@ -101,6 +102,7 @@ static const char *const align_opt[] = {
 	"thin-center",
 	"thin-right",
 	NULL};
+static int align_fields_ref = LUA_NOREF;
 
 // width types for v.stringWidth
 enum widtht {
@@ -113,6 +115,7 @@ static const char *const widtht_opt[] = {
 	"small",
 	"thin",
 	NULL};
+static int widtht_fields_ref = LUA_NOREF;
 
 enum cameraf {
 	camera_chase = 0,
@@ -154,6 +157,7 @@ static const char *const camera_opt[] = {
 	"pitch",
 	"pnum",
 	NULL};
+static int camera_fields_ref = LUA_NOREF;
 
 static int colormap_get(lua_State *L)
 {
@@ -168,7 +172,7 @@ static int colormap_get(lua_State *L)
 static int patch_get(lua_State *L)
 {
 	patch_t *patch = *((patch_t **)luaL_checkudata(L, 1, META_PATCH));
-	enum patch field = luaL_checkoption(L, 2, NULL, patch_opt);
+	enum patch field = Lua_checkoption(L, 2, -1, patch_fields_ref);
 
 	// patches are invalidated when switching renderers
 	if (!patch) {
@@ -208,7 +212,7 @@ static int patch_set(lua_State *L)
 static int camera_get(lua_State *L)
 {
 	camera_t *cam = *((camera_t **)luaL_checkudata(L, 1, META_CAMERA));
-	enum cameraf field = luaL_checkoption(L, 2, NULL, camera_opt);
+	enum cameraf field = Lua_checkoption(L, 2, -1, camera_fields_ref);
 
 	// cameras should always be valid unless I'm a nutter
 	I_Assert(cam != NULL);
@@ -803,7 +807,7 @@ static int libd_drawString(lua_State *L)
 	fixed_t y = luaL_checkinteger(L, 2);
 	const char *str = luaL_checkstring(L, 3);
 	INT32 flags = luaL_optinteger(L, 4, 0);
-	enum align align = luaL_checkoption(L, 5, "left", align_opt);
+	enum align align = Lua_checkoption(L, 5, align_left, align_fields_ref);
 
 	flags &= ~V_PARAMMASK; // Don't let crashes happen.
 
@@ -916,7 +920,7 @@ static int libd_stringWidth(lua_State *L)
 {
 	const char *str = luaL_checkstring(L, 1);
 	INT32 flags = luaL_optinteger(L, 2, 0);
-	enum widtht widtht = luaL_checkoption(L, 3, "normal", widtht_opt);
+	enum widtht widtht = Lua_checkoption(L, 3, widtht_normal, widtht_fields_ref);
 
 	HUDONLY
 	switch(widtht)
@@ -1193,6 +1197,11 @@ static luaL_Reg lib_hud[] = {
 
 int LUA_HudLib(lua_State *L)
 {
+	patch_fields_ref = Lua_CreateFieldTable(L, patch_opt);
+	align_fields_ref = Lua_CreateFieldTable(L, align_opt);
+	widtht_fields_ref = Lua_CreateFieldTable(L, widtht_opt);
+	camera_fields_ref = Lua_CreateFieldTable(L, camera_opt);
+
 	memset(hud_enabled, 0xff, (hud_MAX/8)+1);
 
 	lua_newtable(L);
@@ -58,6 +58,7 @@ const char *const sfxinfo_ropt[] = {
 	"skinsound",
 	"string",
 	NULL};
+static int sfxinfo_rfields_ref = LUA_NOREF;
 
 enum sfxinfo_write {
 	sfxinfow_singular = 0,
@@ -73,6 +74,7 @@ const char *const sfxinfo_wopt[] = {
 	"volume",
 	"caption",
 	NULL};
+static int sfxinfo_wfields_ref = LUA_NOREF;
 
 boolean actionsoverridden[NUMACTIONS] = {false};
 
@@ -1435,7 +1437,7 @@ static int lib_setSfxInfo(lua_State *L)
 		if (lua_isnumber(L, 2))
 			i = lua_tointeger(L, 2) - 1; // lua is one based, this enum is zero based.
 		else
-			i = luaL_checkoption(L, 2, NULL, sfxinfo_wopt);
+			i = Lua_checkoption(L, 2, -1, sfxinfo_wfields_ref);
 
 		switch(i)
 		{
@@ -1473,7 +1475,7 @@ static int lib_sfxlen(lua_State *L)
 static int sfxinfo_get(lua_State *L)
 {
 	sfxinfo_t *sfx = *((sfxinfo_t **)luaL_checkudata(L, 1, META_SFXINFO));
-	enum sfxinfo_read field = luaL_checkoption(L, 2, NULL, sfxinfo_ropt);
+	enum sfxinfo_read field = Lua_checkoption(L, 2, -1, sfxinfo_rfields_ref);
 
 	I_Assert(sfx != NULL);
 
@@ -1514,7 +1516,7 @@ static int sfxinfo_get(lua_State *L)
 static int sfxinfo_set(lua_State *L)
 {
 	sfxinfo_t *sfx = *((sfxinfo_t **)luaL_checkudata(L, 1, META_SFXINFO));
-	enum sfxinfo_write field = luaL_checkoption(L, 2, NULL, sfxinfo_wopt);
+	enum sfxinfo_write field = Lua_checkoption(L, 2, -1, sfxinfo_wfields_ref);
 
 	if (hud_running)
 		return luaL_error(L, "Do not alter S_sfx in HUD rendering code!");
@@ -2030,6 +2032,9 @@ static int precipprops_num(lua_State *L)
 //
 int LUA_InfoLib(lua_State *L)
 {
+	sfxinfo_rfields_ref = Lua_CreateFieldTable(L, sfxinfo_ropt);
+	sfxinfo_wfields_ref = Lua_CreateFieldTable(L, sfxinfo_wopt);
+
 	// index of A_Lua actions to run for each state
 	lua_newtable(L);
 	lua_setfield(L, LUA_REGISTRYINDEX, LREG_STATEACTION);
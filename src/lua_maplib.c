@@ -96,6 +96,7 @@ static const char *const sector_opt[] = {
 	"stringargs",
 	"activation",
 	NULL};
+static int sector_fields_ref = LUA_NOREF;
 
 enum subsector_e {
 	subsector_valid = 0,
@@ -112,6 +113,7 @@ static const char *const subsector_opt[] = {
 	"firstline",
 	"polyList",
 	NULL};
+static int subsector_fields_ref = LUA_NOREF;
 
 enum line_e {
 	line_valid = 0,
@@ -164,6 +166,7 @@ static const char *const line_opt[] = {
 	"polyobj",
 	"callcount",
 	NULL};
+static int line_fields_ref = LUA_NOREF;
 
 enum side_e {
 	side_valid = 0,
@@ -190,6 +193,7 @@ static const char *const side_opt[] = {
 	"special",
 	"repeatcnt",
 	NULL};
+static int side_fields_ref = LUA_NOREF;
 
 enum vertex_e {
 	vertex_valid = 0,
@@ -210,6 +214,7 @@ static const char *const vertex_opt[] = {
 	"ceilingz",
 	"ceilingzset",
 	NULL};
+static int vertex_fields_ref = LUA_NOREF;
 
 enum ffloor_e {
 	ffloor_valid = 0,
@@ -262,6 +267,7 @@ static const char *const ffloor_opt[] = {
 	"friction",
 	"bouncestrength",
 	NULL};
+static int ffloor_fields_ref = LUA_NOREF;
 
 #ifdef HAVE_LUA_SEGS
 enum seg_e {
@@ -291,6 +297,7 @@ static const char *const seg_opt[] = {
 	"backsector",
 	"polyseg",
 	NULL};
+static int seg_fields_ref = LUA_NOREF;
 
 enum node_e {
 	node_valid = 0,
@@ -311,6 +318,7 @@ static const char *const node_opt[] = {
 	"bbox",
 	"children",
 	NULL};
+static int node_fields_ref = LUA_NOREF;
 
 enum nodechild_e {
 	nodechild_valid = 0,
@@ -323,6 +331,7 @@ static const char *const nodechild_opt[] = {
 	"right",
 	"left",
 	NULL};
+static int nodechild_fields_ref = LUA_NOREF;
 #endif
 
 enum bbox_e {
@@ -340,6 +349,7 @@ static const char *const bbox_opt[] = {
 	"left",
 	"right",
 	NULL};
+static int bbox_fields_ref = LUA_NOREF;
 
 enum slope_e {
 	slope_valid = 0,
@@ -362,6 +372,7 @@ static const char *const slope_opt[] = {
 	"xydirection",
 	"flags",
 	NULL};
+static int slope_fields_ref = LUA_NOREF;
 
 // shared by both vector2_t and vector3_t
 enum vector_e {
@@ -375,6 +386,7 @@ static const char *const vector_opt[] = {
 	"y",
 	"z",
 	NULL};
+static int vector_fields_ref = LUA_NOREF;
 
 enum activator_e {
 	activator_valid = 0,
@@ -393,9 +405,12 @@ static const char *const activator_opt[] = {
 	"sector",
 	"po",
 	NULL};
+static int activator_fields_ref = LUA_NOREF;
 
 static const char *const array_opt[] ={"iterate",NULL};
+static int array_fields_ref = LUA_NOREF;
 static const char *const valid_opt[] ={"valid",NULL};
+static int valid_fields_ref = LUA_NOREF;
 
 /////////////////////////////////////////////
 // sector/subsector list iterate functions //
@@ -533,7 +548,7 @@ static int sectorlines_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, -1, valid_fields_ref);
 		if (!seclines || !(*seclines))
 		{
 			if (field == 0) {
@@ -636,7 +651,7 @@ static int sectorstringargs_len(lua_State *L)
 static int sector_get(lua_State *L)
 {
 	sector_t *sector = *((sector_t **)luaL_checkudata(L, 1, META_SECTOR));
-	enum sector_e field = luaL_checkoption(L, 2, sector_opt[0], sector_opt);
+	enum sector_e field = Lua_checkoption(L, 2, sector_valid, sector_fields_ref);
 	INT16 i;
 
 	if (!sector)
@@ -770,7 +785,7 @@ static int sector_get(lua_State *L)
 static int sector_set(lua_State *L)
 {
 	sector_t *sector = *((sector_t **)luaL_checkudata(L, 1, META_SECTOR));
-	enum sector_e field = luaL_checkoption(L, 2, sector_opt[0], sector_opt);
+	enum sector_e field = Lua_checkoption(L, 2, sector_valid, sector_fields_ref);
 
 	if (!sector)
 		return luaL_error(L, "accessed sector_t doesn't exist anymore.");
@@ -895,7 +910,7 @@ static int sector_num(lua_State *L)
 static int subsector_get(lua_State *L)
 {
 	subsector_t *subsector = *((subsector_t **)luaL_checkudata(L, 1, META_SUBSECTOR));
-	enum subsector_e field = luaL_checkoption(L, 2, subsector_opt[0], subsector_opt);
+	enum subsector_e field = Lua_checkoption(L, 2, subsector_valid, subsector_fields_ref);
 
 	if (!subsector)
 	{
@@ -979,7 +994,7 @@ static int linestringargs_len(lua_State *L)
 static int line_get(lua_State *L)
 {
 	line_t *line = *((line_t **)luaL_checkudata(L, 1, META_LINE));
-	enum line_e field = luaL_checkoption(L, 2, line_opt[0], line_opt);
+	enum line_e field = Lua_checkoption(L, 2, line_valid, line_fields_ref);
 
 	if (!line)
 	{
@@ -1110,7 +1125,7 @@ static int sidenum_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, -1, valid_fields_ref);
 		if (!sidenum)
 		{
 			if (field == 0) {
@@ -1138,7 +1153,7 @@ static int sidenum_get(lua_State *L)
 static int side_get(lua_State *L)
 {
 	side_t *side = *((side_t **)luaL_checkudata(L, 1, META_SIDE));
-	enum side_e field = luaL_checkoption(L, 2, side_opt[0], side_opt);
+	enum side_e field = Lua_checkoption(L, 2, side_valid, side_fields_ref);
 
 	if (!side)
 	{
@@ -1188,7 +1203,7 @@ static int side_get(lua_State *L)
 static int side_set(lua_State *L)
 {
 	side_t *side = *((side_t **)luaL_checkudata(L, 1, META_SIDE));
-	enum side_e field = luaL_checkoption(L, 2, side_opt[0], side_opt);
+	enum side_e field = Lua_checkoption(L, 2, side_valid, side_fields_ref);
 
 	if (!side)
 	{
@@ -1243,7 +1258,7 @@ static int side_num(lua_State *L)
 static int vertex_get(lua_State *L)
 {
 	vertex_t *vertex = *((vertex_t **)luaL_checkudata(L, 1, META_VERTEX));
-	enum vertex_e field = luaL_checkoption(L, 2, vertex_opt[0], vertex_opt);
+	enum vertex_e field = Lua_checkoption(L, 2, vertex_valid, vertex_fields_ref);
 
 	if (!vertex)
 	{
@@ -1297,7 +1312,7 @@ static int vertex_num(lua_State *L)
 static int seg_get(lua_State *L)
 {
 	seg_t *seg = *((seg_t **)luaL_checkudata(L, 1, META_SEG));
-	enum seg_e field = luaL_checkoption(L, 2, seg_opt[0], seg_opt);
+	enum seg_e field = Lua_checkoption(L, 2, seg_valid, seg_fields_ref);
 
 	if (!seg)
 	{
@@ -1361,7 +1376,7 @@ static int seg_num(lua_State *L)
 static int node_get(lua_State *L)
 {
 	node_t *node = *((node_t **)luaL_checkudata(L, 1, META_NODE));
-	enum node_e field = luaL_checkoption(L, 2, node_opt[0], node_opt);
+	enum node_e field = Lua_checkoption(L, 2, node_valid, node_fields_ref);
 
 	if (!node)
 	{
@@ -1422,7 +1437,7 @@ static int nodebbox_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, -1, valid_fields_ref);
 		if (!bbox)
 		{
 			if (field == 0) {
@@ -1455,7 +1470,7 @@ static int nodebbox_call(lua_State *L)
 		return luaL_error(L, "arguments 2 and/or 3 not given (expected node.bbox(child, coord))");
 	// get child
 	if (!lua_isnumber(L, 2)) {
-		enum nodechild_e field = luaL_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
+		enum nodechild_e field = Lua_checkoption(L, 2, nodechild_valid, nodechild_fields_ref);
 		switch (field) {
 			case nodechild_right: i = 0; break;
 			case nodechild_left:  i = 1; break;
@@ -1470,7 +1485,7 @@ static int nodebbox_call(lua_State *L)
 	}
 	// get bbox coord
 	if (!lua_isnumber(L, 3)) {
-		enum bbox_e field = luaL_checkoption(L, 3, bbox_opt[0], bbox_opt);
+		enum bbox_e field = Lua_checkoption(L, 3, bbox_valid, bbox_fields_ref);
 		switch (field) {
 			case bbox_top:    j = BOXTOP;    break;
 			case bbox_bottom: j = BOXBOTTOM; break;
@@ -1501,7 +1516,7 @@ static int nodechildren_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		enum nodechild_e field = luaL_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
+		enum nodechild_e field = Lua_checkoption(L, 2, nodechild_valid, nodechild_fields_ref);
 		if (!children)
 		{
 			if (field == nodechild_valid) {
@@ -1541,7 +1556,7 @@ static int bbox_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		enum bbox_e field = luaL_checkoption(L, 2, bbox_opt[0], bbox_opt);
+		enum bbox_e field = Lua_checkoption(L, 2, bbox_valid, bbox_fields_ref);
 		if (!bbox)
 		{
 			if (field == bbox_valid) {
@@ -1647,7 +1662,7 @@ static int lib_getSubsector(lua_State *L)
 		LUA_PushUserdata(L, &subsectors[i], META_SUBSECTOR);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, -1, array_fields_ref);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1741,7 +1756,7 @@ static int lib_getSide(lua_State *L)
 		LUA_PushUserdata(L, &sides[i], META_SIDE);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, -1, array_fields_ref);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1793,7 +1808,7 @@ static int lib_getVertex(lua_State *L)
 		LUA_PushUserdata(L, &vertexes[i], META_VERTEX);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, -1, array_fields_ref);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1847,7 +1862,7 @@ static int lib_getSeg(lua_State *L)
 		LUA_PushUserdata(L, &segs[i], META_SEG);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, -1, array_fields_ref);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1899,7 +1914,7 @@ static int lib_getNode(lua_State *L)
 		LUA_PushUserdata(L, &nodes[i], META_NODE);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, -1, array_fields_ref);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1997,7 +2012,7 @@ static INT32 P_GetOldFOFFlags(ffloor_t *fflr)
 static int ffloor_get(lua_State *L)
 {
 	ffloor_t *ffloor = *((ffloor_t **)luaL_checkudata(L, 1, META_FFLOOR));
-	enum ffloor_e field = luaL_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
+	enum ffloor_e field = Lua_checkoption(L, 2, ffloor_valid, ffloor_fields_ref);
 	INT16 i;
 
 	if (!ffloor)
@@ -2179,7 +2194,7 @@ static void P_SetOldFOFFlags(ffloor_t *fflr, oldffloortype_e oldflags)
 static int ffloor_set(lua_State *L)
 {
 	ffloor_t *ffloor = *((ffloor_t **)luaL_checkudata(L, 1, META_FFLOOR));
-	enum ffloor_e field = luaL_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
+	enum ffloor_e field = Lua_checkoption(L, 2, ffloor_valid, ffloor_fields_ref);
 
 	if (!ffloor)
 		return luaL_error(L, "accessed ffloor_t doesn't exist anymore.");
@@ -2274,7 +2289,7 @@ static int ffloor_set(lua_State *L)
 static int slope_get(lua_State *L)
 {
 	pslope_t *slope = *((pslope_t **)luaL_checkudata(L, 1, META_SLOPE));
-	enum slope_e field = luaL_checkoption(L, 2, slope_opt[0], slope_opt);
+	enum slope_e field = Lua_checkoption(L, 2, slope_valid, slope_fields_ref);
 
 	if (!slope)
 	{
@@ -2318,7 +2333,7 @@ static int slope_get(lua_State *L)
 static int slope_set(lua_State *L)
 {
 	pslope_t *slope = *((pslope_t **)luaL_checkudata(L, 1, META_SLOPE));
-	enum slope_e field = luaL_checkoption(L, 2, slope_opt[0], slope_opt);
+	enum slope_e field = Lua_checkoption(L, 2, slope_valid, slope_fields_ref);
 
 	if (!slope)
 		return luaL_error(L, "accessed pslope_t doesn't exist anymore.");
@@ -2408,7 +2423,7 @@ static int slope_set(lua_State *L)
 static int vector2_get(lua_State *L)
 {
 	vector2_t *vec = *((vector2_t **)luaL_checkudata(L, 1, META_VECTOR2));
-	enum vector_e field = luaL_checkoption(L, 2, vector_opt[0], vector_opt);
+	enum vector_e field = Lua_checkoption(L, 2, vector_x, vector_fields_ref);
 
 	if (!vec)
 		return luaL_error(L, "accessed vector2_t doesn't exist anymore.");
@@ -2426,7 +2441,7 @@ static int vector2_get(lua_State *L)
 static int vector3_get(lua_State *L)
 {
 	vector3_t *vec = *((vector3_t **)luaL_checkudata(L, 1, META_VECTOR3));
-	enum vector_e field = luaL_checkoption(L, 2, vector_opt[0], vector_opt);
+	enum vector_e field = Lua_checkoption(L, 2, vector_x, vector_fields_ref);
 
 	if (!vec)
 		return luaL_error(L, "accessed vector3_t doesn't exist anymore.");
@@ -2462,7 +2477,7 @@ static int lib_getMapheaderinfo(lua_State *L)
 		//CONS_Printf(mapheaderinfo[i]->lvlttl);
 		return 1;
 	}/*
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, -1, array_fields_ref);
 	switch(field)
 	{
 	case 0: // iterate
@@ -2593,7 +2608,7 @@ static int mapheaderinfo_get(lua_State *L)
 static int activator_get(lua_State *L)
 {
 	activator_t *activator = *((activator_t **)luaL_checkudata(L, 1, META_ACTIVATOR));
-	enum activator_e field = luaL_checkoption(L, 2, activator_opt[0], activator_opt);
+	enum activator_e field = Lua_checkoption(L, 2, activator_valid, activator_fields_ref);
 
 	if (activator == NULL)
 	{
@@ -2641,6 +2656,24 @@ static int activator_get(lua_State *L)
 
 int LUA_MapLib(lua_State *L)
 {
+	sector_fields_ref = Lua_CreateFieldTable(L, sector_opt);
+	subsector_fields_ref = Lua_CreateFieldTable(L, subsector_opt);
+	line_fields_ref = Lua_CreateFieldTable(L, line_opt);
+	side_fields_ref = Lua_CreateFieldTable(L, side_opt);
+	vertex_fields_ref = Lua_CreateFieldTable(L, vertex_opt);
+	ffloor_fields_ref = Lua_CreateFieldTable(L, ffloor_opt);
+#ifdef HAVE_LUA_SEGS
+	seg_fields_ref = Lua_CreateFieldTable(L, seg_opt);
+	node_fields_ref = Lua_CreateFieldTable(L, node_opt);
+	nodechild_fields_ref = Lua_CreateFieldTable(L, nodechild_opt);
+#endif
+	bbox_fields_ref = Lua_CreateFieldTable(L, bbox_opt);
+	slope_fields_ref = Lua_CreateFieldTable(L, slope_opt);
+	vector_fields_ref = Lua_CreateFieldTable(L, vector_opt);
+	activator_fields_ref = Lua_CreateFieldTable(L, activator_opt);
+	array_fields_ref = Lua_CreateFieldTable(L, array_opt);
+	valid_fields_ref = Lua_CreateFieldTable(L, valid_opt);
+
 	luaL_newmetatable(L, META_SECTORLINES);
 		lua_pushcfunction(L, sectorlines_get);
 		lua_setfield(L, -2, "__index");
@@ -206,13 +206,14 @@ static const char *const mobj_opt[] = {
 	"punt_ref",
 	"owner",
 	NULL};
+static int mobj_fields_ref = LUA_NOREF;
 
 #define UNIMPLEMENTED luaL_error(L, LUA_QL("mobj_t") " field " LUA_QS " is not implemented for Lua and cannot be accessed.", mobj_opt[field])
 
 static int mobj_get(lua_State *L)
 {
 	mobj_t *mo = *((mobj_t **)luaL_checkudata(L, 1, META_MOBJ));
-	enum mobj_e field = Lua_optoption(L, 2, NULL, mobj_opt);
+	enum mobj_e field = Lua_optoption(L, 2, -1, mobj_fields_ref);
 	lua_settop(L, 2);
 
 	if (!mo || !ISINLEVEL) {
@@ -556,7 +557,7 @@ static int mobj_get(lua_State *L)
 static int mobj_set(lua_State *L)
 {
 	mobj_t *mo = *((mobj_t **)luaL_checkudata(L, 1, META_MOBJ));
-	enum mobj_e field = Lua_optoption(L, 2, mobj_opt[0], mobj_opt);
+	enum mobj_e field = Lua_optoption(L, 2, mobj_valid, mobj_fields_ref);
 	lua_settop(L, 3);
 
 	INLEVEL
@@ -857,6 +858,8 @@ static int mobj_set(lua_State *L)
 		return NOSET;
 	case mobj_lastlook:
 		mo->lastlook = luaL_checkinteger(L, 3);
+		if (mo->type == MT_WAYPOINT)
+			K_InvalidateFinishDistances();
 		break;
 	case mobj_spawnpoint:
 		if (lua_isnil(L, 3))
@@ -916,6 +919,8 @@ static int mobj_set(lua_State *L)
 		break;
 	case mobj_extravalue1:
 		mo->extravalue1 = luaL_checkinteger(L, 3);
+		if (mo->type == MT_WAYPOINT)
+			K_InvalidateFinishDistances();
 		break;
 	case mobj_extravalue2:
 		mo->extravalue2 = luaL_checkinteger(L, 3);
@@ -1179,6 +1184,8 @@ static int lib_nummapthings(lua_State *L)
 
 int LUA_MobjLib(lua_State *L)
 {
+	mobj_fields_ref = Lua_CreateFieldTable(L, mobj_opt);
+
 	luaL_newmetatable(L, META_MOBJ);
 		lua_pushcfunction(L, mobj_get);
 		lua_setfield(L, -2, "__index");
@@ -35,12 +35,14 @@
 #include "lua_script.h"
 #include "lua_libs.h"
 #include "lua_hook.h"
+#include "lua_alloc.h"
 
 #include "doomstat.h"
 #include "g_state.h"
 #include "m_argv.h"
 
 lua_State *gL = NULL;
+lua_heap_t *gLheap = NULL;
 
 // List of internal libraries to load from SRB2
 static lua_CFunction liblist[] = {
@@ -64,18 +66,6 @@ static lua_CFunction liblist[] = {
 	NULL
 };
 
-// Lua asks for memory using this.
-static void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
-{
-	(void)ud;
-	if (nsize == 0) {
-		if (osize != 0)
-			Z_Free(ptr);
-		return NULL;
-	} else
-		return Z_Realloc(ptr, nsize, PU_LUA, NULL);
-}
-
 // Panic function Lua calls when there's an unprotected error.
 // This function cannot return. Lua would kill the application anyway if it did.
 FUNCNORETURN static int LUA_Panic(lua_State *L)
@@ -152,238 +142,401 @@ int LUA_Call(lua_State *L, int nargs, int nresults, int errorhandlerindex)
 	return err;
 }
 
+enum globals_e {
+	global_gamemap = 0,
+	global_udmf,
+	global_maptol,
+	global_stoppedclock,
+	global_netgame,
+	global_multiplayer,
+	global_modeattacking,
+	global_splitscreen,
+	global_gamecomplete,
+	global_marathonmode,
+	global_devparm,
+	global_modifiedgame,
+	global_menuactive,
+	global_paused,
+	global_bluescore,
+	global_redscore,
+	global_timelimit,
+	global_pointlimit,
+	global_titlemap,
+	global_titlemapinaction,
+	global_bootmap,
+	global_podiummap,
+	global_tutorialchallengemap,
+	global_skincolor_redteam,
+	global_skincolor_blueteam,
+	global_skincolor_redring,
+	global_skincolor_bluering,
+	global_invulntics,
+	global_sneakertics,
+	global_flashingtics,
+	global_tailsflytics,
+	global_underwatertics,
+	global_spacetimetics,
+	global_extralifetics,
+	global_nightslinktics,
+	global_gameovertics,
+	global_ammoremovaltics,
+	global_gametype,
+	global_gametyperules,
+	global_leveltime,
+	global_introtime,
+	global_starttime,
+	global_curweather,
+	global_globalweather,
+	global_levelskytexture,
+	global_globallevelskytexture,
+	global_mapmusname,
+	global_mapmusposition,
+	global_mapmusrng,
+	global_consoleplayer,
+	global_isserver,
+	global_isdedicatedserver,
+	global_server,
+	global_gravity,
+	global_VERSION,
+	global_SUBVERSION,
+	global_VERSIONSTRING,
+	global_APPLICATION,
+	global_gamespeed,
+	global_encoremode,
+	global_franticitems,
+	global_wantedcalcdelay,
+	global_thwompsactive,
+	global_lastlowestlap,
+	global_spbplace,
+	global_mapobjectscale,
+	global_numlaps,
+	global_racecountdown,
+	global_exitcountdown,
+	global_replayplayback,
+	global_replaynumskins,
+	global_gamestate,
+};
+
+static const char *const globals_opt[] = {
+	"gamemap",
+	"udmf",
+	"maptol",
+	"stoppedclock",
+	"netgame",
+	"multiplayer",
+	"modeattacking",
+	"splitscreen",
+	"gamecomplete",
+	"marathonmode",
+	"devparm",
+	"modifiedgame",
+	"menuactive",
+	"paused",
+	"bluescore",
+	"redscore",
+	"timelimit",
+	"pointlimit",
+	"titlemap",
+	"titlemapinaction",
+	"bootmap",
+	"podiummap",
+	"tutorialchallengemap",
+	"skincolor_redteam",
+	"skincolor_blueteam",
+	"skincolor_redring",
+	"skincolor_bluering",
+	"invulntics",
+	"sneakertics",
+	"flashingtics",
+	"tailsflytics",
+	"underwatertics",
+	"spacetimetics",
+	"extralifetics",
+	"nightslinktics",
+	"gameovertics",
+	"ammoremovaltics",
+	"gametype",
+	"gametyperules",
+	"leveltime",
+	"introtime",
+	"starttime",
+	"curweather",
+	"globalweather",
+	"levelskytexture",
+	"globallevelskytexture",
+	"mapmusname",
+	"mapmusposition",
+	"mapmusrng",
+	"consoleplayer",
+	"isserver",
+	"isdedicatedserver",
+	"server",
+	"gravity",
+	"VERSION",
+	"SUBVERSION",
+	"VERSIONSTRING",
+	"APPLICATION",
+	"gamespeed",
+	"encoremode",
+	"franticitems",
+	"wantedcalcdelay",
+	"thwompsactive",
+	"lastlowestlap",
+	"spbplace",
+	"mapobjectscale",
+	"numlaps",
+	"racecountdown",
+	"exitcountdown",
+	"replayplayback",
+	"replaynumskins",
+	"gamestate",
+	NULL};
+static int globals_fields_ref = LUA_NOREF;
+
 // Moved here from lib_getenum.
 int LUA_PushGlobals(lua_State *L, const char *word)
 {
-	if (fastcmp(word,"gamemap")) {
+	enum globals_e field = -1;
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, globals_fields_ref);
+	lua_getfield(L, -1, word);
+	if (lua_isnumber(L, -1))
+		field = lua_tointeger(L, -1);
+	lua_pop(L, 2);
+
+	switch (field)
+	{
+	case global_gamemap:
 		lua_pushinteger(L, gamemap);
 		return 1;
-	} else if (fastcmp(word,"udmf")) {
+	case global_udmf:
 		lua_pushboolean(L, udmf);
 		return 1;
-	} else if (fastcmp(word,"maptol")) {
+	case global_maptol:
 		lua_pushinteger(L, maptol);
 		return 1;
-	} else if (fastcmp(word,"stoppedclock")) {
+	case global_stoppedclock:
 		lua_pushboolean(L, stoppedclock);
 		return 1;
-	} else if (fastcmp(word,"netgame")) {
+	case global_netgame:
 		lua_pushboolean(L, netgame);
 		return 1;
-	} else if (fastcmp(word,"multiplayer")) {
+	case global_multiplayer:
 		lua_pushboolean(L, multiplayer);
 		return 1;
-	} else if (fastcmp(word,"modeattacking")) {
+	case global_modeattacking:
 		lua_pushboolean(L, modeattacking);
 		return 1;
-	} else if (fastcmp(word,"splitscreen")) {
+	case global_splitscreen:
 		lua_pushinteger(L, splitscreen);
 		return 1;
-	} else if (fastcmp(word,"gamecomplete")) {
+	case global_gamecomplete:
 		lua_pushboolean(L, (gamecomplete != 0));
 		return 1;
-	} else if (fastcmp(word,"marathonmode")) {
+	case global_marathonmode:
 		lua_pushinteger(L, marathonmode);
 		return 1;
-	} else if (fastcmp(word,"devparm")) {
+	case global_devparm:
 		lua_pushboolean(L, devparm);
 		return 1;
-	} else if (fastcmp(word,"modifiedgame")) {
+	case global_modifiedgame:
 		lua_pushboolean(L, modifiedgame && !savemoddata);
 		return 1;
-	} else if (fastcmp(word,"menuactive")) {
+	case global_menuactive:
 		lua_pushboolean(L, menuactive);
 		return 1;
-	} else if (fastcmp(word,"paused")) {
+	case global_paused:
 		lua_pushboolean(L, paused);
 		return 1;
-	} else if (fastcmp(word,"bluescore")) {
+	case global_bluescore:
 		lua_pushinteger(L, bluescore);
 		return 1;
-	} else if (fastcmp(word,"redscore")) {
+	case global_redscore:
 		lua_pushinteger(L, redscore);
 		return 1;
-	} else if (fastcmp(word,"timelimit")) {
+	case global_timelimit:
 		lua_pushinteger(L, timelimitintics);
 		return 1;
-	} else if (fastcmp(word,"pointlimit")) {
+	case global_pointlimit:
 		lua_pushinteger(L, g_pointlimit);
 		return 1;
 	// begin map vars
-	} else if (fastcmp(word,"titlemap")) {
+	case global_titlemap:
 		lua_pushstring(L, titlemap);
 		return 1;
-	} else if (fastcmp(word,"titlemapinaction")) {
+	case global_titlemapinaction:
 		lua_pushboolean(L, titlemapinaction);
 		return 1;
-	} else if (fastcmp(word,"bootmap")) {
+	case global_bootmap:
 		lua_pushstring(L, bootmap);
 		return 1;
-	} else if (fastcmp(word,"podiummap")) {
+	case global_podiummap:
 		lua_pushstring(L, podiummap);
 		return 1;
-	} else if (fastcmp(word,"tutorialchallengemap")) {
+	case global_tutorialchallengemap:
 		lua_pushstring(L, tutorialchallengemap);
 		return 1;
 	// end map vars
 	// begin CTF colors
-	} else if (fastcmp(word,"skincolor_redteam")) {
+	case global_skincolor_redteam:
 		lua_pushinteger(L, skincolor_redteam);
 		return 1;
-	} else if (fastcmp(word,"skincolor_blueteam")) {
+	case global_skincolor_blueteam:
 		lua_pushinteger(L, skincolor_blueteam);
 		return 1;
-	} else if (fastcmp(word,"skincolor_redring")) {
+	case global_skincolor_redring:
 		lua_pushinteger(L, skincolor_redring);
 		return 1;
-	} else if (fastcmp(word,"skincolor_bluering")) {
+	case global_skincolor_bluering:
 		lua_pushinteger(L, skincolor_bluering);
 		return 1;
 	// end CTF colors
 	// begin timers
-	} else if (fastcmp(word,"invulntics")) {
+	case global_invulntics:
 		lua_pushinteger(L, invulntics);
 		return 1;
-	} else if (fastcmp(word,"sneakertics")) {
+	case global_sneakertics:
 		lua_pushinteger(L, sneakertics);
 		return 1;
-	} else if (fastcmp(word,"flashingtics")) {
+	case global_flashingtics:
 		lua_pushinteger(L, flashingtics);
 		return 1;
-	} else if (fastcmp(word,"tailsflytics")) {
+	case global_tailsflytics:
 		lua_pushinteger(L, tailsflytics);
 		return 1;
-	} else if (fastcmp(word,"underwatertics")) {
+	case global_underwatertics:
 		lua_pushinteger(L, underwatertics);
 		return 1;
-	} else if (fastcmp(word,"spacetimetics")) {
+	case global_spacetimetics:
 		lua_pushinteger(L, spacetimetics);
 		return 1;
-	} else if (fastcmp(word,"extralifetics")) {
+	case global_extralifetics:
 		lua_pushinteger(L, extralifetics);
 		return 1;
-	} else if (fastcmp(word,"nightslinktics")) {
+	case global_nightslinktics:
 		lua_pushinteger(L, nightslinktics);
 		return 1;
-	} else if (fastcmp(word,"gameovertics")) {
+	case global_gameovertics:
 		lua_pushinteger(L, gameovertics);
 		return 1;
-	} else if (fastcmp(word,"ammoremovaltics")) {
+	case global_ammoremovaltics:
 		lua_pushinteger(L, ammoremovaltics);
 		return 1;
 	// end timers
-	} else if (fastcmp(word,"gametype")) {
+	case global_gametype:
 		lua_pushinteger(L, gametype);
 		return 1;
-	} else if (fastcmp(word,"gametyperules")) {
+	case global_gametyperules:
 		lua_pushinteger(L, gametyperules);
 		return 1;
-	} else if (fastcmp(word,"leveltime")) {
+	case global_leveltime:
 		lua_pushinteger(L, leveltime);
 		return 1;
-	} else if (fastcmp(word,"introtime")) {
+	case global_introtime:
 		lua_pushinteger(L, introtime);
 		return 1;
-	} else if (fastcmp(word,"starttime")) {
+	case global_starttime:
 		lua_pushinteger(L, starttime);
 		return 1;
-	} else if (fastcmp(word,"curweather")) {
+	case global_curweather:
 		lua_pushinteger(L, curWeather);
 		return 1;
-	} else if (fastcmp(word,"globalweather")) {
+	case global_globalweather:
 		lua_pushinteger(L, globalweather);
 		return 1;
-	} else if (fastcmp(word,"levelskytexture")) {
+	case global_levelskytexture:
 		lua_pushstring(L, levelskytexture);
 		return 1;
-	} else if (fastcmp(word,"globallevelskytexture")) {
+	case global_globallevelskytexture:
 		lua_pushstring(L, globallevelskytexture);
 		return 1;
-	} else if (fastcmp(word,"mapmusname")) {
+	case global_mapmusname:
 		lua_pushstring(L, mapmusname);
 		return 1;
-	} else if (fastcmp(word,"mapmusposition")) {
+	case global_mapmusposition:
 		lua_pushinteger(L, mapmusposition);
 		return 1;
-	} else if (fastcmp(word,"mapmusrng")) {
+	case global_mapmusrng:
 		lua_pushinteger(L, mapmusrng);
 		return 1;
 	// local player variables, by popular request
-	} else if (fastcmp(word,"consoleplayer")) { // player controlling console (aka local player 1)
+	case global_consoleplayer: // player controlling console (aka local player 1)
 		if (!addedtogame || consoleplayer < 0 || !playeringame[consoleplayer])
 			return 0;
 		LUA_PushUserdata(L, &players[consoleplayer], META_PLAYER);
 		return 1;
-	} else if (fastcmp(word,"isserver")) {
+	case global_isserver:
 		lua_pushboolean(L, server);
 		return 1;
-	} else if (fastcmp(word,"isdedicatedserver")) {
+	case global_isdedicatedserver:
 		lua_pushboolean(L, dedicated);
 		return 1;
 	// end local player variables
-	} else if (fastcmp(word,"server")) {
+	case global_server:
 		if ((!multiplayer || !netgame) && !playeringame[serverplayer])
 			return 0;
 		LUA_PushUserdata(L, &players[serverplayer], META_PLAYER);
 		return 1;
-	} else if (fastcmp(word,"gravity")) {
+	case global_gravity:
 		lua_pushinteger(L, gravity);
 		return 1;
-	} else if (fastcmp(word,"VERSION")) {
+	case global_VERSION:
 		lua_pushinteger(L, VERSION);
 		return 1;
-	} else if (fastcmp(word,"SUBVERSION")) {
+	case global_SUBVERSION:
 		lua_pushinteger(L, SUBVERSION);
 		return 1;
-	} else if (fastcmp(word,"VERSIONSTRING")) {
+	case global_VERSIONSTRING:
 		lua_pushstring(L, VERSIONSTRING);
 		return 1;
-	} else if (fastcmp(word,"APPLICATION")) {
+	case global_APPLICATION:
 		// I don't know, I just thought it would be cool for a wad to potentially know what mod it was loaded into.
 		lua_pushstring(L, SRB2APPLICATION);
 		return 1;
-	} else if (fastcmp(word,"gamespeed")) {
+	case global_gamespeed:
 		lua_pushinteger(L, gamespeed);
 		return 1;
-	} else if (fastcmp(word,"encoremode")) {
+	case global_encoremode:
 		lua_pushboolean(L, encoremode);
 		return 1;
-	} else if (fastcmp(word,"franticitems")) {
+	case global_franticitems:
 		lua_pushboolean(L, franticitems);
 		return 1;
-	} else if (fastcmp(word,"wantedcalcdelay")) {
+	case global_wantedcalcdelay:
 		lua_pushinteger(L, wantedcalcdelay);
 		return 1;
-	} else if (fastcmp(word,"thwompsactive")) {
+	case global_thwompsactive:
 		lua_pushboolean(L, thwompsactive);
 		return 1;
-	} else if (fastcmp(word,"lastlowestlap")) {
+	case global_lastlowestlap:
 		lua_pushinteger(L, lastLowestLap);
 		return 1;
-	} else if (fastcmp(word,"spbplace")) {
+	case global_spbplace:
 		lua_pushinteger(L, spbplace);
 		return 1;
-	} else if (fastcmp(word,"mapobjectscale")) {
+	case global_mapobjectscale:
 		lua_pushinteger(L, mapobjectscale);
 		return 1;
-	} else if (fastcmp(word,"numlaps")) {
+	case global_numlaps:
 		lua_pushinteger(L, numlaps);
 		return 1;
-	} else if (fastcmp(word,"racecountdown")) {
+	case global_racecountdown:
 		lua_pushinteger(L, racecountdown);
 		return 1;
-	} else if (fastcmp(word,"exitcountdown")) {
+	case global_exitcountdown:
 		lua_pushinteger(L, exitcountdown);	// This name is pretty dumb. Hence why we'll prefer more descriptive names at least in Lua...
 		return 1;
-	} else if (fastcmp(word,"replayplayback")) {
+	case global_replayplayback:
 		lua_pushboolean(L, demo.playback);
 		return 1;
-	} else if (fastcmp(word,"replaynumskins")) {
+	case global_replaynumskins:
 		lua_pushinteger(L, (demo.playback ? demo.numskins : numskins));
 		return 1;
-	} else if (fastcmp(word, "gamestate")) {
+	case global_gamestate:
 		lua_pushinteger(L, gamestate);
 		return 1;
+	default:
+		break;
 	}
 
 	return 0;
@@ -496,10 +649,15 @@ void LUA_ClearState(void)
 		lua_close(gL);
 	gL = NULL;
 
+	// Anything lua_close left behind goes with the heap.
+	LUA_DeleteHeap(gLheap);
+	gLheap = NULL;
+
 	CONS_Printf(M_GetText("Pardon me while I initialize the Lua scripting interface...\n"));
 
 	// allocate state
-	L = lua_newstate(LUA_Alloc, NULL);
+	gLheap = LUA_NewHeap();
+	L = lua_newstate(LUA_HeapAlloc, gLheap);
 	lua_atpanic(L, LUA_Panic);
 
 	// open base libraries
@@ -514,6 +672,9 @@ void LUA_ClearState(void)
 	lua_newtable(L);
 	lua_setfield(L, LUA_REGISTRYINDEX, LREG_METATABLES);
 
+	// field table for LUA_PushGlobals
+	globals_fields_ref = Lua_CreateFieldTable(L, globals_opt);
+
 	// open srb2 libraries
 	for(i = 0; liblist[i]; i++) {
 		lua_pushcfunction(L, liblist[i]);
@@ -579,6 +740,7 @@ static inline void LUA_LoadFile(MYFILE *f, char *name, boolean noresults)
 void LUA_LoadLump(UINT16 wad, UINT16 lump, boolean noresults)
 {
 	MYFILE f;
+	const void *view;
 	char *name;
 	size_t len;
 
@@ -589,8 +751,17 @@ void LUA_LoadLump(UINT16 wad, UINT16 lump, boolean noresults)
 
 	f.wad = wad;
 	f.size = W_LumpLengthPwad(wad, lump);
-	f.data = Z_Malloc(f.size, PU_LUA, NULL);
-	W_ReadLumpPwad(wad, lump, f.data);
+	view = W_GetLumpDataPwad(wad, lump);
+	if (view != NULL)
+	{
+		// The script is only read, so it can be loaded straight from the mapped file
+		f.data = (char *)view;
+	}
+	else
+	{
+		f.data = Z_Malloc(f.size, PU_LUA, NULL);
+		W_ReadLumpPwad(wad, lump, f.data);
+	}
 	f.curpos = f.data;
 
 	len = strlen(wadfiles[wad]->filename); // length of file name
@@ -616,7 +787,8 @@ void LUA_LoadLump(UINT16 wad, UINT16 lump, boolean noresults)
 	    G_SetGameModified(multiplayer, true);
 
 	free(name);
-	Z_Free(f.data);
+	if (view == NULL)
+		Z_Free(f.data);
 }
 
 #ifdef LUA_ALLOW_BYTECODE
@@ -692,13 +864,15 @@ void LUA_DumpFile(const char *filename)
 fixed_t LUA_EvalMath(const char *word)
 {
 	lua_State *L = NULL;
+	lua_heap_t *heap;
 	char buf[1024], *b;
 	const char *p;
 	fixed_t res = 0;
 
 	// make a new state so SOC can't interefere with scripts
 	// allocate state
-	L = lua_newstate(LUA_Alloc, NULL);
+	heap = LUA_NewHeap();
+	L = lua_newstate(LUA_HeapAlloc, heap);
 	lua_atpanic(L, LUA_Panic);
 
 	// open only enum lib
@@ -735,6 +909,7 @@ fixed_t LUA_EvalMath(const char *word)
 
 	// clean up and return.
 	lua_close(L);
+	LUA_DeleteHeap(heap);
 	return res;
 }
 
@@ -1722,15 +1897,54 @@ void LUA_UnArchive(savebuffer_t *save, boolean network)
 }
 
 // For mobj_t, player_t, etc. to take custom variables.
-int Lua_optoption(lua_State *L, int narg,
-	const char *def, const char *const lst[])
+// Makes a table mapping each name in a NULL terminated option list to its
+// index, and returns a registry reference to it for Lua_optoption.
+// Looking up the interned field name in it is O(1), however long the list.
+int Lua_CreateFieldTable(lua_State *L, const char *const array[])
 {
-	const char *name = (def) ? luaL_optstring(L, narg, def) :  luaL_checkstring(L, narg);
 	int i;
-	for (i=0; lst[i]; i++)
-		if (fastcmp(lst[i], name))
-			return i;
-	return -1;
+
+	lua_newtable(L);
+	for (i = 0; array[i]; i++)
+	{
+		lua_pushinteger(L, i);
+		lua_setfield(L, -2, array[i]);
+	}
+
+	return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+// Returns the index of the option named by argument narg, from a table made
+// by Lua_CreateFieldTable, or -1 if there isn't one.
+// def is returned if the argument is nil or missing; -1 makes it required.
+int Lua_optoption(lua_State *L, int narg, int def, int list_ref)
+{
+	int result = -1;
+
+	if (def != -1 && lua_isnoneornil(L, narg))
+		return def;
+
+	luaL_checkstring(L, narg);
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, list_ref);
+	lua_pushvalue(L, narg);
+	lua_rawget(L, -2);
+	if (lua_isnumber(L, -1))
+		result = lua_tointeger(L, -1);
+	lua_pop(L, 2);
+
+	return result;
+}
+
+// Same as Lua_optoption, but errors like luaL_checkoption for unknown options.
+int Lua_checkoption(lua_State *L, int narg, int def, int list_ref)
+{
+	int result = Lua_optoption(L, narg, def, list_ref);
+
+	if (result == -1)
+		return luaL_argerror(L, narg, lua_pushfstring(L, "invalid option " LUA_QS, lua_tostring(L, narg)));
+
+	return result;
 }
 
 void LUA_PushTaggableObjectArray
@@ -67,8 +67,9 @@ int LUA_WriteGlobals(lua_State *L, const char *word);
 
 void Got_Luacmd(const UINT8 **cp, INT32 playernum); // lua_consolelib.c
 void LUA_CVarChanged(void *cvar); // lua_consolelib.c
-int Lua_optoption(lua_State *L, int narg,
-	const char *def, const char *const lst[]);
+int Lua_CreateFieldTable(lua_State *L, const char *const array[]);
+int Lua_optoption(lua_State *L, int narg, int def, int list_ref);
+int Lua_checkoption(lua_State *L, int narg, int def, int list_ref);
 void LUA_HookNetArchive(lua_CFunction archFunc, savebuffer_t *save);
 
 void LUA_PushTaggableObjectArray
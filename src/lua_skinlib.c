@@ -58,13 +58,14 @@ static const char *const skin_opt[] = {
 	"sprites",
 	NULL
 };
+static int skin_fields_ref = LUA_NOREF;
 
 #define UNIMPLEMENTED luaL_error(L, LUA_QL("skin_t") " field " LUA_QS " is not implemented for Lua and cannot be accessed.", skin_opt[field])
 
 static int skin_get(lua_State *L)
 {
 	skin_t *skin = *((skin_t **)luaL_checkudata(L, 1, META_SKIN));
-	enum skin field = luaL_checkoption(L, 2, NULL, skin_opt);
+	enum skin field = Lua_checkoption(L, 2, -1, skin_fields_ref);
 
 	// skins are always valid, only added, never removed
 	I_Assert(skin != NULL);
@@ -238,6 +239,7 @@ enum spritesopt {
 static const char *const sprites_opt[] = {
 	"numframes",
 	NULL};
+static int sprites_fields_ref = LUA_NOREF;
 
 // skin.sprites[i] -> sprites[i]
 static int lib_getSkinSprite(lua_State *L)
@@ -262,7 +264,7 @@ static int lib_numSkinsSprites(lua_State *L)
 static int sprite_get(lua_State *L)
 {
 	spritedef_t *sprite = *(spritedef_t **)luaL_checkudata(L, 1, META_SKINSPRITESLIST);
-	enum spritesopt field = luaL_checkoption(L, 2, NULL, sprites_opt);
+	enum spritesopt field = Lua_checkoption(L, 2, -1, sprites_fields_ref);
 
 	switch (field)
 	{
@@ -276,6 +278,9 @@ static int sprite_get(lua_State *L)
 
 int LUA_SkinLib(lua_State *L)
 {
+	skin_fields_ref = Lua_CreateFieldTable(L, skin_opt);
+	sprites_fields_ref = Lua_CreateFieldTable(L, sprites_opt);
+
 	luaL_newmetatable(L, META_SKIN);
 		lua_pushcfunction(L, skin_get);
 		lua_setfield(L, -2, "__index");
@@ -14,17 +14,28 @@
 #include "v_video.h"
 #include "i_video.h"
 #include "d_netcmd.h"
+#include "d_main.h" // srb2home
 #include "r_main.h"
 #include "i_system.h"
 #include "i_time.h"
 #include "z_zone.h"
 #include "p_local.h"
+#include "p_precip.h"
 #include "g_game.h"
+#include "lua_alloc.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
 #endif
 
+#include <errno.h>
+
+#ifdef UNIXCOMMON
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 struct perfstatcol;
 struct perfstatrow;
 
@@ -52,11 +63,14 @@ precise_t ps_prevtictime = 0;
 precise_t ps_playerthink_time = 0;
 precise_t ps_botticcmd_time = 0;
 precise_t ps_thinkertime = 0;
+boolean ps_ranthinkers = false;
 
 precise_t ps_thlist_times[NUM_ACTIVETHINKERLISTS];
 precise_t ps_acs_time = 0;
 
 int ps_checkposition_calls = 0;
+int ps_sightcache_hits = 0;
+int ps_sightcache_misses = 0;
 
 precise_t ps_lua_thinkframe_time = 0;
 int ps_lua_mobjhooks = 0;
@@ -95,6 +109,8 @@ void PS_ResetBotInfo(void)
 {
 	memset(ps_bots, 0, sizeof(ps_bots));
 	ps_botticcmd_time = 0;
+	ps_sightcache_hits = 0;
+	ps_sightcache_misses = 0;
 }
 
 static void PS_SetFrameTime(void)
@@ -345,6 +361,9 @@ static void M_DrawTickStats(void)
 	int dynslopethcount = 0;
 	int precipcount = 0;
 	int removecount = 0;
+	int luamemory = 0;
+	int luapeak = 0;
+	int luaallocs = 0;
 
 	precise_t extratime =
 		ps_tictime -
@@ -413,6 +432,15 @@ static void M_DrawTickStats(void)
 	perfstatrow_t misc_calls_row[] = {
 		{"lmhook", "Lua mobj hooks: ", &ps_lua_mobjhooks},
 		{"chkpos", "P_CheckPosition:", &ps_checkposition_calls},
+		{"loshit", "LOS cache hits: ", &ps_sightcache_hits},
+		{"losmiss", "LOS cache miss: ", &ps_sightcache_misses},
+		{0}
+	};
+
+	perfstatrow_t lua_memory_row[] = {
+		{"luamem ", "Lua memory (KB):", &luamemory},
+		{"luapeak", "Lua peak (KB):  ", &luapeak},
+		{"luaallc", "Lua allocs/tic: ", &luaallocs},
 		{0}
 	};
 
@@ -427,6 +455,7 @@ static void M_DrawTickStats(void)
 	perfstatcol_t          nothinkcount_col  =  {98, 123, V_BLUEMAP,            nothinkcount_row};
 	perfstatcol_t detailed_thinkercount_col2 =  {94, 119, V_BLUEMAP,   detailed_thinkercount_row2};
 	perfstatcol_t            misc_calls_col  = {170, 216, V_PURPLEMAP,            misc_calls_row};
+	perfstatcol_t            lua_memory_col  = {170, 216, V_PURPLEMAP,            lua_memory_row};
 
 	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
@@ -455,11 +484,11 @@ static void M_DrawTickStats(void)
 			}
 			else if (i == THINK_DYNSLOPE)
 				dynslopethcount++;
-			else if (i == THINK_PRECIP)
-				precipcount++;
 		}
 	}
 
+	precipcount = (int)P_CountPrecipitation();
+
 	draw_row = 10;
 	M_DrawPerfTiming(&tictime_col);
 	M_DrawPerfTiming(&thinker_time_col);
@@ -488,6 +517,17 @@ static void M_DrawTickStats(void)
 	}
 
 	M_DrawPerfCount(&misc_calls_col);
+
+	if (gLheap)
+	{
+		const lua_heapstats_t *lua = LUA_HeapStats(gLheap);
+
+		luamemory = lua->live >> 10;
+		luapeak = lua->peak >> 10;
+		luaallocs = lua->ticallocs;
+
+		M_DrawPerfCount(&lua_memory_col);
+	}
 }
 
 void M_DrawPerfStats(void)
@@ -704,3 +744,278 @@ void M_DrawPerfStats(void)
 		}
 	}
 }
+
+// ----------------------
+// Per-tic sample history
+// ----------------------
+
+#define PS_SAMPLES 8192 // a little under 4 minutes at TICRATE, a full race
+
+typedef enum
+{
+	PS_SAMPLE_TIME,
+	PS_SAMPLE_COUNT,
+} ps_samplekind_t;
+
+typedef struct
+{
+	const char *name;
+	ps_samplekind_t kind;
+	const void *value; // precise_t for times, int for counts
+	INT64 ring[PS_SAMPLES];
+} ps_counter_t;
+
+static ps_counter_t ps_counters[] = {
+	{"tic",            PS_SAMPLE_TIME,  &ps_tictime},
+	{"playerthink",    PS_SAMPLE_TIME,  &ps_playerthink_time},
+	{"bots",           PS_SAMPLE_TIME,  &ps_botticcmd_time},
+	{"thinkers",       PS_SAMPLE_TIME,  &ps_thinkertime},
+	{"th_polyobj",     PS_SAMPLE_TIME,  &ps_thlist_times[THINK_POLYOBJ]},
+	{"th_main",        PS_SAMPLE_TIME,  &ps_thlist_times[THINK_MAIN]},
+	{"th_mobj",        PS_SAMPLE_TIME,  &ps_thlist_times[THINK_MOBJ]},
+	{"th_dynslope",    PS_SAMPLE_TIME,  &ps_thlist_times[THINK_DYNSLOPE]},
+	{"acs",            PS_SAMPLE_TIME,  &ps_acs_time},
+	{"lua_thinkframe", PS_SAMPLE_TIME,  &ps_lua_thinkframe_time},
+	{"lua_mobjhooks",  PS_SAMPLE_COUNT, &ps_lua_mobjhooks},
+	{"checkposition",  PS_SAMPLE_COUNT, &ps_checkposition_calls},
+};
+
+#define NUMPSCOUNTERS (sizeof ps_counters / sizeof *ps_counters)
+
+static size_t ps_sample_head; // next slot to write
+static size_t ps_sample_count; // filled slots, up to PS_SAMPLES
+
+static INT64 ps_sample_scratch[PS_SAMPLES];
+
+static FILE *ps_export_file;
+static boolean ps_export_csv;
+#ifdef UNIXCOMMON
+static int ps_export_socket = -1;
+static struct sockaddr_un ps_export_addr;
+#endif
+
+// Times are kept in microseconds, which is what everything is printed in anyway.
+static INT64 PS_CounterValue(const ps_counter_t *counter)
+{
+	if (counter->kind == PS_SAMPLE_TIME)
+		return (INT64)((*(const precise_t *)counter->value * 1000000) / I_GetPrecisePrecision());
+	return *(const int *)counter->value;
+}
+
+static void PS_ExportSample(tic_t tic)
+{
+	char line[1024];
+	size_t len = 0;
+	size_t i;
+
+	if (ps_export_csv)
+	{
+		len += snprintf(line + len, sizeof line - len, "%u", tic);
+		for (i = 0; i < NUMPSCOUNTERS && len < sizeof line; i++)
+			len += snprintf(line + len, sizeof line - len, ",%lld",
+				(long long)ps_counters[i].ring[(ps_sample_head + PS_SAMPLES - 1) % PS_SAMPLES]);
+	}
+	else
+	{
+		len += snprintf(line + len, sizeof line - len, "{\"leveltime\":%u", tic);
+		for (i = 0; i < NUMPSCOUNTERS && len < sizeof line; i++)
+			len += snprintf(line + len, sizeof line - len, ",\"%s\":%lld", ps_counters[i].name,
+				(long long)ps_counters[i].ring[(ps_sample_head + PS_SAMPLES - 1) % PS_SAMPLES]);
+		if (len < sizeof line)
+			len += snprintf(line + len, sizeof line - len, "}");
+	}
+
+	if (len >= sizeof line - 1)
+		return; // can't happen with these names, but don't send half a line
+
+	line[len++] = '\n';
+
+	if (ps_export_file)
+	{
+		fwrite(line, 1, len, ps_export_file);
+
+		// Don't lose more than a second to a crash.
+		if (tic % TICRATE == 0)
+			fflush(ps_export_file);
+	}
+#ifdef UNIXCOMMON
+	else if (ps_export_socket != -1)
+	{
+		// Datagrams, so a reader that falls behind or goes away never blocks the game.
+		sendto(ps_export_socket, line, len, MSG_DONTWAIT,
+			(const struct sockaddr *)&ps_export_addr, sizeof ps_export_addr);
+	}
+#endif
+}
+
+void PS_RecordTicSample(void)
+{
+	size_t i;
+
+	// Paused tics, and ones that never got to P_RunThinkers, would only
+	// repeat the last tic's numbers.
+	if (!ps_ranthinkers)
+		return;
+
+	ps_ranthinkers = false;
+
+	if (gamestate != GS_LEVEL)
+		return;
+
+	for (i = 0; i < NUMPSCOUNTERS; i++)
+		ps_counters[i].ring[ps_sample_head] = PS_CounterValue(&ps_counters[i]);
+
+	ps_sample_head = (ps_sample_head + 1) % PS_SAMPLES;
+	if (ps_sample_count < PS_SAMPLES)
+		ps_sample_count++;
+
+	PS_ExportSample(leveltime);
+}
+
+void PS_ResetTicSamples(void)
+{
+	ps_sample_head = 0;
+	ps_sample_count = 0;
+}
+
+static int PS_CompareSamples(const void *a, const void *b)
+{
+	const INT64 x = *(const INT64 *)a;
+	const INT64 y = *(const INT64 *)b;
+	return (x > y) - (x < y);
+}
+
+boolean PS_GetHistogram(size_t counter, ps_histogram_t *out)
+{
+	size_t n = ps_sample_count;
+
+	if (counter >= NUMPSCOUNTERS || n == 0)
+		return false;
+
+	// Order doesn't matter for percentiles, so the ring can be copied as is.
+	memcpy(ps_sample_scratch, ps_counters[counter].ring, n * sizeof *ps_sample_scratch);
+	qsort(ps_sample_scratch, n, sizeof *ps_sample_scratch, PS_CompareSamples);
+
+	out->name = ps_counters[counter].name;
+	out->samples = n;
+	out->p50 = ps_sample_scratch[(n - 1) * 50 / 100];
+	out->p95 = ps_sample_scratch[(n - 1) * 95 / 100];
+	out->p99 = ps_sample_scratch[(n - 1) * 99 / 100];
+	out->max = ps_sample_scratch[n - 1];
+	return true;
+}
+
+size_t PS_NumHistograms(void)
+{
+	return NUMPSCOUNTERS;
+}
+
+void Command_PerfstatsReport_f(void)
+{
+	ps_histogram_t h;
+	size_t i;
+
+	if (COM_Argc() > 1 && !strcasecmp(COM_Argv(1), "reset"))
+	{
+		PS_ResetTicSamples();
+		CONS_Printf("Perfstats history cleared.\n");
+		return;
+	}
+
+	if (ps_sample_count == 0)
+	{
+		CONS_Printf("No tics recorded yet.\n");
+		return;
+	}
+
+	CONS_Printf("Last %s tics (times in us):\n", sizeu1(ps_sample_count));
+	CONS_Printf("%-16s %8s %8s %8s %8s\n", "counter", "p50", "p95", "p99", "max");
+
+	for (i = 0; i < NUMPSCOUNTERS; i++)
+	{
+		if (!PS_GetHistogram(i, &h))
+			continue;
+
+		CONS_Printf("%-16s %8lld %8lld %8lld %8lld\n", h.name,
+			(long long)h.p50, (long long)h.p95, (long long)h.p99, (long long)h.max);
+	}
+}
+
+static void PS_CloseExport(void)
+{
+	if (ps_export_file)
+	{
+		fclose(ps_export_file);
+		ps_export_file = NULL;
+	}
+#ifdef UNIXCOMMON
+	if (ps_export_socket != -1)
+	{
+		close(ps_export_socket);
+		ps_export_socket = -1;
+	}
+#endif
+}
+
+void PS_Export_OnChange(void)
+{
+	const char *target = cv_perfstats_export.string;
+	size_t i;
+
+	PS_CloseExport();
+
+	if (!target || !target[0])
+		return;
+
+#ifdef UNIXCOMMON
+	if (!strncmp(target, "unix:", 5))
+	{
+		const char *path = target + 5;
+
+		if (strlen(path) >= sizeof ps_export_addr.sun_path)
+		{
+			CONS_Alert(CONS_ERROR, "perfstats_export: socket path too long\n");
+			return;
+		}
+
+		ps_export_socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+		if (ps_export_socket == -1)
+		{
+			CONS_Alert(CONS_ERROR, "perfstats_export: %s\n", strerror(errno));
+			return;
+		}
+
+		memset(&ps_export_addr, 0, sizeof ps_export_addr);
+		ps_export_addr.sun_family = AF_UNIX;
+		strcpy(ps_export_addr.sun_path, path);
+		ps_export_csv = false;
+		return;
+	}
+#endif
+
+	// Only ever a file name inside srb2home.
+	if (strpbrk(target, "/\\:") || strstr(target, ".."))
+	{
+		CONS_Alert(CONS_ERROR, "perfstats_export: '%s' must be a file name, not a path\n", target);
+		return;
+	}
+
+	ps_export_file = fopen(va("%s" PATHSEP "%s", srb2home, target), "a");
+	if (!ps_export_file)
+	{
+		CONS_Alert(CONS_ERROR, "perfstats_export: can't open '%s': %s\n", target, strerror(errno));
+		return;
+	}
+
+	ps_export_csv = (strrchr(target, '.') && !strcasecmp(strrchr(target, '.'), ".csv"));
+
+	// A fresh CSV gets a header.
+	fseek(ps_export_file, 0, SEEK_END);
+	if (ps_export_csv && ftell(ps_export_file) == 0)
+	{
+		fputs("leveltime", ps_export_file);
+		for (i = 0; i < NUMPSCOUNTERS; i++)
+			fprintf(ps_export_file, ",%s", ps_counters[i].name);
+		fputc('\n', ps_export_file);
+	}
+}
@@ -36,11 +36,14 @@ extern precise_t ps_prevtictime;
 extern precise_t ps_playerthink_time;
 extern precise_t ps_botticcmd_time;
 extern precise_t ps_thinkertime;
+extern boolean   ps_ranthinkers;
 
 extern precise_t ps_thlist_times[];
 extern precise_t ps_acs_time;
 
 extern int       ps_checkposition_calls;
+extern int       ps_sightcache_hits;
+extern int       ps_sightcache_misses;
 
 extern precise_t ps_lua_thinkframe_time;
 extern int       ps_lua_mobjhooks;
@@ -68,6 +71,26 @@ void PS_ResetBotInfo(void);
 
 void M_DrawPerfStats(void);
 
+// Every tic in a level is also kept in a rolling history,
+// which can be streamed out as it's recorded.
+
+extern consvar_t cv_perfstats_export;
+
+struct ps_histogram_t
+{
+	const char *name;
+	size_t samples;
+	INT64 p50, p95, p99, max; // microseconds for times
+};
+
+void PS_RecordTicSample(void);
+void PS_ResetTicSamples(void);
+size_t PS_NumHistograms(void);
+boolean PS_GetHistogram(size_t counter, ps_histogram_t *out);
+
+void Command_PerfstatsReport_f(void);
+void PS_Export_OnChange(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
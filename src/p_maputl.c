@@ -527,7 +527,7 @@ static boolean P_MidtextureIsSolid(line_t *linedef, mobj_t *mobj)
 	return ((linedef->flags & ML_MIDSOLID) == ML_MIDSOLID);
 }
 
-void P_LineOpening(line_t *linedef, mobj_t *mobj, opening_t *open)
+void P_LineOpeningAt(line_t *linedef, mobj_t *mobj, fixed_t x, fixed_t y, opening_t *open)
 {
 	enum { FRONT, BACK };
 
@@ -558,7 +558,7 @@ void P_LineOpening(line_t *linedef, mobj_t *mobj, opening_t *open)
 		return;
 	}
 
-	P_ClosestPointOnLine(g_tm.x, g_tm.y, linedef, &cross);
+	P_ClosestPointOnLine(x, y, linedef, &cross);
 
 	// Treat polyobjects kind of like 3D Floors
 	if (linedef->polyobj && (linedef->polyobj->flags & POF_TESTHEIGHT))
@@ -586,8 +586,8 @@ void P_LineOpening(line_t *linedef, mobj_t *mobj, opening_t *open)
 		fixed_t          height[2];
 		const sector_t * sector[2] = { front, back };
 
-		height[FRONT] = P_GetCeilingZ(mobj, front, g_tm.x, g_tm.y, linedef);
-		height[BACK]  = P_GetCeilingZ(mobj, back,  g_tm.x, g_tm.y, linedef);
+		height[FRONT] = P_GetCeilingZ(mobj, front, x, y, linedef);
+		height[BACK]  = P_GetCeilingZ(mobj, back,  x, y, linedef);
 
 		hi = ( height[0] < height[1] );
 		lo = ! hi;
@@ -606,8 +606,8 @@ void P_LineOpening(line_t *linedef, mobj_t *mobj, opening_t *open)
 			open->ceilingdrop = ( topedge[hi] - topedge[lo] );
 		}
 
-		height[FRONT] = P_GetFloorZ(mobj, front, g_tm.x, g_tm.y, linedef);
-		height[BACK]  = P_GetFloorZ(mobj, back,  g_tm.x, g_tm.y, linedef);
+		height[FRONT] = P_GetFloorZ(mobj, front, x, y, linedef);
+		height[BACK]  = P_GetFloorZ(mobj, back,  x, y, linedef);
 
 		hi = ( height[0] < height[1] );
 		lo = ! hi;
@@ -796,8 +796,8 @@ void P_LineOpening(line_t *linedef, mobj_t *mobj, opening_t *open)
 					}
 					else
 					{
-						topheight = P_GetFOFTopZ(mobj, front, rover, g_tm.x, g_tm.y, linedef);
-						bottomheight = P_GetFOFBottomZ(mobj, front, rover, g_tm.x, g_tm.y, linedef);
+						topheight = P_GetFOFTopZ(mobj, front, rover, x, y, linedef);
+						bottomheight = P_GetFOFBottomZ(mobj, front, rover, x, y, linedef);
 					}
 
 					switch (open->fofType)
@@ -888,8 +888,8 @@ void P_LineOpening(line_t *linedef, mobj_t *mobj, opening_t *open)
 					}
 					else
 					{
-						topheight = P_GetFOFTopZ(mobj, back, rover, g_tm.x, g_tm.y, linedef);
-						bottomheight = P_GetFOFBottomZ(mobj, back, rover, g_tm.x, g_tm.y, linedef);
+						topheight = P_GetFOFTopZ(mobj, back, rover, x, y, linedef);
+						bottomheight = P_GetFOFBottomZ(mobj, back, rover, x, y, linedef);
 					}
 
 					switch (open->fofType)
@@ -1023,6 +1023,11 @@ void P_LineOpening(line_t *linedef, mobj_t *mobj, opening_t *open)
 	open->range = (open->ceiling - open->floor);
 }
 
+void P_LineOpening(line_t *linedef, mobj_t *mobj, opening_t *open)
+{
+	P_LineOpeningAt(linedef, mobj, g_tm.x, g_tm.y, open);
+}
+
 
 //
 // THING POSITION SETTING
@@ -1090,18 +1095,6 @@ void P_UnsetThingPosition(mobj_t *thing)
 	}
 }
 
-void P_UnsetPrecipThingPosition(precipmobj_t *thing)
-{
-	precipmobj_t **bprev = thing->bprev;
-	precipmobj_t  *bnext = thing->bnext;
-
-	if (bprev && (*bprev = bnext) != NULL)  // unlink from block map
-		bnext->bprev = bprev;
-
-	precipsector_list = thing->touching_sectorlist;
-	thing->touching_sectorlist = NULL; //to be restored by P_SetPrecipThingPosition
-}
-
 static void P_LinkToBlockMap(mobj_t *thing, mobj_t **bmap)
 {
 	const INT32 blockx = (unsigned)(thing->x - bmaporgx) >> MAPBLOCKSHIFT;
@@ -1243,19 +1236,6 @@ void P_SetUnderlayPosition(mobj_t *thing)
 	sector_list = NULL; // clear for next time
 }
 
-void P_SetPrecipitationThingPosition(precipmobj_t *thing)
-{
-	thing->subsector = R_PointInSubsector(thing->x, thing->y);
-
-	P_CreatePrecipSecNodeList(thing, thing->x, thing->y);
-	thing->touching_sectorlist = precipsector_list; // Attach to Thing's precipmobj_t
-	precipsector_list = NULL; // clear for next time
-
-	// NOTE: this works because bnext/bprev are at the same
-	// offsets in precipmobj_t and mobj_t
-	P_LinkToBlockMap((mobj_t*)thing, (mobj_t**)precipblocklinks);
-}
-
 //
 // BLOCK MAP ITERATORS
 // For each line/thing in the given mapblock,
@@ -1353,16 +1333,34 @@ boolean P_BlockLinesIterator(INT32 x, INT32 y, BlockItReturn_t (*func)(line_t *)
 //
 boolean P_BlockThingsIterator(INT32 x, INT32 y, BlockItReturn_t (*func)(mobj_t *))
 {
-	mobj_t *mobj, *bnext = NULL;
+	return P_BlockThingsIteratorFiltered(x, y, func, NULL);
+}
+
+//
+// P_BlockThingsIteratorFiltered
+// Only calls func for the things filter accepts, in the same order as
+// P_BlockThingsIterator. filter must not change anything, so the things
+// it turns away are passed over without holding a reference to the next
+// one; in a crowded block that is most of the cost of iterating it.
+//
+boolean P_BlockThingsIteratorFiltered(INT32 x, INT32 y, BlockItReturn_t (*func)(mobj_t *), boolean (*filter)(mobj_t *))
+{
+	mobj_t *mobj, *next, *bnext = NULL;
 
 	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
 		return true;
 
 	// Check interaction with the objects in the blockmap.
-	for (mobj = blocklinks[y*bmapwidth + x]; mobj; mobj = bnext)
+	for (mobj = blocklinks[y*bmapwidth + x]; mobj; mobj = next)
 	{
 		BlockItReturn_t ret = BMIT_CONTINUE;
 
+		if (filter != NULL && !filter(mobj))
+		{
+			next = mobj->bnext;
+			continue;
+		}
+
 		P_SetTarget(&bnext, mobj->bnext); // We want to note our reference to bnext here incase it is MF_NOTHINK and gets removed!
 		ret = func(mobj);
 
@@ -1378,6 +1376,37 @@ boolean P_BlockThingsIterator(INT32 x, INT32 y, BlockItReturn_t (*func)(mobj_t *
 			P_SetTarget(&bnext, NULL);
 			return true; // success
 		}
+
+		next = bnext;
+	}
+
+	// The last thing func was called for may still be holding onto a skipped thing.
+	P_SetTarget(&bnext, NULL);
+	return true;
+}
+
+//
+// P_BlockThingsIteratorReadOnly
+// For funcs that only look and never move, remove or spawn anything.
+// Takes no references, so unlike the iterators above it is safe to run
+// off the main thread.
+//
+boolean P_BlockThingsIteratorReadOnly(INT32 x, INT32 y, BlockItReturn_t (*func)(mobj_t *))
+{
+	mobj_t *mobj;
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return true;
+
+	for (mobj = blocklinks[y*bmapwidth + x]; mobj; mobj = mobj->bnext)
+	{
+		BlockItReturn_t ret = func(mobj);
+
+		if (ret == BMIT_ABORT)
+			return false; // failure
+
+		if (ret == BMIT_STOP)
+			return true; // success
 	}
 
 	return true;
@@ -553,25 +553,6 @@ boolean P_SetMobjStateNF(mobj_t *mobj, statenum_t state)
 	return true;
 }
 
-static boolean P_SetPrecipMobjState(precipmobj_t *mobj, statenum_t state)
-{
-	state_t *st;
-
-	if (state == S_NULL)
-	{ // Remove mobj
-		P_FreePrecipMobj(mobj);
-		return false;
-	}
-	st = &states[state];
-	mobj->state = st;
-	mobj->tics = st->tics;
-	mobj->sprite = st->sprite;
-	mobj->frame = st->frame;
-	P_SetupStateAnimation((mobj_t*)mobj, st);
-
-	return true;
-}
-
 //
 // P_MobjFlip
 //
@@ -4052,177 +4033,6 @@ animonly:
 	P_CyclePlayerMobjState(mobj);
 }
 
-void P_CalculatePrecipFloor(precipmobj_t *mobj)
-{
-	// recalculate floorz each time
-	const sector_t *mobjsecsubsec;
-	boolean setWater = false;
-
-	if (mobj && mobj->subsector && mobj->subsector->sector)
-		mobjsecsubsec = mobj->subsector->sector;
-	else
-		return;
-
-	mobj->precipflags &= ~PCF_INVISIBLE;
-	mobj->floorz = P_GetSectorFloorZAt(mobjsecsubsec, mobj->x, mobj->y);
-	mobj->ceilingz = P_GetSectorCeilingZAt(mobjsecsubsec, mobj->x, mobj->y);
-
-	if (mobjsecsubsec->ffloors)
-	{
-		ffloor_t *rover;
-		fixed_t height;
-
-		for (rover = mobjsecsubsec->ffloors; rover; rover = rover->next)
-		{
-			// If it exists, it'll get rained on.
-			if (!(rover->fofflags & FOF_EXISTS))
-				continue;
-
-			if (precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES)
-			{
-				if (!(rover->fofflags & FOF_SWIMMABLE))
-					continue;
-
-				if (setWater == false)
-				{
-					mobj->ceilingz = P_GetFFloorTopZAt(rover, mobj->x, mobj->y);
-					mobj->floorz = P_GetFFloorBottomZAt(rover, mobj->x, mobj->y);
-					setWater = true;
-				}
-				else
-				{
-					height = P_GetFFloorTopZAt(rover, mobj->x, mobj->y);
-					if (height > mobj->ceilingz)
-						mobj->ceilingz = height;
-
-					height = P_GetFFloorBottomZAt(rover, mobj->x, mobj->y);
-					if (height < mobj->floorz)
-						mobj->floorz = height;
-				}
-			}
-			else
-			{
-				if (!(rover->fofflags & FOF_BLOCKOTHERS) && !(rover->fofflags & FOF_SWIMMABLE))
-					continue;
-
-				height = P_GetFFloorTopZAt(rover, mobj->x, mobj->y);
-				if (height > mobj->floorz)
-					mobj->floorz = height;
-			}
-		}
-	}
-
-	if ((precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES) && setWater == false)
-	{
-		mobj->precipflags |= PCF_INVISIBLE;
-	}
-}
-
-void P_RecalcPrecipInSector(sector_t *sector)
-{
-	mprecipsecnode_t *psecnode;
-
-	if (!sector)
-		return;
-
-	sector->moved = true; // Recalc lighting and things too, maybe
-
-	for (psecnode = sector->touching_preciplist; psecnode; psecnode = psecnode->m_thinglist_next)
-		P_CalculatePrecipFloor(psecnode->m_thing);
-}
-
-//
-// P_NullPrecipThinker
-//
-// Just the identification of a precip thinker. The thinker
-// should never actually be called!
-//
-void P_NullPrecipThinker(precipmobj_t *mobj)
-{
-	(void)mobj;
-	I_Assert("P_NullPrecipThinker should not be called" == 0);
-}
-
-boolean P_PrecipThinker(precipmobj_t *mobj)
-{
-	boolean flip = (mobj->precipflags & PCF_FLIP);
-
-	if (mobj->lastThink == leveltime)
-		return true; // already thinked this tick
-
-	mobj->lastThink = leveltime;
-
-	R_ResetPrecipitationMobjInterpolationState(mobj);
-	P_CycleStateAnimation((mobj_t *)mobj);
-
-	if (mobj->state == &states[S_RAINRETURN])
-	{
-		// Reset to ceiling!
-		if (!P_SetPrecipMobjState(mobj, mobj->info->spawnstate))
-			return false;
-
-		mobj->z = (flip) ? (mobj->floorz) : (mobj->ceilingz);
-		mobj->momz = FixedMul(-mobj->info->speed, mapobjectscale);
-		mobj->precipflags &= ~PCF_SPLASH;
-		R_ResetPrecipitationMobjInterpolationState(mobj);
-	}
-
-	if (mobj->tics != -1)
-	{
-		if (mobj->tics)
-		{
-			mobj->tics--;
-		}
-
-		if (mobj->tics == 0)
-		{
-			if ((mobj->precipflags & PCF_SPLASH) && (mobj->state->nextstate == S_NULL))
-			{
-				// HACK: sprite changes are 1 tic late, so you would see splashes on the ceiling if not for this state.
-				// We need to use the settings from the previous state, since some of those are NOT 1 tic late.
-				INT32 frame = (mobj->frame & ~FF_FRAMEMASK);
-
-				if (!P_SetPrecipMobjState(mobj, S_RAINRETURN))
-					return false;
-
-				mobj->frame = frame;
-				return true;
-			}
-			else
-			{
-				if (!P_SetPrecipMobjState(mobj, mobj->state->nextstate))
-					return false;
-			}
-		}
-	}
-
-	if (mobj->precipflags & PCF_SPLASH)
-		return true;
-
-	mobj->z += mobj->momz;
-
-	// adjust height
-	if ((flip) ? (mobj->z >= mobj->ceilingz) : (mobj->z <= mobj->floorz))
-	{
-		if ((mobj->info->deathstate == S_NULL) || (mobj->precipflags & PCF_PIT)) // no splashes on sky or bottomless pits
-		{
-			mobj->z = (flip) ? (mobj->floorz) : (mobj->ceilingz);
-			R_ResetPrecipitationMobjInterpolationState(mobj);
-		}
-		else
-		{
-			if (!P_SetPrecipMobjState(mobj, mobj->info->deathstate))
-				return false;
-
-			mobj->z = (flip) ? (mobj->ceilingz) : (mobj->floorz);
-			mobj->precipflags |= PCF_SPLASH;
-			R_ResetPrecipitationMobjInterpolationState(mobj);
-		}
-	}
-
-	return true;
-}
-
 static void P_RingThinker(mobj_t *mobj)
 {
 	mobj_t *spark;	// Ring Fuse
@@ -11256,76 +11066,6 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 	return mobj;
 }
 
-static precipmobj_t *P_SpawnPrecipMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
-{
-	const mobjinfo_t *info = &mobjinfo[type];
-	state_t *st;
-	fixed_t start_z = INT32_MIN;
-	precipmobj_t *mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
-
-	mobj->type = type;
-	mobj->info = info;
-
-	mobj->x = x;
-	mobj->y = y;
-	mobj->flags = info->flags;
-
-	// do not set the state with P_SetMobjState,
-	// because action routines can not be called yet
-	st = &states[info->spawnstate];
-
-	mobj->state = st;
-	mobj->tics = st->tics;
-	mobj->sprite = st->sprite;
-	mobj->frame = st->frame; // FF_FRAMEMASK for frame, and other bits..
-	P_SetupStateAnimation((mobj_t*)mobj, st);
-
-	// set subsector and/or block links
-	P_SetPrecipitationThingPosition(mobj);
-
-	mobj->floorz   = P_GetSectorFloorZAt  (mobj->subsector->sector, x, y);
-	mobj->ceilingz = P_GetSectorCeilingZAt(mobj->subsector->sector, x, y);
-
-	mobj->floorrover = NULL;
-	mobj->ceilingrover = NULL;
-
-	mobj->z = z;
-	mobj->momz = FixedMul(-info->speed, mapobjectscale);
-
-	if (info->speed < 0)
-	{
-		mobj->precipflags |= PCF_FLIP;
-	}
-
-	start_z = mobj->floorz;
-
-	mobj->thinker.function.acp1 = (actionf_p1)P_NullPrecipThinker;
-	P_AddThinker(THINK_PRECIP, &mobj->thinker);
-
-	P_CalculatePrecipFloor(mobj);
-
-	if (mobj->floorz != start_z)
-	{
-		; //mobj->precipflags |= PCF_FOF;
-	}
-	else
-	{
-		INT32 dmg = mobj->subsector->sector->damagetype;
-		boolean sFlag = (mobj->precipflags & PCF_FLIP) ? (mobj->subsector->sector->flags & MSF_FLIPSPECIAL_CEILING) : (mobj->subsector->sector->flags & MSF_FLIPSPECIAL_FLOOR);
-		boolean pitFloor = ((dmg == SD_DEATHPIT) && sFlag);
-		boolean skyFloor = (mobj->precipflags & PCF_FLIP) ? (mobj->subsector->sector->ceilingpic == skyflatnum) : (mobj->subsector->sector->floorpic == skyflatnum);
-
-		if (pitFloor || skyFloor)
-		{
-			mobj->precipflags |= PCF_PIT;
-		}
-	}
-
-	R_ResetPrecipitationMobjInterpolationState(mobj);
-
-	return mobj;
-}
-
 void *P_CreateFloorSpriteSlope(mobj_t *mobj)
 {
 	if (mobj->floorspriteslope)
@@ -11579,55 +11319,24 @@ boolean P_MobjWasRemoved(const mobj_t *mobj)
 	return true;
 }
 
-void P_FreePrecipMobj(precipmobj_t *mobj)
-{
-	// unlink from sector and block lists
-	P_UnsetPrecipThingPosition(mobj);
-
-	if (precipsector_list)
-	{
-		P_DelPrecipSeclist(precipsector_list);
-		precipsector_list = NULL;
-	}
-
-	// free block
-	// Precipmobjs don't actually think using their thinker,
-	// so the free cannot be delayed.
-	P_UnlinkThinker((thinker_t*)mobj);
-}
-
 // Clearing out stuff for savegames
 void P_RemoveSavegameMobj(mobj_t *mobj)
 {
-	if (((thinker_t *)mobj)->function.acp1 == (actionf_p1)P_NullPrecipThinker)
-	{
-		// unlink from sector and block lists
-		P_UnsetPrecipThingPosition((precipmobj_t *)mobj);
-
-		if (precipsector_list)
-		{
-			P_DelPrecipSeclist(precipsector_list);
-			precipsector_list = NULL;
-		}
-	}
-	else
-	{
-		// unlink from tid chains
-		P_RemoveThingTID(mobj);
-
-		// unlink from sector and block lists
-		P_UnsetThingPosition(mobj);
+	// unlink from tid chains
+	P_RemoveThingTID(mobj);
 
-		// Remove touching_sectorlist from mobj.
-		if (sector_list)
-		{
-			P_DelSeclist(sector_list);
-			sector_list = NULL;
-		}
+	// unlink from sector and block lists
+	P_UnsetThingPosition(mobj);
 
-		P_DeleteMobjStringArgs(mobj);
+	// Remove touching_sectorlist from mobj.
+	if (sector_list)
+	{
+		P_DelSeclist(sector_list);
+		sector_list = NULL;
 	}
 
+	P_DeleteMobjStringArgs(mobj);
+
 	// stop any playing sound
 	S_StopSound(mobj);
 
@@ -11638,147 +11347,6 @@ void P_RemoveSavegameMobj(mobj_t *mobj)
 	P_UnlinkThinker((thinker_t*)mobj);
 }
 
-static void P_SpawnPrecipitationAt(fixed_t basex, fixed_t basey)
-{
-	INT32 j, k;
-
-	const mobjtype_t type = precipprops[curWeather].type;
-	const UINT8 randomstates = (UINT8)mobjinfo[type].damage;
-	const boolean flip = (mobjinfo[type].speed < 0);
-
-	fixed_t i, x, y, z, height;
-
-	UINT16 numparticles = 0;
-	boolean condition = false;
-
-	subsector_t *precipsector = NULL;
-	precipmobj_t *rainmo = NULL;
-
-	// If mobjscale < FRACUNIT, each blockmap cell covers
-	// more area so spawn more precipitation in that area.
-	for (i = 0; i < FRACUNIT; i += mapobjectscale)
-	{
-		x = basex + ((M_RandomKey(MAPBLOCKUNITS << 3) << FRACBITS) >> 3);
-		y = basey + ((M_RandomKey(MAPBLOCKUNITS << 3) << FRACBITS) >> 3);
-
-		precipsector = R_PointInSubsectorOrNull(x, y);
-
-		// No sector? Stop wasting time,
-		// move on to the next entry in the blockmap
-		if (!precipsector)
-			continue;
-
-		// Not in a sector with visible sky?
-		if (precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES)
-		{
-			condition = false;
-
-			if (precipsector->sector->ffloors)
-			{
-				ffloor_t *rover;
-
-				for (rover = precipsector->sector->ffloors; rover; rover = rover->next)
-				{
-					if (!(rover->fofflags & FOF_EXISTS))
-						continue;
-
-					if (!(rover->fofflags & FOF_SWIMMABLE))
-						continue;
-
-					condition = true;
-					break;
-				}
-			}
-		}
-		else
-		{
-			condition = (precipsector->sector->ceilingpic == skyflatnum);
-		}
-
-		if (precipsector->sector->flags & MSF_INVERTPRECIP)
-		{
-			condition = !condition;
-		}
-
-		if (!condition)
-		{
-			continue;
-		}
-
-		height = precipsector->sector->ceilingheight - precipsector->sector->floorheight;
-		height = FixedDiv(height, mapobjectscale);
-
-		// Exists, but is too small for reasonable precipitation.
-		if (height < 64<<FRACBITS)
-			continue;
-
-		// Hack around a quirk of this entire system, where taller sectors look like they get less precipitation.
-		numparticles = 1 + (height / (MAPBLOCKUNITS<<4<<FRACBITS));
-
-		// Don't set z properly yet...
-		z = (flip) ? (precipsector->sector->floorheight) : (precipsector->sector->ceilingheight);
-
-		for (j = 0; j < numparticles; j++)
-		{
-			INT32 floorz;
-			INT32 ceilingz;
-
-			rainmo = P_SpawnPrecipMobj(x, y, z, type);
-
-			if (randomstates > 0)
-			{
-				UINT8 mrand = M_RandomByte();
-				UINT8 threshold = UINT8_MAX / (randomstates + 1);
-				statenum_t st = mobjinfo[type].spawnstate;
-
-				for (k = 0; k < randomstates; k++)
-				{
-					if (mrand < (threshold * (k+1)))
-					{
-						P_SetPrecipMobjState(rainmo, st+k+1);
-						break;
-					}
-				}
-			}
-
-			floorz = rainmo->floorz >> FRACBITS;
-			ceilingz = rainmo->ceilingz >> FRACBITS;
-
-			if (floorz < ceilingz)
-			{
-				// Randomly assign a height, now that floorz is set.
-				rainmo->z = M_RandomRange(floorz, ceilingz) << FRACBITS;
-			}
-			else
-			{
-				// ...except if the floor is above the ceiling.
-				rainmo->z = ceilingz << FRACBITS;
-			}
-		}
-	}
-}
-
-void P_SpawnPrecipitation(void)
-{
-	INT32 i;
-
-	const mobjtype_t type = precipprops[curWeather].type;
-
-	fixed_t basex, basey;
-
-	if (dedicated || !cv_drawdist_precip.value || type == MT_NULL)
-		return;
-
-	// Use the blockmap to narrow down our placing patterns
-	for (i = 0; i < bmapwidth*bmapheight; ++i)
-	{
-		basex = bmaporgx + (i % bmapwidth) * MAPBLOCKSIZE;
-		basey = bmaporgy + (i / bmapwidth) * MAPBLOCKSIZE;
-
-		P_SpawnPrecipitationAt(basex, basey);
-	}
-}
-
 //
 // P_PrecipitationEffects
 //
@@ -264,17 +264,6 @@ typedef enum
 	MFE_PAUSED            = 1<<15,
 } mobjeflag_t;
 
-//
-// PRECIPITATION flags ?! ?! ?!
-//
-typedef enum {
-	PCF_THUNK		= 1,		// Ran the thinker this tic.
-	PCF_SPLASH		= 1<<1,		// Splashed on the ground, return to the ceiling after the animation's over
-	PCF_INVISIBLE	= 1<<2,		// Don't draw.
-	PCF_PIT			= 1<<3,		// Above pit.
-	PCF_FLIP		= 1<<4,		// Spawning from floor, moving upwards.
-} precipflag_t;
-
 // Map Object definition.
 struct mobj_t
 {
@@ -455,76 +444,6 @@ struct mobj_t
 	// WARNING: New fields must be added separately to savegame and Lua.
 };
 
-//
-// For precipitation
-//
-// Sometimes this is casted to a mobj_t,
-// so please keep the start of the
-// structure the same.
-//
-struct precipmobj_t
-{
-	// List: thinker links.
-	thinker_t thinker;
-
-	// Info for drawing: position.
-	fixed_t x, y, z;
-	fixed_t old_x, old_y, old_z; // position interpolation
-	fixed_t old_x2, old_y2, old_z2;
-
-	mobjtype_t type;
-	const mobjinfo_t *info; // &mobjinfo[mobj->type]
-
-	// Links in blocks (if needed).
-	// The blockmap is only used by precip to render.
-	precipmobj_t *bnext;
-	precipmobj_t **bprev; // killough 8/11/98: change to ptr-to-ptr
-
-	// More drawing info: to determine current sprite.
-	angle_t angle, pitch, roll; // orientation
-	angle_t old_angle, old_pitch, old_roll; // orientation interpolation
-	angle_t old_angle2, old_pitch2, old_roll2;
-	angle_t rollangle;
-	spritenum_t sprite; // used to find patch_t and flip value
-	UINT32 frame; // frame number, plus bits see p_pspr.h
-	UINT8 sprite2; // player sprites
-	UINT16 anim_duration; // for FF_ANIMATE states
-
-	UINT32 renderflags; // render flags
-	fixed_t spritexscale, spriteyscale;
-	fixed_t spritexoffset, spriteyoffset;
-	fixed_t old_spritexscale, old_spriteyscale;
-	fixed_t old_spritexoffset, old_spriteyoffset;
-	pslope_t *floorspriteslope; // The slope that the floorsprite is rotated by
-	INT16 lightlevel; // Add to sector lightlevel, -255 - 255
-
-	mprecipsecnode_t *touching_sectorlist; // a linked list of sectors where this object appears
-
-	subsector_t *subsector; // Subsector the mobj resides in.
-
-	// The closest interval over all contacted sectors (or things).
-	fixed_t floorz; // Nearest floor below.
-	fixed_t ceilingz; // Nearest ceiling above.
-	ffloor_t *floorrover; // FOF referred by floorz
-	ffloor_t *ceilingrover; // FOF referred by ceilingz
-	fixed_t floordrop;
-	fixed_t ceilingdrop;
-
-	// For movement checking.
-	fixed_t radius; // Fixed at 2*FRACUNIT
-	fixed_t height; // Fixed at 4*FRACUNIT
-
-	// Momentums, used to update position.
-	fixed_t momx, momy, momz;
-	fixed_t precipflags; // fixed_t so it uses the same spot as "pmomz" even as we use precipflags_t for it
-
-	INT32 tics; // state tic counter
-	state_t *state;
-	UINT32 flags; // flags from mobjinfo tables
-
-	tic_t lastThink;
-};
-
 // It's extremely important that all mobj_t*-reading code have access to this.
 boolean P_MobjWasRemoved(const mobj_t *th);
 
@@ -568,16 +487,12 @@ void P_SpawnHoop(mapthing_t *mthing);
 void P_SpawnItemPattern(mapthing_t *mthing);
 void P_SpawnItemLine(mapthing_t *mt1, mapthing_t *mt2);
 void P_SpawnHoopOfSomething(fixed_t x, fixed_t y, fixed_t z, fixed_t radius, INT32 number, mobjtype_t type, angle_t rotangle);
-void P_SpawnPrecipitation(void);
 void P_SpawnParaloop(fixed_t x, fixed_t y, fixed_t z, fixed_t radius, INT32 number, mobjtype_t type, statenum_t nstate, angle_t rotangle, boolean spawncenter);
 void *P_CreateFloorSpriteSlope(mobj_t *mobj);
 void P_RemoveFloorSpriteSlope(mobj_t *mobj);
 boolean P_BossTargetPlayer(mobj_t *actor, boolean closest);
 boolean P_SupermanLook4Players(mobj_t *actor);
 void P_DestroyRobots(void);
-boolean P_PrecipThinker(precipmobj_t *mobj);
-void P_NullPrecipThinker(precipmobj_t *mobj);
-void P_FreePrecipMobj(precipmobj_t *mobj);
 void P_SetScale(mobj_t *mobj, fixed_t newscale);
 void P_InstaScale(mobj_t *mobj, fixed_t newscale);
 void P_XYMovement(mobj_t *mo);
@@ -0,0 +1,689 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+// Copyright (C) 2020 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_precip.cpp
+/// \brief Weather particles, stored per blockmap cell
+
+#include <algorithm>
+#include <type_traits>
+
+#include <tracy/tracy/Tracy.hpp>
+
+#include "core/thread_pool.h"
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "d_clisrv.h" // dedicated
+#include "m_random.h"
+#include "p_local.h"
+#include "p_precip.h"
+#include "p_slopes.h"
+#include "p_tick.h" // thinkersCompleted
+#include "r_main.h"
+#include "r_sky.h"
+#include "z_zone.h"
+
+precipcell_t *precipcells;
+
+namespace
+{
+
+// Rows of blocks stepped by each thread pool task.
+constexpr INT32 kRowsPerTask = 4;
+
+// Below this many blocks, it isn't worth waking the thread pool.
+constexpr INT32 kMinParallelBlocks = 256;
+
+// Calls f(dst, src) with each pair of matching drop arrays of two cells, largest types first.
+template <typename F>
+void visit_arrays(precipcell_t& dst, precipcell_t& src, F&& f)
+{
+	f(dst.sector, src.sector);
+	f(dst.x, src.x);
+	f(dst.y, src.y);
+	f(dst.z, src.z);
+	f(dst.oldz, src.oldz);
+	f(dst.floorz, src.floorz);
+	f(dst.ceilingz, src.ceilingz);
+	f(dst.stamp, src.stamp);
+	f(dst.state, src.state);
+	f(dst.frame, src.frame);
+	f(dst.tics, src.tics);
+	f(dst.anim_duration, src.anim_duration);
+	f(dst.flags, src.flags);
+}
+
+// All of a cell's arrays share one allocation, which starts at its first array.
+void grow_cell(precipcell_t* cell)
+{
+	precipcell_t grown = *cell;
+	size_t dropsize = 0;
+	UINT8 *mem;
+
+	// Capacity stays a multiple of 8, which keeps every array in the block aligned.
+	grown.capacity = cell->capacity ? cell->capacity * 2 : 8;
+
+	visit_arrays(grown, *cell, [&dropsize](auto*& dst, auto*&) { dropsize += sizeof(*dst); });
+
+	mem = static_cast<UINT8*>(Z_Malloc(dropsize * grown.capacity, PU_LEVEL, nullptr));
+
+	visit_arrays(grown, *cell, [&mem, &grown, cell](auto*& dst, auto*& src)
+	{
+		using T = std::remove_reference_t<decltype(*dst)>;
+
+		dst = reinterpret_cast<T*>(mem);
+		mem += sizeof(T) * grown.capacity;
+
+		if (cell->count)
+		{
+			std::copy_n(src, cell->count, dst);
+		}
+	});
+
+	if (cell->sector != nullptr)
+	{
+		Z_Free(cell->sector);
+	}
+
+	*cell = grown;
+}
+
+void remove_drop(precipcell_t* cell, size_t i)
+{
+	const size_t last = --cell->count;
+
+	if (i == last)
+	{
+		return;
+	}
+
+	visit_arrays(*cell, *cell, [i, last](auto*& dst, auto*& src) { dst[i] = src[last]; });
+}
+
+// M_Random isn't safe off the main thread, and nothing here needs to be unpredictable.
+INT32 drop_random_key(const precipcell_t* cell, size_t i, INT32 n)
+{
+	UINT32 h = (UINT32)cell->x[i] * 0x9E3779B1u ^ (UINT32)cell->y[i] * 0x85EBCA77u ^ leveltime * 0xC2B2AE3Du;
+
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+
+	return (INT32)(h % (UINT32)n);
+}
+
+// Mirrors P_SetupStateAnimation, without the player sprite cases.
+void setup_drop_animation(precipcell_t* cell, size_t i, const state_t* st)
+{
+	const INT32 animlength = st->var1;
+
+	if (!(st->frame & FF_ANIMATE))
+	{
+		return;
+	}
+
+	if (animlength <= 0 || st->var2 == 0)
+	{
+		cell->frame[i] &= ~FF_ANIMATE;
+		return; // Crash/stupidity prevention
+	}
+
+	cell->anim_duration[i] = (UINT16)st->var2;
+
+	if (st->frame & FF_GLOBALANIM)
+	{
+		cell->anim_duration[i] -= (leveltime % st->var2);
+		cell->frame[i] += (leveltime / st->var2) % (animlength + 1);
+		if (!thinkersCompleted)
+			cell->anim_duration[i]++;
+	}
+	else if (st->frame & FF_RANDOMANIM)
+	{
+		cell->frame[i] += drop_random_key(cell, i, animlength + 1);
+		cell->anim_duration[i] -= drop_random_key(cell, i, st->var2);
+	}
+}
+
+// Mirrors P_CycleStateAnimation, without the player sprite cases.
+void cycle_drop_animation(precipcell_t* cell, size_t i)
+{
+	const state_t* st = &states[cell->state[i]];
+	UINT32 f = cell->frame[i];
+
+	if (!(f & FF_ANIMATE) || --cell->anim_duration[i] != 0)
+	{
+		return;
+	}
+
+	cell->anim_duration[i] = (UINT16)st->var2;
+
+	const UINT8 start = st->frame & FF_FRAMEMASK;
+	UINT8 frame = f & FF_FRAMEMASK;
+
+	if ((f & FF_REVERSEANIM ? (start - (--frame)) : ((++frame) - start)) > st->var1)
+		frame = start;
+
+	cell->frame[i] = frame | (f & ~FF_FRAMEMASK);
+}
+
+boolean set_drop_state(precipcell_t* cell, size_t i, statenum_t state)
+{
+	const state_t* st = &states[state];
+
+	if (state == S_NULL)
+	{
+		return false;
+	}
+
+	cell->state[i] = state;
+	cell->tics[i] = st->tics;
+	cell->frame[i] = st->frame;
+	setup_drop_animation(cell, i, st);
+
+	return true;
+}
+
+void calculate_drop_floor(precipcell_t* cell, size_t i)
+{
+	const sector_t* sec = cell->sector[i];
+	const fixed_t x = cell->x[i];
+	const fixed_t y = cell->y[i];
+	const boolean water = (precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES);
+	boolean setWater = false;
+	fixed_t floorz = P_GetSectorFloorZAt(sec, x, y);
+	fixed_t ceilingz = P_GetSectorCeilingZAt(sec, x, y);
+	ffloor_t* rover;
+	fixed_t height;
+
+	for (rover = sec->ffloors; rover; rover = rover->next)
+	{
+		// If it exists, it'll get rained on.
+		if (!(rover->fofflags & FOF_EXISTS))
+			continue;
+
+		if (water)
+		{
+			if (!(rover->fofflags & FOF_SWIMMABLE))
+				continue;
+
+			if (setWater == false)
+			{
+				ceilingz = P_GetFFloorTopZAt(rover, x, y);
+				floorz = P_GetFFloorBottomZAt(rover, x, y);
+				setWater = true;
+			}
+			else
+			{
+				height = P_GetFFloorTopZAt(rover, x, y);
+				if (height > ceilingz)
+					ceilingz = height;
+
+				height = P_GetFFloorBottomZAt(rover, x, y);
+				if (height < floorz)
+					floorz = height;
+			}
+		}
+		else
+		{
+			if (!(rover->fofflags & FOF_BLOCKOTHERS) && !(rover->fofflags & FOF_SWIMMABLE))
+				continue;
+
+			height = P_GetFFloorTopZAt(rover, x, y);
+			if (height > floorz)
+				floorz = height;
+		}
+	}
+
+	cell->floorz[i] = floorz;
+	cell->ceilingz[i] = ceilingz;
+	cell->stamp[i] = sec->precipstamp;
+
+	if (water && setWater == false)
+		cell->flags[i] |= PCF_INVISIBLE;
+	else
+		cell->flags[i] &= ~PCF_INVISIBLE;
+}
+
+// Everything but falling, which think_cell does for all drops at once.
+boolean think_drop(precipcell_t* cell, size_t i, const mobjinfo_t* info, boolean flip)
+{
+	if (cell->stamp[i] != cell->sector[i]->precipstamp)
+	{
+		calculate_drop_floor(cell, i);
+	}
+
+	cycle_drop_animation(cell, i);
+
+	if (cell->state[i] == S_RAINRETURN)
+	{
+		// Reset to ceiling!
+		if (!set_drop_state(cell, i, info->spawnstate))
+			return false;
+
+		cell->z[i] = cell->oldz[i] = (flip) ? (cell->floorz[i]) : (cell->ceilingz[i]);
+		cell->flags[i] &= ~PCF_SPLASH;
+	}
+
+	if (cell->tics[i] != -1)
+	{
+		if (cell->tics[i])
+		{
+			cell->tics[i]--;
+		}
+
+		if (cell->tics[i] == 0)
+		{
+			const statenum_t next = states[cell->state[i]].nextstate;
+
+			if ((cell->flags[i] & PCF_SPLASH) && (next == S_NULL))
+			{
+				// HACK: sprite changes are 1 tic late, so you would see splashes on the ceiling if not for this state.
+				// We need to use the settings from the previous state, since some of those are NOT 1 tic late.
+				const UINT32 frame = (cell->frame[i] & ~FF_FRAMEMASK);
+
+				set_drop_state(cell, i, S_RAINRETURN);
+				cell->frame[i] = frame;
+			}
+			else if (!set_drop_state(cell, i, next))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+boolean land_drop(precipcell_t* cell, size_t i, const mobjinfo_t* info, boolean flip)
+{
+	if ((info->deathstate == S_NULL) || (cell->flags[i] & PCF_PIT)) // no splashes on sky or bottomless pits
+	{
+		cell->z[i] = (flip) ? (cell->floorz[i]) : (cell->ceilingz[i]);
+	}
+	else
+	{
+		if (!set_drop_state(cell, i, info->deathstate))
+			return false;
+
+		cell->z[i] = (flip) ? (cell->ceilingz[i]) : (cell->floorz[i]);
+		cell->flags[i] |= PCF_SPLASH;
+	}
+
+	cell->oldz[i] = cell->z[i];
+	return true;
+}
+
+void think_cell(precipcell_t* cell, const mobjinfo_t* info, fixed_t momz, boolean flip)
+{
+	size_t i;
+
+	if (cell->lastThink == leveltime)
+	{
+		return; // already thinked this tic
+	}
+
+	cell->lastThink = leveltime;
+
+	std::copy_n(cell->z, cell->count, cell->oldz);
+
+	// State changes are rare, so they go one drop at a time.
+	// A removed drop is replaced by the last one, which still needs to think.
+	for (i = 0; i < cell->count;)
+	{
+		if (think_drop(cell, i, info, flip) == false)
+		{
+			remove_drop(cell, i);
+			continue;
+		}
+
+		i++;
+	}
+
+	// The fall itself is the same for every drop, and simple enough to vectorize.
+	{
+		fixed_t* const z = cell->z;
+		const UINT8* const flags = cell->flags;
+		const size_t count = cell->count;
+
+		for (i = 0; i < count; i++)
+		{
+			z[i] += (flags[i] & PCF_SPLASH) ? 0 : momz;
+		}
+	}
+
+	for (i = 0; i < cell->count;)
+	{
+		const boolean landed = !(cell->flags[i] & PCF_SPLASH)
+			&& ((flip) ? (cell->z[i] >= cell->ceilingz[i]) : (cell->z[i] <= cell->floorz[i]));
+
+		if (landed && land_drop(cell, i, info, flip) == false)
+		{
+			remove_drop(cell, i);
+			continue;
+		}
+
+		i++;
+	}
+}
+
+size_t add_drop(precipcell_t* cell, sector_t* sec, fixed_t x, fixed_t y, const mobjinfo_t* info)
+{
+	const state_t* st = &states[info->spawnstate];
+	fixed_t start_z;
+	size_t i;
+
+	if (cell->count == cell->capacity)
+	{
+		grow_cell(cell);
+	}
+
+	i = cell->count++;
+
+	cell->sector[i] = sec;
+	cell->x[i] = x;
+	cell->y[i] = y;
+	cell->flags[i] = 0;
+
+	// do not set the state with set_drop_state, spawnstate is allowed to be S_NULL here
+	cell->state[i] = info->spawnstate;
+	cell->tics[i] = st->tics;
+	cell->frame[i] = st->frame;
+	cell->anim_duration[i] = 0;
+	setup_drop_animation(cell, i, st);
+
+	start_z = P_GetSectorFloorZAt(sec, x, y);
+	calculate_drop_floor(cell, i);
+
+	if (cell->floorz[i] == start_z)
+	{
+		const boolean flip = (info->speed < 0);
+		INT32 dmg = sec->damagetype;
+		boolean sFlag = (flip) ? (sec->flags & MSF_FLIPSPECIAL_CEILING) : (sec->flags & MSF_FLIPSPECIAL_FLOOR);
+		boolean pitFloor = ((dmg == SD_DEATHPIT) && sFlag);
+		boolean skyFloor = (flip) ? (sec->ceilingpic == skyflatnum) : (sec->floorpic == skyflatnum);
+
+		if (pitFloor || skyFloor)
+		{
+			cell->flags[i] |= PCF_PIT;
+		}
+	}
+
+	return i;
+}
+
+statenum_t random_spawn_state(mobjtype_t type)
+{
+	const UINT8 randomstates = (UINT8)mobjinfo[type].damage;
+	statenum_t st = mobjinfo[type].spawnstate;
+
+	if (randomstates > 0)
+	{
+		UINT8 mrand = M_RandomByte();
+		UINT8 threshold = UINT8_MAX / (randomstates + 1);
+		UINT8 k;
+
+		for (k = 0; k < randomstates; k++)
+		{
+			if (mrand < (threshold * (k+1)))
+			{
+				st = static_cast<statenum_t>(st + k + 1);
+				break;
+			}
+		}
+	}
+
+	return st;
+}
+
+void spawn_precipitation_at(precipcell_t* cell, fixed_t basex, fixed_t basey)
+{
+	INT32 j;
+
+	const mobjtype_t type = precipprops[curWeather].type;
+	const mobjinfo_t* info = &mobjinfo[type];
+	const UINT8 randomstates = (UINT8)info->damage;
+
+	fixed_t i, x, y, z, height;
+
+	UINT16 numparticles = 0;
+	boolean condition = false;
+
+	subsector_t* precipsector = NULL;
+
+	// If mobjscale < FRACUNIT, each blockmap cell covers
+	// more area so spawn more precipitation in that area.
+	for (i = 0; i < FRACUNIT; i += mapobjectscale)
+	{
+		x = basex + ((M_RandomKey(MAPBLOCKUNITS << 3) << FRACBITS) >> 3);
+		y = basey + ((M_RandomKey(MAPBLOCKUNITS << 3) << FRACBITS) >> 3);
+
+		precipsector = R_PointInSubsectorOrNull(x, y);
+
+		// No sector? Stop wasting time,
+		// move on to the next entry in the blockmap
+		if (!precipsector)
+			continue;
+
+		// Not in a sector with visible sky?
+		if (precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES)
+		{
+			condition = false;
+
+			if (precipsector->sector->ffloors)
+			{
+				ffloor_t* rover;
+
+				for (rover = precipsector->sector->ffloors; rover; rover = rover->next)
+				{
+					if (!(rover->fofflags & FOF_EXISTS))
+						continue;
+
+					if (!(rover->fofflags & FOF_SWIMMABLE))
+						continue;
+
+					condition = true;
+					break;
+				}
+			}
+		}
+		else
+		{
+			condition = (precipsector->sector->ceilingpic == skyflatnum);
+		}
+
+		if (precipsector->sector->flags & MSF_INVERTPRECIP)
+		{
+			condition = !condition;
+		}
+
+		if (!condition)
+		{
+			continue;
+		}
+
+		height = precipsector->sector->ceilingheight - precipsector->sector->floorheight;
+		height = FixedDiv(height, mapobjectscale);
+
+		// Exists, but is too small for reasonable precipitation.
+		if (height < 64<<FRACBITS)
+			continue;
+
+		// Hack around a quirk of this entire system, where taller sectors look like they get less precipitation.
+		numparticles = 1 + (height / (MAPBLOCKUNITS<<4<<FRACBITS));
+
+		for (j = 0; j < numparticles; j++)
+		{
+			const size_t drop = add_drop(cell, precipsector->sector, x, y, info);
+			INT32 floorz;
+			INT32 ceilingz;
+
+			if (randomstates > 0)
+			{
+				set_drop_state(cell, drop, random_spawn_state(type));
+			}
+
+			floorz = cell->floorz[drop] >> FRACBITS;
+			ceilingz = cell->ceilingz[drop] >> FRACBITS;
+
+			if (floorz < ceilingz)
+			{
+				// Randomly assign a height, now that floorz is set.
+				z = M_RandomRange(floorz, ceilingz) << FRACBITS;
+			}
+			else
+			{
+				// ...except if the floor is above the ceiling.
+				z = ceilingz << FRACBITS;
+			}
+
+			cell->z[drop] = cell->oldz[drop] = z;
+		}
+	}
+}
+
+} // namespace
+
+void P_InitPrecipitation(void)
+{
+	precipcells = static_cast<precipcell_t*>(Z_Calloc(sizeof (*precipcells) * bmapwidth * bmapheight, PU_LEVEL, NULL));
+}
+
+void P_SpawnPrecipitation(void)
+{
+	INT32 i;
+
+	const mobjtype_t type = precipprops[curWeather].type;
+
+	fixed_t basex, basey;
+
+	if (dedicated || !cv_drawdist_precip.value || type == MT_NULL || precipcells == NULL)
+		return;
+
+	// Use the blockmap to narrow down our placing patterns
+	for (i = 0; i < bmapwidth*bmapheight; ++i)
+	{
+		basex = bmaporgx + (i % bmapwidth) * MAPBLOCKSIZE;
+		basey = bmaporgy + (i / bmapwidth) * MAPBLOCKSIZE;
+
+		spawn_precipitation_at(&precipcells[i], basex, basey);
+	}
+}
+
+void P_ClearPrecipitation(void)
+{
+	INT32 i;
+
+	if (precipcells == NULL)
+		return;
+
+	for (i = 0; i < bmapwidth*bmapheight; ++i)
+	{
+		precipcell_t *cell = &precipcells[i];
+
+		if (cell->sector != NULL)
+			Z_Free(cell->sector);
+
+		*cell = {};
+	}
+}
+
+void P_ChangePrecipitationType(mobjtype_t type)
+{
+	INT32 i;
+	size_t j;
+
+	if (precipcells == NULL)
+		return;
+
+	for (i = 0; i < bmapwidth*bmapheight; ++i)
+	{
+		precipcell_t *cell = &precipcells[i];
+
+		for (j = 0; j < cell->count; j++)
+		{
+			set_drop_state(cell, j, random_spawn_state(type));
+
+			// A drop caught mid-splash would otherwise never fall again.
+			cell->flags[j] &= ~PCF_SPLASH;
+
+			// Water particles and regular weather don't land on the same things.
+			calculate_drop_floor(cell, j);
+		}
+	}
+}
+
+// Drops in this sector look for their floor and ceiling again the next time they think.
+void P_RecalcPrecipInSector(sector_t *sector)
+{
+	if (!sector)
+		return;
+
+	sector->moved = true; // Recalc lighting and things too, maybe
+	sector->precipstamp++;
+}
+
+void P_ThinkPrecipitationBlocks(INT32 xl, INT32 xh, INT32 yl, INT32 yh)
+{
+	ZoneScoped;
+
+	const mobjtype_t type = precipprops[curWeather].type;
+
+	if (precipcells == NULL || type == MT_NULL || xl > xh || yl > yh)
+		return;
+
+	const mobjinfo_t *info = &mobjinfo[type];
+	const fixed_t momz = FixedMul(-info->speed, mapobjectscale);
+	const boolean flip = (info->speed < 0);
+
+	auto think_rows = [info, momz, flip, xl, xh](INT32 first, INT32 last)
+	{
+		for (INT32 by = first; by <= last; by++)
+		{
+			for (INT32 bx = xl; bx <= xh; bx++)
+			{
+				think_cell(&precipcells[(by * bmapwidth) + bx], info, momz, flip);
+			}
+		}
+	};
+
+	if (srb2::g_main_threadpool == nullptr || (xh - xl + 1) * (yh - yl + 1) < kMinParallelBlocks)
+	{
+		think_rows(yl, yh);
+		return;
+	}
+
+	srb2::g_main_threadpool->begin_sema();
+
+	for (INT32 by = yl; by <= yh; by += kRowsPerTask)
+	{
+		const INT32 last = std::min(by + kRowsPerTask - 1, yh);
+
+		srb2::g_main_threadpool->schedule([think_rows, by, last]() -> void { think_rows(by, last); });
+	}
+
+	srb2::ThreadPool::Sema sema = srb2::g_main_threadpool->end_sema();
+	srb2::g_main_threadpool->notify_sema(sema);
+	srb2::g_main_threadpool->wait_sema(sema);
+}
+
+size_t P_CountPrecipitation(void)
+{
+	size_t count = 0;
+	INT32 i;
+
+	if (precipcells == NULL)
+		return 0;
+
+	for (i = 0; i < bmapwidth*bmapheight; ++i)
+	{
+		count += precipcells[i].count;
+	}
+
+	return count;
+}
@@ -0,0 +1,75 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_precip.h
+/// \brief Weather particles, stored per blockmap cell
+
+#ifndef __P_PRECIP__
+#define __P_PRECIP__
+
+#include "doomtype.h"
+#include "typedef.h"
+#include "info.h"
+#include "m_fixed.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+	PCF_SPLASH		= 1,		// Splashed on the ground, return to the ceiling after the animation's over
+	PCF_INVISIBLE	= 1<<1,		// Don't draw.
+	PCF_PIT			= 1<<2,		// Above pit.
+} precipflag_t;
+
+// Precipitation isn't networked and never touches
+// the game, so drops are not mobjs. Each blockmap
+// cell keeps its drops in parallel arrays instead,
+// and the renderers step a cell the first time they
+// draw it in a tic.
+struct precipcell_t
+{
+	// One entry per drop in each of these.
+	sector_t **sector;
+	fixed_t *x, *y, *z;
+	fixed_t *oldz; // z at the start of the tic, for interpolation
+	fixed_t *floorz, *ceilingz;
+	UINT32 *stamp; // sector->precipstamp when floorz and ceilingz were found
+	statenum_t *state;
+	UINT32 *frame;
+	INT32 *tics;
+	UINT16 *anim_duration; // for FF_ANIMATE states
+	UINT8 *flags; // precipflag_t
+
+	UINT16 count;
+	UINT16 capacity;
+
+	tic_t lastThink;
+};
+
+extern precipcell_t *precipcells; // bmapwidth*bmapheight of them, PU_LEVEL
+
+void P_InitPrecipitation(void);
+void P_SpawnPrecipitation(void);
+void P_ClearPrecipitation(void);
+
+// Changes every drop to a new type in place, for P_SwitchWeather.
+void P_ChangePrecipitationType(mobjtype_t type);
+
+// Brings every cell in the box of blocks up to date for this tic,
+// on the thread pool if there is enough to do.
+void P_ThinkPrecipitationBlocks(INT32 xl, INT32 xh, INT32 yl, INT32 yh);
+
+size_t P_CountPrecipitation(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __P_PRECIP__
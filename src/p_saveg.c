@@ -4025,8 +4025,7 @@ static void P_NetArchiveThinkers(savebuffer_t *save)
 		// save off the current thinkers
 		for (th = thlist[i].next; th != &thlist[i]; th = th->next)
 		{
-			if (!(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed
-			 || th->function.acp1 == (actionf_p1)P_NullPrecipThinker))
+			if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
 				numsaved++;
 
 			if (th->function.acp1 == (actionf_p1)P_MobjThinker)
@@ -4034,9 +4033,6 @@ static void P_NetArchiveThinkers(savebuffer_t *save)
 				SaveMobjThinker(save, th, tc_mobj);
 				continue;
 			}
-	#ifdef PARANOIA
-			else if (th->function.acp1 == (actionf_p1)P_NullPrecipThinker);
-	#endif
 			else if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
 			{
 				SaveCeilingThinker(save, th, tc_ceiling);
@@ -4297,6 +4293,9 @@ static void P_NetUnArchiveWaypoints(savebuffer_t *save)
 					CONS_Debug(DBG_GAMELOGIC, "waypoint mobj not found for %d\n", i);
 				}
 			}
+
+			K_InvalidateFinishDistances();
+			K_InvalidateWaypointGrid();
 		}
 	}
 
@@ -5457,7 +5456,7 @@ static void P_NetUnArchiveThinkers(savebuffer_t *save)
 
 			currentthinker->references = 0; // Heinous but this is the only place the assertion in P_UnlinkThinkers is wrong
 
-			if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker || currentthinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
+			if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
 				P_RemoveSavegameMobj((mobj_t *)currentthinker); // item isn't saved, don't remove it
 			else
 			{
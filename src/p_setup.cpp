@@ -65,6 +65,7 @@
 #include "m_argv.h"
 
 #include "p_polyobj.h"
+#include "p_precip.h"
 
 #include "v_video.h"
 
@@ -185,7 +186,6 @@ INT32 *blockmaplump; // Big blockmap
 fixed_t bmaporgx, bmaporgy;
 // for thing chains
 mobj_t **blocklinks;
-precipmobj_t **precipblocklinks;
 
 // REJECT
 // For fast sight rejection.
@@ -596,6 +596,7 @@ levelflat_t *foundflats;
 //SoM: Other files want this info.
 size_t P_PrecacheLevelFlats(void)
 {
+	std::vector<lumpnum_t> lumps;
 	lumpnum_t lump;
 	size_t i;
 
@@ -608,9 +609,12 @@ size_t P_PrecacheLevelFlats(void)
 			lump = levelflats[i].u.flat.lumpnum;
 			if (devparm)
 				flatmemory += W_LumpLength(lump);
-			R_GetFlat(lump);
+			lumps.push_back(lump);
 		}
 	}
+
+	// Same as R_GetFlat on each one, but reads them all at once.
+	W_CacheLumpNums(lumps.data(), lumps.size(), PU_LEVEL);
 	return flatmemory;
 }
 
@@ -1004,7 +1008,7 @@ static void P_InitializeSector(sector_t *ss)
 
 	ss->floorspeed = ss->ceilspeed = 0;
 
-	ss->touching_preciplist = NULL;
+	ss->precipstamp = 0;
 
 	ss->f_slope = NULL;
 	ss->c_slope = NULL;
@@ -4166,8 +4170,7 @@ static boolean P_LoadBlockMap(UINT8 *data, size_t count)
 	count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
 	polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
 
-	count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-	precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	P_InitPrecipitation();
 
 	return true;
 }
@@ -4423,8 +4426,7 @@ static void P_CreateBlockMap(void)
 		count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
 		polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
 
-		count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-		precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+		P_InitPrecipitation();
 	}
 }
 
@@ -8777,6 +8779,9 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	if (precache || dedicated)
 		R_PrecacheLevel();
 
+	if (precache && !reloadinggamestate)
+		S_PrecacheLevelSounds();
+
 	if (!demo.playback)
 	{
 		mapheaderinfo[gamemap-1]->records.mapvisited |= MV_VISITED;
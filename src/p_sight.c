@@ -15,7 +15,9 @@
 
 #include "doomdef.h"
 #include "doomstat.h"
+#include "m_perfstats.h" // ps_sightcache_hits
 #include "p_local.h"
+#include "p_polyobj.h"
 #include "p_slopes.h"
 #include "r_main.h"
 #include "r_state.h"
@@ -39,6 +41,8 @@ typedef struct
 	mobj_t *t1, *t2;
 	boolean alreadyHates;				// For bot traversal, for if the bot is already in a sector it doesn't want to be
 	UINT8 traversed;
+
+	sightmarks_t *marks;				// Lines and polyobjects already checked, if not going by validcount
 } los_t;
 
 typedef boolean (*los_init_t)(mobj_t *, mobj_t *, register los_t *);
@@ -54,6 +58,196 @@ typedef struct
 
 static INT32 sightcounts[2];
 
+//
+// Sight cache
+//
+// Bots ask the same questions about the same objects several times while
+// their ticcmd is built, and nothing in the level moves while that happens.
+// Traces that keep their own marks therefore also keep their answers, which
+// stay good until P_ClearSightCache for as long as neither object has moved.
+//
+// Traces by validcount are never cached. During P_Ticker, sectors,
+// polyobjects and slopes can move between two checks of the same pair, and
+// the validators read player and FOF state that no key could cover, so a
+// cached answer there could differ from a fresh one. The camera, the HUD and
+// Lua all trace the same way as the thinkers, so none of them can leave
+// anything behind that synced code would later read.
+//
+
+typedef enum
+{
+	LOS_SIGHT,
+	LOS_BLOCKINGLINES,
+	LOS_BOTTRAVERSAL,
+	LOS_WAYPOINTTRAVERSAL,
+} loskind_t;
+
+#define SIGHTCACHE_BITS 8
+#define SIGHTCACHE_SIZE (1 << SIGHTCACHE_BITS)
+
+typedef struct
+{
+	mobj_t *t1, *t2;
+	fixed_t t1x, t1y, t1z, t1height;
+	fixed_t t2x, t2y, t2z, t2height;
+	UINT32 t1eflags, t2eflags;
+	UINT32 epoch; // entry is empty unless this matches the marks' cacheepoch
+	UINT8 kind;
+	boolean result;
+} sightcache_t;
+
+//
+// Sight marks
+//
+// validcount and the marks it leaves on lines are shared by everything,
+// so traces run off the main thread keep their own. Each trace takes a
+// fresh stamp, so stale marks never need clearing.
+//
+
+struct sightmarks_t
+{
+	UINT32 *lines;
+	UINT32 *polys;
+	size_t numlines, numpolys;
+	UINT32 stamp;
+
+	sightcache_t cache[SIGHTCACHE_SIZE];
+	UINT32 cacheepoch;
+	INT32 cachehits, cachemisses;
+};
+
+sightmarks_t *P_NewSightMarks(void)
+{
+	sightmarks_t *marks = calloc(1, sizeof (*marks));
+
+	if (marks == NULL)
+		I_Error("%s: Out of memory", "P_NewSightMarks");
+
+	marks->cacheepoch = 1;
+
+	return marks;
+}
+
+void P_FreeSightMarks(sightmarks_t *marks)
+{
+	if (marks == NULL)
+		return;
+
+	free(marks->lines);
+	free(marks->polys);
+	free(marks);
+}
+
+void P_ClearSightCache(sightmarks_t *marks)
+{
+	marks->cachehits = marks->cachemisses = 0;
+
+	if (++marks->cacheepoch == 0)
+	{
+		// Wrapped around, so old entries could look current again.
+		memset(marks->cache, 0, sizeof marks->cache);
+		marks->cacheepoch = 1;
+	}
+}
+
+// Main thread only, once the traces using marks are done.
+void P_AddSightCacheStats(const sightmarks_t *marks)
+{
+	ps_sightcache_hits += marks->cachehits;
+	ps_sightcache_misses += marks->cachemisses;
+}
+
+static sightcache_t *P_SightCacheSlot(sightmarks_t *marks, mobj_t *t1, mobj_t *t2, loskind_t kind)
+{
+	UINT32 hash = (UINT32)kind;
+
+	hash = (hash ^ (UINT32)t1->x) * 0x9E3779B1u;
+	hash = (hash ^ (UINT32)t1->y) * 0x9E3779B1u;
+	hash = (hash ^ (UINT32)t2->x) * 0x9E3779B1u;
+	hash = (hash ^ (UINT32)t2->y) * 0x9E3779B1u;
+
+	return &marks->cache[hash >> (32 - SIGHTCACHE_BITS)];
+}
+
+static boolean P_SightCacheMatches(const sightmarks_t *marks, const sightcache_t *entry, mobj_t *t1, mobj_t *t2, loskind_t kind)
+{
+	return (entry->epoch == marks->cacheepoch
+		&& entry->kind == kind
+		&& entry->t1 == t1 && entry->t2 == t2
+		&& entry->t1x == t1->x && entry->t1y == t1->y
+		&& entry->t1z == t1->z && entry->t1height == t1->height
+		&& entry->t2x == t2->x && entry->t2y == t2->y
+		&& entry->t2z == t2->z && entry->t2height == t2->height
+		&& entry->t1eflags == t1->eflags && entry->t2eflags == t2->eflags);
+}
+
+static void P_BeginSightMarks(sightmarks_t *marks)
+{
+	if (marks->numlines != numlines || marks->numpolys != (size_t)numPolyObjects)
+	{
+		free(marks->lines);
+		free(marks->polys);
+
+		marks->numlines = numlines;
+		marks->numpolys = numPolyObjects;
+		marks->lines = calloc(marks->numlines + 1, sizeof (*marks->lines));
+		marks->polys = calloc(marks->numpolys + 1, sizeof (*marks->polys));
+		marks->stamp = 0;
+
+		if (marks->lines == NULL || marks->polys == NULL)
+			I_Error("%s: Out of memory", "P_BeginSightMarks");
+	}
+
+	if (++marks->stamp == 0)
+	{
+		// Wrapped around, so old marks could look current again.
+		memset(marks->lines, 0, marks->numlines * sizeof (*marks->lines));
+		memset(marks->polys, 0, marks->numpolys * sizeof (*marks->polys));
+		marks->stamp = 1;
+	}
+}
+
+// Returns true if this trace has already checked the line, and marks it if not.
+static boolean P_SightLineChecked(line_t *line, los_t *los)
+{
+	if (los->marks != NULL)
+	{
+		UINT32 *mark = &los->marks->lines[line - lines];
+
+		if (*mark == los->marks->stamp)
+			return true;
+
+		*mark = los->marks->stamp;
+		return false;
+	}
+
+	if (line->validcount == validcount)
+		return true;
+
+	line->validcount = validcount;
+	return false;
+}
+
+static boolean P_SightPolyObjChecked(polyobj_t *po, los_t *los)
+{
+	if (los->marks != NULL)
+	{
+		UINT32 *mark = &los->marks->polys[po - PolyObjects];
+
+		if (*mark == los->marks->stamp)
+			return true;
+
+		*mark = los->marks->stamp;
+		return false;
+	}
+
+	if (po->validcount == validcount)
+		return true;
+
+	po->validcount = validcount;
+	return false;
+}
+
 #ifdef DEVELOP
 extern consvar_t cv_debugtraversemax;
 #undef TRAVERSE_MAX
@@ -137,11 +331,9 @@ static boolean P_CrossSubsecPolyObj(polyobj_t *po, register los_t *los, register
 		const vertex_t *v1,*v2;
 
 		// already checked other side?
-		if (line->validcount == validcount)
+		if (P_SightLineChecked(line, los))
 			continue;
 
-		line->validcount = validcount;
-
 		// OPTIMIZE: killough 4/20/98: Added quick bounding-box rejection test
 		if (line->bbox[BOXLEFT  ] > los->bbox[BOXRIGHT ] ||
 			line->bbox[BOXRIGHT ] < los->bbox[BOXLEFT  ] ||
@@ -326,6 +518,7 @@ static boolean P_CanBotTraverse(seg_t *seg, divline_t *divl, register los_t *los
 	const boolean flip = ((los->t1->eflags & MFE_VERTICALFLIP) == MFE_VERTICALFLIP);
 	line_t *line = seg->linedef;
 	fixed_t frac = 0;
+	fixed_t x, y;
 	boolean canStepUp, canDropOff;
 	fixed_t maxstep = 0;
 	opening_t open = {0};
@@ -340,13 +533,18 @@ static boolean P_CanBotTraverse(seg_t *seg, divline_t *divl, register los_t *los
 	frac = P_InterceptVector(&los->strace, divl);
 
 	// calculate position at intercept
-	g_tm.x = los->strace.x + FixedMul(los->strace.dx, frac);
-	g_tm.y = los->strace.y + FixedMul(los->strace.dy, frac);
+	// This used to be written to g_tm.x/y, but only so P_LineOpening could
+	// read it back; every other P_LineOpening caller sets them itself first.
+	// Only bots building their ticcmds trace this, which happens on the
+	// server alone and maybe off the main thread, so leaving g_tm alone also
+	// keeps it the same on the server as on every client.
+	x = los->strace.x + FixedMul(los->strace.dx, frac);
+	y = los->strace.y + FixedMul(los->strace.dy, frac);
 
 	// set openrange, opentop, openbottom
 	open.fofType = (flip ? LO_FOF_CEILINGS : LO_FOF_FLOORS);
-	P_LineOpening(line, los->t1, &open);
-	maxstep = P_GetThingStepUp(los->t1, g_tm.x, g_tm.y);
+	P_LineOpeningAt(line, los->t1, x, y, &open);
+	maxstep = P_GetThingStepUp(los->t1, x, y);
 
 	if (open.range < los->t1->height)
 	{
@@ -368,7 +566,7 @@ static boolean P_CanBotTraverse(seg_t *seg, divline_t *divl, register los_t *los
 			UINT8 side = P_DivlineSide(los->t2x, los->t2y, divl) & 1;
 			sector_t *sector = (side == 1) ? seg->backsector : seg->frontsector;
 
-			if (K_BotHatesThisSector(los->t1->player, sector, g_tm.x, g_tm.y))
+			if (K_BotHatesThisSector(los->t1->player, sector, x, y))
 			{
 				// This line does not block us, but we don't want to cross it regardless.
 				return false;
@@ -493,9 +691,8 @@ static boolean P_CrossSubsector(size_t num, register los_t *los, register los_fu
 		{
 			while (po)
 			{
-				if (po->validcount != validcount)
+				if (!P_SightPolyObjChecked(po, los))
 				{
-					po->validcount = validcount;
 					if (!P_CrossSubsecPolyObj(po, los, funcs))
 						return false;
 				}
@@ -514,11 +711,9 @@ static boolean P_CrossSubsector(size_t num, register los_t *los, register los_fu
 			continue;
 
 		// already checked other side?
-		if (line->validcount == validcount)
+		if (P_SightLineChecked(line, los))
 			continue;
 
-		line->validcount = validcount;
-
 		// OPTIMIZE: killough 4/20/98: Added quick bounding-box rejection test
 		if (line->bbox[BOXLEFT  ] > los->bbox[BOXRIGHT ] ||
 			line->bbox[BOXRIGHT ] < los->bbox[BOXLEFT  ] ||
@@ -596,7 +791,8 @@ static boolean P_InitCheckSight(mobj_t *t1, mobj_t *t2, register los_t *los)
 
 	// An unobstructed LOS is possible.
 	// Now look from eyes of t1 to any part of t2.
-	sightcounts[1]++;
+	if (los->marks == NULL)
+		sightcounts[1]++;
 
 	// Prevent SOME cases of looking through 3dfloors
 	//
@@ -681,11 +877,58 @@ static boolean P_InitTraceBotTraversal(mobj_t *t1, mobj_t *t2, register los_t *l
 	return true;
 }
 
-static boolean P_CompareMobjsAcrossLines(mobj_t *t1, mobj_t *t2, register los_funcs_t *funcs)
+static boolean P_CrossMobjsBSP(mobj_t *t1, mobj_t *t2, sightmarks_t *marks, register los_funcs_t *funcs)
 {
 	los_t los;
+
+	if (marks != NULL)
+		P_BeginSightMarks(marks);
+	else
+		validcount++;
+
+	los.t1 = t1;
+	los.t2 = t2;
+	los.alreadyHates = false;
+	los.traversed = 0;
+	los.marks = marks;
+
+	los.topslope =
+		(los.bottomslope = t2->z - (los.sightzstart =
+			t1->z + t1->height -
+			(t1->height>>2))) + t2->height;
+	los.strace.dx = (los.t2x = t2->x) - (los.strace.x = t1->x);
+	los.strace.dy = (los.t2y = t2->y) - (los.strace.y = t1->y);
+
+	if (t1->x > t2->x)
+		los.bbox[BOXRIGHT] = t1->x, los.bbox[BOXLEFT] = t2->x;
+	else
+		los.bbox[BOXRIGHT] = t2->x, los.bbox[BOXLEFT] = t1->x;
+
+	if (t1->y > t2->y)
+		los.bbox[BOXTOP] = t1->y, los.bbox[BOXBOTTOM] = t2->y;
+	else
+		los.bbox[BOXTOP] = t2->y, los.bbox[BOXBOTTOM] = t1->y;
+
+	if (funcs->init != NULL)
+	{
+		if (funcs->init(t1, t2, &los) == false)
+		{
+			return false;
+		}
+	}
+
+	// The only required function.
+	I_Assert(funcs->validate != NULL);
+
+	// the head node is the last node output
+	return P_CrossBSPNode((INT32)numnodes - 1, &los, funcs);
+}
+
+static boolean P_CompareMobjsAcrossLines(mobj_t *t1, mobj_t *t2, loskind_t kind, sightmarks_t *marks, register los_funcs_t *funcs)
+{
 	const sector_t *s1, *s2;
 	size_t pnum;
+	sightcache_t *entry;
 
 	// First check for trivial rejection.
 	if (P_MobjWasRemoved(t1) == true || P_MobjWasRemoved(t2) == true)
@@ -721,43 +964,40 @@ static boolean P_CompareMobjsAcrossLines(mobj_t *t1, mobj_t *t2, register los_fu
 		return true;
 	}
 
-	validcount++;
-
-	los.t1 = t1;
-	los.t2 = t2;
-	los.alreadyHates = false;
-	los.traversed = 0;
-
-	los.topslope =
-		(los.bottomslope = t2->z - (los.sightzstart =
-			t1->z + t1->height -
-			(t1->height>>2))) + t2->height;
-	los.strace.dx = (los.t2x = t2->x) - (los.strace.x = t1->x);
-	los.strace.dy = (los.t2y = t2->y) - (los.strace.y = t1->y);
-
-	if (t1->x > t2->x)
-		los.bbox[BOXRIGHT] = t1->x, los.bbox[BOXLEFT] = t2->x;
-	else
-		los.bbox[BOXRIGHT] = t2->x, los.bbox[BOXLEFT] = t1->x;
+	if (marks == NULL)
+	{
+		// Going by validcount, which is never cached.
+		return P_CrossMobjsBSP(t1, t2, NULL, funcs);
+	}
 
-	if (t1->y > t2->y)
-		los.bbox[BOXTOP] = t1->y, los.bbox[BOXBOTTOM] = t2->y;
-	else
-		los.bbox[BOXTOP] = t2->y, los.bbox[BOXBOTTOM] = t1->y;
+	entry = P_SightCacheSlot(marks, t1, t2, kind);
 
-	if (funcs->init != NULL)
+	if (P_SightCacheMatches(marks, entry, t1, t2, kind))
 	{
-		if (funcs->init(t1, t2, &los) == false)
-		{
-			return false;
-		}
+		marks->cachehits++;
+		return entry->result;
 	}
 
-	// The only required function.
-	I_Assert(funcs->validate != NULL);
-
-	// the head node is the last node output
-	return P_CrossBSPNode((INT32)numnodes - 1, &los, funcs);
+	marks->cachemisses++;
+
+	entry->result = P_CrossMobjsBSP(t1, t2, marks, funcs);
+
+	entry->t1 = t1;
+	entry->t2 = t2;
+	entry->t1x = t1->x;
+	entry->t1y = t1->y;
+	entry->t1z = t1->z;
+	entry->t1height = t1->height;
+	entry->t2x = t2->x;
+	entry->t2y = t2->y;
+	entry->t2z = t2->z;
+	entry->t2height = t2->height;
+	entry->t1eflags = t1->eflags;
+	entry->t2eflags = t2->eflags;
+	entry->epoch = marks->cacheepoch;
+	entry->kind = kind;
+
+	return entry->result;
 }
 
 //
@@ -767,6 +1007,18 @@ static boolean P_CompareMobjsAcrossLines(mobj_t *t1, mobj_t *t2, register los_fu
 // Uses REJECT.
 //
 boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
+{
+	return P_CheckSightMarked(t1, t2, NULL);
+}
+
+//
+// P_CheckSightMarked
+//
+// P_CheckSight that keeps its visited marks in marks, instead of validcount,
+// so it can run off the main thread. Answers are also cached in marks until
+// the next P_ClearSightCache. NULL marks is the same as P_CheckSight.
+//
+boolean P_CheckSightMarked(mobj_t *t1, mobj_t *t2, sightmarks_t *marks)
 {
 	los_funcs_t funcs = {0};
 
@@ -774,7 +1026,7 @@ boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 	funcs.validate = &P_IsVisible;
 	funcs.validatePolyobj = &P_IsVisiblePolyObj;
 
-	return P_CompareMobjsAcrossLines(t1, t2, &funcs);
+	return P_CompareMobjsAcrossLines(t1, t2, LOS_SIGHT, marks, &funcs);
 }
 
 boolean P_TraceBlockingLines(mobj_t *t1, mobj_t *t2)
@@ -783,17 +1035,22 @@ boolean P_TraceBlockingLines(mobj_t *t1, mobj_t *t2)
 
 	funcs.validate = &P_CanTraceBlockingLine;
 
-	return P_CompareMobjsAcrossLines(t1, t2, &funcs);
+	return P_CompareMobjsAcrossLines(t1, t2, LOS_BLOCKINGLINES, NULL, &funcs);
 }
 
 boolean P_TraceBotTraversal(mobj_t *t1, mobj_t *t2)
+{
+	return P_TraceBotTraversalMarked(t1, t2, NULL);
+}
+
+boolean P_TraceBotTraversalMarked(mobj_t *t1, mobj_t *t2, sightmarks_t *marks)
 {
 	los_funcs_t funcs = {0};
 
 	funcs.init = &P_InitTraceBotTraversal;
 	funcs.validate = &P_CanBotTraverse;
 
-	return P_CompareMobjsAcrossLines(t1, t2, &funcs);
+	return P_CompareMobjsAcrossLines(t1, t2, LOS_BOTTRAVERSAL, marks, &funcs);
 }
 
 boolean P_TraceWaypointTraversal(mobj_t *t1, mobj_t *t2)
@@ -802,5 +1059,5 @@ boolean P_TraceWaypointTraversal(mobj_t *t1, mobj_t *t2)
 
 	funcs.validate = &P_CanWaypointTraverse;
 
-	return P_CompareMobjsAcrossLines(t1, t2, &funcs);
+	return P_CompareMobjsAcrossLines(t1, t2, LOS_WAYPOINTTRAVERSAL, NULL, &funcs);
 }
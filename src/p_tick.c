@@ -21,6 +21,7 @@
 #include "s_sound.h"
 #include "st_stuff.h"
 #include "p_polyobj.h"
+#include "p_precip.h"
 #include "m_random.h"
 #include "m_cond.h" // gamedata->playtime
 #include "lua_script.h"
@@ -53,6 +54,7 @@
 #include "k_endcam.h"
 
 #include "lua_profile.h"
+#include "lua_alloc.h"
 
 #ifdef PARANOIA
 #include "deh_tables.h" // MOBJTYPE_LIST
@@ -165,7 +167,7 @@ void Command_Numthinkers_f(void)
 		CONS_Printf(M_GetText("numthinkers <#>: Count number of thinkers\n"));
 		CONS_Printf(
 			"\t1: P_MobjThinker\n"
-			"\t2: P_NullPrecipThinker\n"
+			"\t2: Precipitation\n"
 			"\t3: T_Friction\n"
 			"\t4: T_Pusher\n"
 			"\t5: P_RemoveThinkerDelayed\n");
@@ -182,10 +184,10 @@ void Command_Numthinkers_f(void)
 			CONS_Printf(M_GetText("Number of %s: "), "P_MobjThinker");
 			break;
 		case 2:
-			start = end = THINK_PRECIP;
-			action = (actionf_p1)P_NullPrecipThinker;
-			CONS_Printf(M_GetText("Number of %s: "), "P_NullPrecipThinker");
-			break;
+			// Not thinkers anymore, but still worth counting
+			CONS_Printf(M_GetText("Number of %s: "), "precipitation drops");
+			CONS_Printf("%s\n", sizeu1(P_CountPrecipitation()));
+			return;
 		case 3:
 			start = end = THINK_MAIN;
 			action = (actionf_p1)T_Friction;
@@ -918,6 +920,7 @@ void P_Ticker(boolean run)
 		}
 
 		LUA_ResetTicTimers();
+		LUA_HeapTicker(gLheap);
 
 		ps_lua_mobjhooks = 0;
 		ps_checkposition_calls = 0;
@@ -1067,6 +1070,7 @@ void P_Ticker(boolean run)
 		ps_thinkertime = I_GetPreciseTime();
 		P_RunThinkers();
 		ps_thinkertime = I_GetPreciseTime() - ps_thinkertime;
+		ps_ranthinkers = true;
 		thinkersCompleted = true;
 
 		// Run any "after all the other thinkers" stuff
@@ -1153,7 +1153,8 @@ void R_PrecacheLevel(void)
 {
 	char *texturepresent, *spritepresent;
 	size_t i, j, k;
-	lumpnum_t lump;
+	lumpnum_t lump, *spritelumps;
+	size_t numspritelumps;
 
 	thinker_t *th;
 	spriteframe_t *sf;
@@ -1215,6 +1216,18 @@ void R_PrecacheLevel(void)
 		if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
 			spritepresent[((mobj_t *)th)->sprite] = 1;
 
+	// Gather every lump first, so they can be read in parallel.
+	numspritelumps = 0;
+	for (i = 0; i < numsprites; i++)
+	{
+		if (spritepresent[i])
+			numspritelumps += sprites[i].numframes * 16;
+	}
+
+	spritelumps = malloc(numspritelumps * sizeof (*spritelumps));
+	if (numspritelumps && spritelumps == NULL) I_Error("%s: Out of memory looking up sprites", "R_PrecacheLevel");
+	numspritelumps = 0;
+
 	spritememory = 0;
 	for (i = 0; i < numsprites; i++)
 	{
@@ -1228,7 +1241,7 @@ void R_PrecacheLevel(void)
 		lump = sf->lumppat[a];\
 		if (devparm)\
 			spritememory += W_LumpLength(lump);\
-		W_CachePatchNum(lump, PU_SPRITE);\
+		spritelumps[numspritelumps++] = lump;\
 	}
 			// see R_InitSprites for more about lumppat,lumpid
 			switch (sf->rotate)
@@ -1251,6 +1264,9 @@ void R_PrecacheLevel(void)
 	}
 	free(spritepresent);
 
+	W_CachePatchNums(spritelumps, numspritelumps, PU_SPRITE);
+	free(spritelumps);
+
 	// FIXME: this is no longer correct with OpenGL render mode
 	CONS_Debug(DBG_SETUP, "Precache level done:\n"
 			"flatmemory:    %s k\n"
@@ -141,8 +141,8 @@ angle_t R_InterpolateAngle(angle_t from, angle_t to);
 
 // Evaluate the interpolated mobj state for the given mobj
 void R_InterpolateMobjState(mobj_t *mobj, fixed_t frac, interpmobjstate_t *out);
-// Evaluate the interpolated mobj state for the given precipmobj
-void R_InterpolatePrecipMobjState(precipmobj_t *mobj, fixed_t frac, interpmobjstate_t *out);
+// Evaluate the interpolated state for drop i of the given precipitation cell
+void R_InterpolatePrecipDrop(const precipcell_t *cell, size_t i, fixed_t frac, interpmobjstate_t *out);
 
 void R_CreateInterpolator_SectorPlane(thinker_t *thinker, sector_t *sector, boolean ceiling);
 void R_CreateInterpolator_SectorScroll(thinker_t *thinker, sector_t *sector, boolean ceiling);
@@ -171,7 +171,6 @@ void R_AddMobjInterpolator(mobj_t *mobj);
 void R_RemoveMobjInterpolator(mobj_t *mobj);
 void R_UpdateMobjInterpolators(void);
 void R_ResetMobjInterpolationState(mobj_t *mobj);
-void R_ResetPrecipitationMobjInterpolationState(precipmobj_t *mobj);
 
 #ifdef __cplusplus
 } // extern "C"
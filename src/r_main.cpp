@@ -1543,6 +1543,7 @@ void R_RenderPlayerView(void)
 
 	srb2::ThreadPool::Sema tp_sema;
 	srb2::g_main_threadpool->begin_sema();
+	R_BeginWallColumns(cv_parallelsoftware.value);
 	R_RenderViewpoint(&masks[nummasks - 1], nummasks - 1);
 
 	ps_bsptime = I_GetPreciseTime() - ps_bsptime;
@@ -1617,6 +1618,13 @@ void R_RenderPlayerView(void)
 	}
 	ps_sw_portaltime = I_GetPreciseTime() - ps_sw_portaltime;
 
+	// Wall columns have to land before plane spans, so wait on them here.
+	R_FlushWallColumns();
+	tp_sema = srb2::g_main_threadpool->end_sema();
+	srb2::g_main_threadpool->notify_sema(tp_sema);
+	srb2::g_main_threadpool->wait_sema(tp_sema);
+	srb2::g_main_threadpool->begin_sema();
+
 	ps_sw_planetime = I_GetPreciseTime();
 	R_DrawPlanes();
 	tp_sema = srb2::g_main_threadpool->end_sema();
@@ -1728,4 +1736,5 @@ void R_RegisterEngineStuff(void)
 	// debugging
 
 	COM_AddDebugCommand("debugrender_highlight", Command_Debugrender_highlight);
+	COM_AddDebugCommand("debugrender_spritebench", Command_Debugrender_spritebench);
 }
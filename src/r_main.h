@@ -160,6 +160,7 @@ INT32 R_AdjustLightLevel(INT32 light);
 UINT8 R_DebugLineColor(const line_t *ld);
 
 void Command_Debugrender_highlight(void);
+void Command_Debugrender_spritebench(void);
 
 extern consvar_t
 	cv_debugrender_contrast,
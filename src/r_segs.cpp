@@ -12,7 +12,9 @@
 /// \file  r_segs.c
 /// \brief All the clipping: columns, horizontal spans, sky columns
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include <tracy/tracy/Tracy.hpp>
 
@@ -1372,6 +1374,112 @@ UINT32 nombre = 100000;
 #endif
 //profile stuff ---------------------------------------------------------
 
+// Deferred wall column drawing
+// While deferred, wall columns are recorded during BSP traversal instead of
+// being drawn immediately. R_FlushWallColumns buckets them into vertical
+// screen strips and draws each strip as one thread pool task. A column
+// command only ever writes pixels in its own screen column, and commands
+// within a strip keep their submission order, so the result is identical
+// to drawing them serially.
+
+namespace
+{
+
+struct WallColumnCommand
+{
+	coldrawfunc_t* func;
+	drawcolumndata_t dc;
+	size_t lights; // offset into g_wallcolumnlights, or SIZE_MAX
+};
+
+// Tune concurrency granularity here to maximize throughput
+constexpr const INT32 kWallColumnStripWidth = 16;
+
+boolean g_wallcolumnsdeferred = false;
+std::vector<WallColumnCommand> g_wallcolumns;
+std::vector<r_lightlist_t> g_wallcolumnlights;
+std::vector<size_t> g_wallcolumnstrips;
+std::vector<size_t> g_wallcolumnorder;
+
+}; // namespace
+
+void R_BeginWallColumns(boolean deferred)
+{
+	g_wallcolumnsdeferred = deferred;
+	g_wallcolumns.clear();
+	g_wallcolumnlights.clear();
+}
+
+void R_FlushWallColumns(void)
+{
+	ZoneScoped;
+
+	g_wallcolumnsdeferred = false;
+
+	if (g_wallcolumns.empty())
+	{
+		return;
+	}
+
+	const size_t numstrips = (viewwidth + kWallColumnStripWidth - 1) / kWallColumnStripWidth;
+	const size_t laststrip = std::max<size_t>(numstrips, 1) - 1;
+	auto strip_of = [laststrip](const WallColumnCommand& cmd)
+	{
+		return std::min<size_t>(std::max<INT32>(cmd.dc.x, 0) / kWallColumnStripWidth, laststrip);
+	};
+
+	// Counting sort by strip. This is stable, which keeps the draw
+	// order of overlapping columns the same as the serial path.
+	g_wallcolumnstrips.assign(laststrip + 2, 0);
+	for (WallColumnCommand& cmd : g_wallcolumns)
+	{
+		// The light list storage is final now, so the pointers are safe to take.
+		if (cmd.lights != SIZE_MAX)
+		{
+			cmd.dc.lightlist = &g_wallcolumnlights[cmd.lights];
+		}
+		g_wallcolumnstrips[strip_of(cmd) + 1]++;
+	}
+	for (size_t i = 1; i < g_wallcolumnstrips.size(); i++)
+	{
+		g_wallcolumnstrips[i] += g_wallcolumnstrips[i - 1];
+	}
+
+	g_wallcolumnorder.resize(g_wallcolumns.size());
+	{
+		std::vector<size_t> cursor(g_wallcolumnstrips.begin(), g_wallcolumnstrips.end() - 1);
+		for (size_t i = 0; i < g_wallcolumns.size(); i++)
+		{
+			g_wallcolumnorder[cursor[strip_of(g_wallcolumns[i])]++] = i;
+		}
+	}
+
+	WallColumnCommand* commands = g_wallcolumns.data();
+	const size_t* order = g_wallcolumnorder.data();
+
+	for (size_t strip = 0; strip <= laststrip; strip++)
+	{
+		const size_t begin = g_wallcolumnstrips[strip];
+		const size_t end = g_wallcolumnstrips[strip + 1];
+
+		if (begin == end)
+		{
+			continue;
+		}
+
+		srb2::g_main_threadpool->schedule([=]() -> void {
+			for (size_t i = begin; i < end; i++)
+			{
+				WallColumnCommand& cmd = commands[order[i]];
+				cmd.func(&cmd.dc);
+			}
+		});
+	}
+
+	// Storage is reused by the next view; it is not cleared here because
+	// the tasks above still reference it until the frame's sema is waited.
+}
+
 static void R_DrawWallColumn(drawcolumndata_t* dc, INT32 yl, INT32 yh, fixed_t mid, fixed_t texturecolumn, INT32 texture, boolean brightmapped, boolean remap)
 {
 	dc->yl = yl;
@@ -1389,6 +1497,22 @@ static void R_DrawWallColumn(drawcolumndata_t* dc, INT32 yl, INT32 yh, fixed_t m
 		dc_copy.colormap += COLORMAP_REMAPOFFSET;
 		dc_copy.fullbright += COLORMAP_REMAPOFFSET;
 	}
+
+	if (g_wallcolumnsdeferred)
+	{
+		size_t lights = SIZE_MAX;
+
+		// The light list is stepped per column, so snapshot it.
+		if (dc_copy.numlights)
+		{
+			lights = g_wallcolumnlights.size();
+			g_wallcolumnlights.insert(g_wallcolumnlights.end(), dc_copy.lightlist, dc_copy.lightlist + dc_copy.numlights);
+		}
+
+		g_wallcolumns.push_back({colfunccopy, dc_copy, lights});
+		return;
+	}
+
 	colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
 }
 
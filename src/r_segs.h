@@ -24,6 +24,10 @@ void R_RenderMaskedSegRange(drawseg_t *ds, INT32 x1, INT32 x2);
 void R_RenderThickSideRange(drawseg_t *ds, INT32 x1, INT32 x2, ffloor_t *pffloor);
 void R_StoreWallRange(INT32 start, INT32 stop);
 
+// Wall columns drawn between these are queued and then drawn on the thread pool
+void R_BeginWallColumns(boolean deferred);
+void R_FlushWallColumns(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
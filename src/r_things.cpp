@@ -13,6 +13,10 @@
 /// \brief Refresh of things, i.e. objects represented by sprites
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
 
 #include "doomdef.h"
 #include "console.h"
@@ -37,6 +41,7 @@
 #include "p_tick.h"
 #include "p_local.h"
 #include "p_slopes.h"
+#include "p_precip.h"
 #include "d_netfil.h" // blargh. for nameonly().
 #include "m_cheat.h" // objectplace
 #include "p_local.h" // stplyr
@@ -838,9 +843,7 @@ UINT8 *R_GetSpriteTranslation(vissprite_t *vis)
 {
 	if (vis->cut & SC_PRECIP)
 	{
-		// Simplified func, less safe properties to check
-		if (vis->mobj->color)
-			R_GetTranslationColormap(TC_DEFAULT, static_cast<skincolornum_t>(vis->mobj->color), GTC_CACHE);
+		// Precipitation has no mobj, and so no color
 		return NULL;
 	}
 
@@ -2595,7 +2598,7 @@ static void R_ProjectSprite(mobj_t *thing)
 	++objectsdrawn;
 }
 
-static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
+static void R_ProjectPrecipitationSprite(const precipcell_t *cell, size_t i)
 {
 	fixed_t tr_x, tr_y;
 	fixed_t tx, tz;
@@ -2618,23 +2621,21 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	UINT32 blendmode;
 	UINT32 trans;
 
+	const spritenum_t sprite = states[cell->state[i]].sprite;
+	const UINT32 frame = cell->frame[i];
+	sector_t *const sector = cell->sector[i];
+
 	// uncapped/interpolation
 	interpmobjstate_t interp = {0};
 
-	// okay... this is a hack, but weather isn't networked, so it should be ok
-	if (!P_PrecipThinker(thing))
-	{
-		return;
-	}
-
 	// do interpolation
 	if (R_UsingFrameInterpolation() && !paused)
 	{
-		R_InterpolatePrecipMobjState(thing, rendertimefrac, &interp);
+		R_InterpolatePrecipDrop(cell, i, rendertimefrac, &interp);
 	}
 	else
 	{
-		R_InterpolatePrecipMobjState(thing, FRACUNIT, &interp);
+		R_InterpolatePrecipDrop(cell, i, FRACUNIT, &interp);
 	}
 
 	this_scale = interp.scale;
@@ -2660,27 +2661,27 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	yscale = FixedDiv(projectiony[viewssnum], tz);
 
 	// decide which patch to use for sprite relative to player
-	if ((unsigned)thing->sprite >= numsprites)
+	if ((unsigned)sprite >= numsprites)
 	{
 		CONS_Debug(DBG_RENDER, "R_ProjectPrecipitationSprite: invalid sprite number %d\n",
-			thing->sprite);
+			sprite);
 		return;
 	}
 
-	sprdef = &sprites[thing->sprite];
+	sprdef = &sprites[sprite];
 
-	if ((UINT8)(thing->frame&FF_FRAMEMASK) >= sprdef->numframes)
+	if ((UINT8)(frame&FF_FRAMEMASK) >= sprdef->numframes)
 	{
 		CONS_Debug(DBG_RENDER, "R_ProjectPrecipitationSprite: invalid sprite frame %d : %d for %s\n",
-			thing->sprite, thing->frame, sprnames[thing->sprite]);
+			sprite, frame, sprnames[sprite]);
 		return;
 	}
 
-	sprframe = &sprdef->spriteframes[thing->frame & FF_FRAMEMASK];
+	sprframe = &sprdef->spriteframes[frame & FF_FRAMEMASK];
 
 #ifdef PARANOIA
 	if (!sprframe)
-		I_Error("R_ProjectPrecipitationSprite: sprframes NULL for sprite %d\n", thing->sprite);
+		I_Error("R_ProjectPrecipitationSprite: sprframes NULL for sprite %d\n", sprite);
 #endif
 
 	// use single rotation for all views
@@ -2715,19 +2716,19 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	gzt = interp.z + FixedMul(spritecachedinfo[lump].topoffset, this_scale);
 	gz = gzt - FixedMul(spritecachedinfo[lump].height, this_scale);
 
-	if (thing->subsector->sector->cullheight)
+	if (sector->cullheight)
 	{
-		if (R_DoCulling(thing->subsector->sector->cullheight, viewsector->cullheight, viewz, gz, gzt))
+		if (R_DoCulling(sector->cullheight, viewsector->cullheight, viewz, gz, gzt))
 			return;
 	}
 
 	// Determine the blendmode and translucency value
 	{
-		blendmode = (thing->frame & FF_BLENDMASK) >> FF_BLENDSHIFT;
+		blendmode = (frame & FF_BLENDMASK) >> FF_BLENDSHIFT;
 		if (blendmode)
 			blendmode++; // realign to constants
 
-		trans = (thing->frame & FF_TRANSMASK) >> FF_TRANSSHIFT;
+		trans = (frame & FF_TRANSMASK) >> FF_TRANSSHIFT;
 		if (trans >= NUMTRANSMAPS)
 			return; // cap
 	}
@@ -2759,7 +2760,7 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	vis->x2test = 0;
 
 	vis->xscale = xscale; //SoM: 4/17/2000
-	vis->sector = thing->subsector->sector;
+	vis->sector = sector;
 	vis->szt = (INT16)((centeryfrac - FixedMul(vis->gzt - viewz, yscale))>>FRACBITS);
 	vis->sz = (INT16)((centeryfrac - FixedMul(vis->gz - viewz, yscale))>>FRACBITS);
 
@@ -2774,16 +2775,16 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	//Fab: lumppat is the lump number of the patch to use, this is different
 	//	 than lumpid for sprites-in-pwad : the graphics are patched
 	vis->patch = static_cast<patch_t*>(W_CachePatchNum(sprframe->lumppat[0], PU_SPRITE));
-	vis->bright = R_CacheSpriteBrightMap(&spriteinfo[thing->sprite],
-			thing->frame & FF_FRAMEMASK);
+	vis->bright = R_CacheSpriteBrightMap(&spriteinfo[sprite],
+			frame & FF_FRAMEMASK);
 
 	vis->transmap = R_GetBlendTable(blendmode, trans);
 
-	vis->mobj = (mobj_t *)thing;
+	vis->mobj = NULL;
 	vis->mobjflags = 0;
 	vis->cut = SC_PRECIP;
-	vis->extra_colormap = thing->subsector->sector->extra_colormap;
-	vis->heightsec = thing->subsector->sector->heightsec;
+	vis->extra_colormap = sector->extra_colormap;
+	vis->heightsec = sector->heightsec;
 
 	// Fullbright
 	vis->colormap = colormaps;
@@ -2869,7 +2870,7 @@ void R_AddPrecipitationSprites(void)
 	const fixed_t drawdist = cv_drawdist_precip.value * mapobjectscale;
 
 	INT32 xl, xh, yl, yh, bx, by;
-	precipmobj_t *th, *next;
+	size_t i;
 
 	// no, no infinite draw distance for precipitation. this option at zero is supposed to turn it off
 	if (drawdist == 0)
@@ -2885,42 +2886,51 @@ void R_AddPrecipitationSprites(void)
 
 	R_GetRenderBlockMapDimensions(drawdist, &xl, &xh, &yl, &yh);
 
+	// okay... this is a hack, but weather isn't networked, so it should be ok
+	P_ThinkPrecipitationBlocks(xl, xh, yl, yh);
+
 	for (bx = xl; bx <= xh; bx++)
 	{
 		for (by = yl; by <= yh; by++)
 		{
-			for (th = precipblocklinks[(by * bmapwidth) + bx]; th; th = next)
+			const precipcell_t *cell = &precipcells[(by * bmapwidth) + bx];
+
+			for (i = 0; i < cell->count; i++)
 			{
-				// Store this beforehand because R_ProjectPrecipitionSprite may free th (see P_PrecipThinker)
-				next = th->bnext;
+				if (cell->flags[i] & PCF_INVISIBLE)
+					continue;
 
-				if (R_PrecipThingVisible(th))
-				{
-					R_ProjectPrecipitationSprite(th);
-				}
+				R_ProjectPrecipitationSprite(cell, i);
 			}
 		}
 	}
 }
 
+// orders R_SortVisSprites' (mobj, sprite) tracer pairs by mobj only
+static bool TracerBefore(const std::pair<mobj_t*, vissprite_t*>& a, const std::pair<mobj_t*, vissprite_t*>& b)
+{
+	return std::less<mobj_t*>()(a.first, b.first);
+}
+
 //
 // R_SortVisSprites
 //
 static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 end)
 {
-	UINT32	   i, count = 0;
-	vissprite_t *ds, *dsprev, *dsnext, *dsfirst;
-	vissprite_t *best = NULL;
-	vissprite_t  unsorted;
-	fixed_t	  bestscale;
-	INT32		bestdispoffset;
+	// Kept between frames so the arrays only grow while sorting.
+	static std::vector<vissprite_t*> sorted;
+	static std::vector<vissprite_t*> links;
+	static std::vector<std::pair<mobj_t*, vissprite_t*>> tracers;
 
-	dsfirst = &unsorted;
-	dsprev = dsfirst;
-	dsnext = dsfirst;
+	UINT32	   i;
+	vissprite_t *ds, *dsnext, *dsfirst;
 
 	I_Assert(start <= end);
 
+	sorted.clear();
+	links.clear();
+	tracers.clear();
+
 	for (i = start; i < end; ++i)
 	{
 		ds = R_GetVisSprite(i);
@@ -2931,70 +2941,69 @@ static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 e
 			continue;
 		}
 
-		dsnext = ds;
-		dsnext->linkdraw = NULL;
-
-		dsprev->next = dsnext;
-		dsnext->prev = dsprev;
-		dsprev = dsnext;
+		ds->linkdraw = NULL;
 
-		count++;
+		// linkdraw shadows aren't bundled, they sort like anything else
+		if ((ds->cut & (SC_LINKDRAW|SC_SHADOW)) == SC_LINKDRAW)
+			links.push_back(ds);
+		else
+			sorted.push_back(ds);
 	}
 
-	dsnext->next = dsfirst;
-	dsfirst->prev = dsnext;
-
-	// bundle linkdraw
-	for (ds = unsorted.prev; ds != &unsorted; ds = ds->prev)
+	// index the sprites links can connect to by their mobj, in projection order
+	if (!links.empty())
 	{
-		if (!(ds->cut & SC_LINKDRAW))
-			continue;
-
-		if (ds->cut & SC_SHADOW)
-			continue;
-
-		// reuse dsfirst...
-		for (dsfirst = unsorted.prev; dsfirst != &unsorted; dsfirst = dsfirst->prev)
+		for (vissprite_t* tracer : sorted)
 		{
 			// don't connect if it's also a link
-			if (dsfirst->cut & SC_LINKDRAW)
+			if (tracer->cut & SC_LINKDRAW)
 				continue;
 
-			// don't connect to your shadow!
-			if (dsfirst->cut & SC_SHADOW)
+			// don't connect to your shadow or your bounding box!
+			if (tracer->cut & (SC_SHADOW|SC_BBOX))
 				continue;
 
-			// don't connect to your bounding box!
-			if (dsfirst->cut & SC_BBOX)
+			if (tracer->mobj == NULL)
 				continue;
 
-			// don't connect if it's not the tracer
-			if (dsfirst->mobj != ds->mobj)
-				continue;
+			tracers.emplace_back(tracer->mobj, tracer);
+		}
+
+		// stable, so each mobj's sprites stay in projection order
+		std::stable_sort(tracers.begin(), tracers.end(), TracerBefore);
+	}
+
+	// bundle linkdraw, last sprite first
+	for (auto it = links.rbegin(); it != links.rend(); ++it)
+	{
+		ds = *it;
+		dsfirst = NULL;
+
+		auto found = std::equal_range(tracers.begin(), tracers.end(), std::make_pair(ds->mobj, (vissprite_t*)NULL), TracerBefore);
+
+		// the latest tracer sprite wins
+		for (auto cand = std::make_reverse_iterator(found.second); cand != std::make_reverse_iterator(found.first); ++cand)
+		{
+			vissprite_t *tracer = cand->second;
 
 			// don't connect if the tracer's top is cut off, but lower than the link's top
-			if ((dsfirst->cut & SC_TOP)
-			&& dsfirst->szt > ds->szt)
+			if ((tracer->cut & SC_TOP)
+			&& tracer->szt > ds->szt)
 				continue;
 
 			// don't connect if the tracer's bottom is cut off, but higher than the link's bottom
-			if ((dsfirst->cut & SC_BOTTOM)
-			&& dsfirst->sz < ds->sz)
+			if ((tracer->cut & SC_BOTTOM)
+			&& tracer->sz < ds->sz)
 				continue;
 
+			dsfirst = tracer;
 			break;
 		}
 
-		// remove from chain
-		ds->next->prev = ds->prev;
-		ds->prev->next = ds->next;
-		count--;
-
-		if (dsfirst != &unsorted)
+		if (dsfirst != NULL)
 		{
 			ds->extra_colormap = dsfirst->extra_colormap;
 
-			// reusing dsnext...
 			dsnext = dsfirst->linkdraw;
 
 			if (!dsnext || ds->dispoffset < dsnext->dispoffset)
@@ -3013,33 +3022,19 @@ static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 e
 		}
 	}
 
-	// pull the vissprites out by scale
-	vsprsortedhead->next = vsprsortedhead->prev = vsprsortedhead;
-	for (i = 0; i < count; i++)
+	// Order by scale, then dispoffset, smallest first. Stable, so
+	// sprites that tie on both keep the order they were projected in.
+	std::stable_sort(sorted.begin(), sorted.end(), [](const vissprite_t* a, const vissprite_t* b)
 	{
-		bestscale = bestdispoffset = INT32_MAX;
-		for (ds = unsorted.next; ds != &unsorted; ds = ds->next)
-		{
-#ifdef PARANOIA
-			if (ds->cut & SC_LINKDRAW)
-				I_Error("R_SortVisSprites: no link or discardal made for linkdraw!");
-#endif
+		if (a->sortscale != b->sortscale)
+			return a->sortscale < b->sortscale;
+		return a->dispoffset < b->dispoffset;
+	});
 
-			if (ds->sortscale < bestscale)
-			{
-				bestscale = ds->sortscale;
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-			// order visprites of same scale by dispoffset, smallest first
-			else if (ds->sortscale == bestscale && ds->dispoffset < bestdispoffset)
-			{
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-		}
-		best->next->prev = best->prev;
-		best->prev->next = best->next;
+	vsprsortedhead->next = vsprsortedhead->prev = vsprsortedhead;
+
+	for (vissprite_t* best : sorted)
+	{
 		best->next = vsprsortedhead;
 		best->prev = vsprsortedhead->prev;
 		vsprsortedhead->prev->next = best;
@@ -3047,6 +3042,76 @@ static void R_SortVisSprites(vissprite_t* vsprsortedhead, UINT32 start, UINT32 e
 	}
 }
 
+//
+// Command_Debugrender_spritebench
+// Times R_SortVisSprites on a synthetic scene of up to MAXVISSPRITES sprites.
+// Every mobj gets a body, a shadow and a linkdraw overlay, and scales are drawn
+// from a small set so there are plenty of ties for the stable sort to keep.
+//
+void Command_Debugrender_spritebench(void)
+{
+	static vissprite_t head;
+	UINT32 count = MAXVISSPRITES;
+	INT32 runs = 100;
+	UINT32 seed = 0x2545F491;
+	UINT32 i;
+	INT32 r;
+	precise_t start, total;
+
+	if (!CV_CheatsEnabled())
+	{
+		CONS_Printf("Cheats must be enabled.\n");
+		return;
+	}
+
+	if (COM_Argc() > 1)
+		count = std::clamp(atoi(COM_Argv(1)), 3, MAXVISSPRITES);
+	if (COM_Argc() > 2)
+		runs = std::max(atoi(COM_Argv(2)), 1);
+
+	// only the addresses are used, as linkdraw keys
+	std::vector<mobj_t> mobjs(count / 3 + 1);
+
+	R_ClearSprites();
+
+	for (i = 0; i < count; i++)
+	{
+		vissprite_t *ds = R_NewVisSprite();
+
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		memset(ds, 0, sizeof *ds);
+		ds->mobj = &mobjs[i / 3];
+		ds->sortscale = (fixed_t)(seed % 256 + 1) << 8;
+		ds->dispoffset = (INT32)(seed >> 8) % 4 - 2;
+		ds->sz = (INT16)(seed >> 12) % 200;
+		ds->szt = ds->sz - 48;
+
+		switch (i % 3)
+		{
+			case 1:
+				ds->cut = SC_SHADOW;
+				break;
+			case 2:
+				ds->cut = SC_LINKDRAW;
+				break;
+		}
+	}
+
+	start = I_GetPreciseTime();
+	for (r = 0; r < runs; r++)
+		R_SortVisSprites(&head, 0, visspritecount);
+	total = I_GetPreciseTime() - start;
+
+	CONS_Printf("%u sprites, %d runs: %.1f us per sort\n", visspritecount, runs,
+		(double)total * 1000000.0 / I_GetPrecisePrecision() / runs);
+
+	// drop the synthetic sprites; their mobjs are about to go away
+	R_ClearSprites();
+}
+
 //
 // R_CreateDrawNodes
 // Creates and sorts a list of drawnodes for the scene being rendered.
@@ -3319,7 +3384,8 @@ static void R_CreateDrawNodes(maskcount_t* mask, drawnode_t* head, boolean temps
 					{
 						fixed_t z1 = 0, z2 = 0;
 
-						if (rover->mobj->z - viewz > 0)
+						// pz rather than mobj->z: precipitation sprites have no mobj
+						if (rover->pz - viewz > 0)
 						{
 							z1 = rover->pz;
 							z2 = r2->sprite->pz;
@@ -3844,15 +3910,6 @@ boolean R_ThingWithinDist (mobj_t *thing, fixed_t limit_dist)
 	return true;
 }
 
-/* Check if precipitation may be drawn from our current view. */
-boolean R_PrecipThingVisible (precipmobj_t *precipthing)
-{
-	if (( precipthing->precipflags & PCF_INVISIBLE ))
-		return false;
-
-	return true;
-}
-
 boolean R_ThingHorizontallyFlipped(mobj_t *thing)
 {
 	return (thing->frame & FF_HORIZONTALFLIP || thing->renderflags & RF_HORIZONTALFLIP);
@@ -1221,6 +1221,63 @@ void S_InitSfxChannels(void)
 	}
 }
 
+//
+// S_PrecacheLevelSounds
+//
+// Loads the sounds the level's objects and racers make before the level starts,
+// so the first time each one plays doesn't stall on decoding it.
+//
+void S_PrecacheLevelSounds(void)
+{
+	UINT8 *soundpresent;
+	sfxinfo_t **list;
+	size_t count = 0;
+	thinker_t *th;
+	INT32 i, j;
+
+	if (dedicated || sound_disabled)
+		return;
+
+	soundpresent = calloc(NUMSFX, sizeof (*soundpresent));
+	list = malloc(NUMSFX * sizeof (*list));
+	if (soundpresent == NULL || list == NULL) I_Error("%s: Out of memory looking up sounds", "S_PrecacheLevelSounds");
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		const mobjinfo_t *info;
+
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+
+		info = ((mobj_t *)th)->info;
+		soundpresent[info->seesound] = 1;
+		soundpresent[info->attacksound] = 1;
+		soundpresent[info->painsound] = 1;
+		soundpresent[info->deathsound] = 1;
+		soundpresent[info->activesound] = 1;
+	}
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		if (!playeringame[i] || players[i].skin < 0 || players[i].skin >= numskins)
+			continue;
+
+		for (j = 0; j < NUMSKINSOUNDS; j++)
+			soundpresent[skins[players[i].skin].soundsid[j]] = 1;
+	}
+
+	for (i = 1; i < NUMSFX; i++)
+	{
+		if (soundpresent[i] && S_sfx[i].name && !S_sfx[i].data)
+			list[count++] = &S_sfx[i];
+	}
+
+	I_PrecacheSfx(list, count);
+
+	free(list);
+	free(soundpresent);
+}
+
 /// ------------------------
 /// Music
 /// ------------------------
@@ -109,6 +109,7 @@ void S_InitSfxChannels(void);
 //
 void S_StopSounds(void);
 void S_ClearSfx(void);
+void S_PrecacheLevelSounds(void);
 void S_InitLevelMusic(boolean reset);
 
 //
@@ -9,19 +9,25 @@
 //-----------------------------------------------------------------------------
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <memory>
+#include <optional>
 
 #include <SDL.h>
 #include <tracy/tracy/Tracy.hpp>
 
 #include "../audio/chunk_load.hpp"
 #include "../audio/gain.hpp"
+#include "../audio/mix_kernels.hpp"
 #include "../audio/mixer.hpp"
 #include "../audio/music_player.hpp"
 #include "../audio/resample.hpp"
 #include "../audio/sound_chunk.hpp"
 #include "../audio/sound_effect_player.hpp"
+#include "../core/spsc_queue.hpp"
+#include "../core/thread_pool.h"
 #include "../cxxutil.hpp"
 #include "../io/streams.hpp"
 
@@ -74,6 +80,214 @@ static shared_ptr<srb2::media::AVRecorder> av_recorder;
 
 static void (*music_fade_callback)();
 
+namespace
+{
+
+// Requests from the game thread. They are queued and carried out at the top of the
+// audio callback, so the game thread never waits on the mixer and the channels,
+// gains and music player are only touched from the audio thread (or with the
+// audio lock held, see SdlAudioLockHandle).
+struct AudioCommand
+{
+	enum class Type : uint8_t
+	{
+		kStartSound,
+		kStopSound,
+		kUpdateSound,
+		kSfxVolume,
+		kMasterVolume,
+		kMusicVolume,
+		kSongVolume,
+		kSongSpeed,
+		kInternalMusicVolume,
+		kPlaySong,
+		kStopSong,
+		kPauseSong,
+		kResumeSong,
+		kSeekSong,
+		kFadeSong,
+		kStopFadingSong,
+	};
+
+	Type type;
+	bool flag; // kPlaySong: looping; kFadeSong: fade from a (rather than the current volume)
+	uint32_t channel;
+	uint32_t generation; // sounds: which start of the channel this is for; kFadeSong: fade number
+	const SoundChunk* chunk;
+	float a; // volume, gain, speed or seconds
+	float b; // separation or fade target
+	float c; // fade seconds
+};
+
+SpScQueue<AudioCommand, 1024> audio_commands;
+
+// Each time the game thread starts a sound on a channel, it bumps that channel's
+// generation. The audio thread reports the generation of the last sound that
+// finished there, so a channel is free when the two match.
+vector<uint32_t> channel_generation; // game thread
+vector<uint32_t> channel_stopped; // game thread: generation last stopped by I_StopSound
+unique_ptr<std::atomic<uint32_t>[]> channel_finished; // written by the audio thread
+vector<uint32_t> channel_playing; // audio thread: generation given to each channel
+vector<uint32_t> channel_reported; // audio thread: last value stored to channel_finished
+
+// Same idea for music fades, so I_UpdateSound can tell when to run the fade callback.
+uint32_t music_fade_generation = 0; // game thread
+std::atomic<uint32_t> music_fade_finished {0}; // written by the audio thread
+uint32_t music_fade_current = 0; // audio thread: fade the music player is running
+
+bool channel_free(size_t index)
+{
+	const uint32_t generation = channel_generation[index];
+	return channel_stopped[index] == generation || channel_finished[index].load(std::memory_order_acquire) == generation;
+}
+
+bool music_fade_done()
+{
+	return music_fade_finished.load(std::memory_order_acquire) == music_fade_generation;
+}
+
+float cubed_gain(float volume)
+{
+	float vol = volume / 100.f;
+	return std::clamp(vol * vol * vol, 0.f, 1.f);
+}
+
+void run_command(const AudioCommand& cmd)
+{
+	switch (cmd.type)
+	{
+	case AudioCommand::Type::kStartSound:
+		if (cmd.channel < sound_effect_channels.size())
+		{
+			sound_effect_channels[cmd.channel]->start(cmd.chunk, cmd.a, cmd.b);
+			channel_playing[cmd.channel] = cmd.generation;
+		}
+		break;
+	case AudioCommand::Type::kStopSound:
+		if (cmd.channel < sound_effect_channels.size() && channel_playing[cmd.channel] == cmd.generation)
+		{
+			sound_effect_channels[cmd.channel]->reset();
+		}
+		break;
+	case AudioCommand::Type::kUpdateSound:
+		if (cmd.channel < sound_effect_channels.size() && channel_playing[cmd.channel] == cmd.generation
+			&& !sound_effect_channels[cmd.channel]->finished())
+		{
+			sound_effect_channels[cmd.channel]->update(cmd.a, cmd.b);
+		}
+		break;
+	case AudioCommand::Type::kSfxVolume:
+		if (gain_sound_effects)
+			gain_sound_effects->gain(cmd.a);
+		break;
+	case AudioCommand::Type::kMasterVolume:
+		if (master_gain)
+			master_gain->gain(cmd.a);
+		break;
+	case AudioCommand::Type::kMusicVolume:
+		if (gain_music_channel)
+			gain_music_channel->gain(cmd.a);
+		break;
+	case AudioCommand::Type::kSongVolume:
+		if (gain_music_player)
+			gain_music_player->gain(cmd.a);
+		break;
+	case AudioCommand::Type::kSongSpeed:
+		if (resample_music_player)
+			resample_music_player->ratio(cmd.a);
+		break;
+	case AudioCommand::Type::kInternalMusicVolume:
+		if (music_player)
+			music_player->internal_gain(cmd.a);
+		break;
+	case AudioCommand::Type::kPlaySong:
+		if (music_player)
+			music_player->play(cmd.flag);
+		break;
+	case AudioCommand::Type::kStopSong:
+		if (music_player)
+			music_player->stop();
+		break;
+	case AudioCommand::Type::kPauseSong:
+		if (music_player)
+			music_player->pause();
+		break;
+	case AudioCommand::Type::kResumeSong:
+		if (music_player)
+			music_player->unpause();
+		break;
+	case AudioCommand::Type::kSeekSong:
+		if (music_player)
+			music_player->seek(cmd.a);
+		break;
+	case AudioCommand::Type::kFadeSong:
+		if (music_player)
+		{
+			if (cmd.flag)
+				music_player->fade_from_to(cmd.a, cmd.b, cmd.c);
+			else
+				music_player->fade_to(cmd.b, cmd.c);
+		}
+		music_fade_current = cmd.generation;
+		break;
+	case AudioCommand::Type::kStopFadingSong:
+		if (music_player)
+			music_player->stop_fade();
+		break;
+	}
+}
+
+// Tell the game thread which channels and fades have finished.
+void publish_state()
+{
+	for (size_t i = 0; i < sound_effect_channels.size(); i++)
+	{
+		if (channel_reported[i] != channel_playing[i] && sound_effect_channels[i]->finished())
+		{
+			channel_reported[i] = channel_playing[i];
+			channel_finished[i].store(channel_playing[i], std::memory_order_release);
+		}
+	}
+
+	if (!music_player || !music_player->fading())
+	{
+		music_fade_finished.store(music_fade_current, std::memory_order_release);
+	}
+}
+
+// Only the audio thread, or a thread holding the audio lock, may call this.
+void drain_commands()
+{
+	while (std::optional<AudioCommand> cmd = audio_commands.pop())
+	{
+		run_command(*cmd);
+	}
+
+	publish_state();
+}
+
+class SdlAudioLockHandle
+{
+public:
+	// Apply everything queued first, so whoever holds the lock sees the state the game asked for.
+	SdlAudioLockHandle() { SDL_LockAudio(); drain_commands(); }
+	~SdlAudioLockHandle() { SDL_UnlockAudio(); }
+};
+
+void push_command(const AudioCommand& cmd)
+{
+	if (audio_commands.push(cmd))
+		return;
+
+	// The audio thread has fallen far behind (or there is no audio device running the
+	// callback); catch up on its behalf.
+	SdlAudioLockHandle _;
+	run_command(cmd);
+	publish_state();
+}
+
+} // namespace
+
 void* I_GetSfx(sfxinfo_t* sfx)
 {
 	if (sfx->lumpnum == LUMPERROR)
@@ -94,6 +308,57 @@ void* I_GetSfx(sfxinfo_t* sfx)
 	return heap_chunk;
 }
 
+void I_PrecacheSfx(sfxinfo_t** sfx, size_t count)
+{
+	ZoneScoped;
+
+	// Lumps are read into plain buffers, since only the main thread may touch the zone heap,
+	// then decoded and resampled in parallel. Sounds vary a lot in length, so each gets its own task.
+	vector<vector<std::byte>> lumps(count);
+	vector<lumpread_t> reads(count);
+	vector<std::optional<SoundChunk>> chunks(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (sfx[i]->lumpnum == LUMPERROR)
+			sfx[i]->lumpnum = S_GetSfxLumpNum(sfx[i]);
+		sfx[i]->length = W_LumpLength(sfx[i]->lumpnum);
+
+		lumps[i].resize(sfx[i]->length);
+		reads[i] = {WADFILENUM(sfx[i]->lumpnum), LUMPNUM(sfx[i]->lumpnum), lumps[i].data(), 0, 0, 0};
+	}
+
+	W_ReadLumpsParallel(reads.data(), count);
+
+	auto decode = [&lumps, &reads, &chunks](size_t i)
+	{
+		chunks[i] = srb2::audio::try_load_chunk(tcb::span<std::byte>(lumps[i].data(), reads[i].result));
+	};
+
+	if (g_main_threadpool == nullptr || count <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+			decode(i);
+	}
+	else
+	{
+		g_main_threadpool->begin_sema();
+		for (size_t i = 0; i < count; i++)
+		{
+			g_main_threadpool->schedule([&decode, i]() -> void { decode(i); });
+		}
+		ThreadPool::Sema sema = g_main_threadpool->end_sema();
+		g_main_threadpool->notify_sema(sema);
+		g_main_threadpool->wait_sema(sema);
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (chunks[i])
+			sfx[i]->data = new SoundChunk {std::move(*chunks[i])};
+	}
+}
+
 void I_FreeSfx(sfxinfo_t* sfx)
 {
 	if (sfx->data)
@@ -102,6 +367,7 @@ void I_FreeSfx(sfxinfo_t* sfx)
 		auto _ = srb2::finally([chunk]() { delete chunk; });
 
 		// Stop any channels playing this chunk
+		SdlAudioLockHandle lock;
 		for (auto& player : sound_effect_channels)
 		{
 			if (player->is_playing_chunk(chunk))
@@ -109,6 +375,7 @@ void I_FreeSfx(sfxinfo_t* sfx)
 				player->reset();
 			}
 		}
+		publish_state();
 	}
 	sfx->data = nullptr;
 	sfx->lumpnum = LUMPERROR;
@@ -117,13 +384,6 @@ void I_FreeSfx(sfxinfo_t* sfx)
 namespace
 {
 
-class SdlAudioLockHandle
-{
-public:
-	SdlAudioLockHandle() { SDL_LockAudio(); }
-	~SdlAudioLockHandle() { SDL_UnlockAudio(); }
-};
-
 #ifdef TRACY_ENABLE
 static const char* kAudio = "Audio";
 #endif
@@ -149,15 +409,13 @@ void audio_callback(void* userdata, Uint8* buffer, int len)
 		if (!master_gain)
 			return;
 
+		drain_commands();
+
 		master_gain->generate(tcb::span {float_buffer, float_len});
 
-		for (size_t i = 0; i < float_len; i++)
-		{
-			float_buffer[i] = {
-				std::clamp(float_buffer[i].amplitudes[0], -1.f, 1.f),
-				std::clamp(float_buffer[i].amplitudes[1], -1.f, 1.f),
-			};
-		}
+		publish_state();
+
+		audio::mix_clamp(audio::sample_floats(float_buffer), float_len * 2);
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 		if (av_recorder)
 			av_recorder->push_audio_samples(tcb::span {float_buffer, float_len});
@@ -222,6 +480,13 @@ void initialize_sound()
 			sound_effect_channels.push_back(player);
 			mixer_sound_effects->add_source(player);
 		}
+
+		const size_t channels = sound_effect_channels.size();
+		channel_generation.assign(channels, 0);
+		channel_stopped.assign(channels, 0);
+		channel_finished = make_unique<std::atomic<uint32_t>[]>(channels);
+		channel_playing.assign(channels, 0);
+		channel_reported.assign(channels, 0);
 	}
 
 	sound_started = true;
@@ -245,11 +510,7 @@ void I_ShutdownSound(void)
 
 void I_UpdateSound(void)
 {
-	// The SDL audio lock is re-entrant, so it is safe to lock twice
-	// for the "fade to stop music" callback later.
-	SdlAudioLockHandle _;
-
-	if (music_fade_callback && !music_player->fading())
+	if (music_fade_callback && music_fade_done())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
@@ -267,128 +528,115 @@ INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priori
 	(void) pitch;
 	(void) priority;
 
-	SdlAudioLockHandle _;
-
-	if (channel >= 0 && static_cast<size_t>(channel) >= sound_effect_channels.size())
+	if (channel >= 0 && static_cast<size_t>(channel) >= channel_generation.size())
 		return -1;
 
-	shared_ptr<SoundEffectPlayer> player_channel;
 	if (channel < 0)
 	{
 		// find a free sfx channel
-		for (size_t i = 0; i < sound_effect_channels.size(); i++)
+		for (size_t i = 0; i < channel_generation.size(); i++)
 		{
-			if (sound_effect_channels[i]->finished())
+			if (channel_free(i))
 			{
-				player_channel = sound_effect_channels[i];
 				channel = i;
 				break;
 			}
 		}
 	}
-	else
-	{
-		player_channel = sound_effect_channels[channel];
-	}
 
-	if (!player_channel)
+	if (channel < 0)
 		return -1;
 
 	SoundChunk* chunk = static_cast<SoundChunk*>(S_sfx[id].data);
 	if (chunk == nullptr)
 		return -1;
 
-	float vol_float = static_cast<float>(vol) / 255.f;
-	float sep_float = static_cast<float>(sep) / 127.f - 1.f;
-
-	player_channel->start(chunk, vol_float, sep_float);
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kStartSound;
+	cmd.channel = channel;
+	cmd.generation = ++channel_generation[channel];
+	cmd.chunk = chunk;
+	cmd.a = static_cast<float>(vol) / 255.f;
+	cmd.b = static_cast<float>(sep) / 127.f - 1.f;
+	push_command(cmd);
 
 	return channel;
 }
 
 void I_StopSound(INT32 handle)
 {
-	SdlAudioLockHandle _;
-
-	if (sound_effect_channels.empty())
-		return;
-
 	if (handle < 0)
 		return;
 
 	size_t index = handle;
 
-	if (index >= sound_effect_channels.size())
+	if (index >= channel_generation.size())
 		return;
 
-	sound_effect_channels[index]->reset();
+	if (channel_free(index))
+		return;
+
+	channel_stopped[index] = channel_generation[index];
+
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kStopSound;
+	cmd.channel = index;
+	cmd.generation = channel_generation[index];
+	push_command(cmd);
 }
 
 boolean I_SoundIsPlaying(INT32 handle)
 {
-	SdlAudioLockHandle _;
-
 	// Handle is channel index
-	if (sound_effect_channels.empty())
-		return 0;
-
 	if (handle < 0)
 		return 0;
 
 	size_t index = handle;
 
-	if (index >= sound_effect_channels.size())
+	if (index >= channel_generation.size())
 		return 0;
 
-	return sound_effect_channels[index]->finished() ? 0 : 1;
+	return channel_free(index) ? 0 : 1;
 }
 
 void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 {
 	(void) pitch;
 
-	SdlAudioLockHandle _;
-
-	if (sound_effect_channels.empty())
-		return;
-
 	if (handle < 0)
 		return;
 
 	size_t index = handle;
 
-	if (index >= sound_effect_channels.size())
+	if (index >= channel_generation.size())
 		return;
 
-	shared_ptr<SoundEffectPlayer>& channel = sound_effect_channels[index];
-	if (!channel->finished())
+	if (!channel_free(index))
 	{
-		float vol_float = static_cast<float>(vol) / 255.f;
-		float sep_float = static_cast<float>(sep) / 127.f - 1.f;
-		channel->update(vol_float, sep_float);
+		AudioCommand cmd {};
+		cmd.type = AudioCommand::Type::kUpdateSound;
+		cmd.channel = index;
+		cmd.generation = channel_generation[index];
+		cmd.a = static_cast<float>(vol) / 255.f;
+		cmd.b = static_cast<float>(sep) / 127.f - 1.f;
+		push_command(cmd);
 	}
 }
 
 void I_SetSfxVolume(int volume)
 {
-	SdlAudioLockHandle _;
-	float vol = static_cast<float>(volume) / 100.f;
-
-	if (gain_sound_effects)
-	{
-		gain_sound_effects->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
-	}
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kSfxVolume;
+	cmd.a = cubed_gain(volume);
+	push_command(cmd);
 }
 
 void I_SetMasterVolume(int volume)
 {
-	SdlAudioLockHandle _;
-	float vol = static_cast<float>(volume) / 100.f;
-
-	if (master_gain)
-	{
-		master_gain->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
-	}
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kMasterVolume;
+	cmd.a = cubed_gain(volume);
+	push_command(cmd);
 }
 
 /// ------------------------
@@ -471,7 +719,10 @@ boolean I_SetSongSpeed(float speed)
 {
 	if (resample_music_player)
 	{
-		resample_music_player->ratio(speed);
+		AudioCommand cmd {};
+		cmd.type = AudioCommand::Type::kSongSpeed;
+		cmd.a = speed;
+		push_command(cmd);
 		return true;
 	}
 
@@ -533,9 +784,10 @@ boolean I_SetSongPosition(UINT32 position)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	music_player->seek(position / 1000.f);
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kSeekSong;
+	cmd.a = position / 1000.f;
+	push_command(cmd);
 	return true;
 }
 
@@ -612,7 +864,7 @@ boolean I_LoadSong(char* data, size_t len)
 		return false;
 	}
 
-	if (music_fade_callback && music_player->fading())
+	if (music_fade_callback && !music_fade_done())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
@@ -645,7 +897,7 @@ void I_UnloadSong(void)
 	if (!music_player)
 		return;
 
-	if (music_fade_callback && music_player->fading())
+	if (music_fade_callback && !music_fade_done())
 	{
 		auto old_callback = music_fade_callback;
 		music_fade_callback = nullptr;
@@ -662,9 +914,10 @@ boolean I_PlaySong(boolean looping)
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	music_player->play(looping);
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kPlaySong;
+	cmd.flag = looping;
+	push_command(cmd);
 
 	return true;
 }
@@ -674,9 +927,9 @@ void I_StopSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop();
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kStopSong;
+	push_command(cmd);
 }
 
 void I_PauseSong(void)
@@ -684,9 +937,9 @@ void I_PauseSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->pause();
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kPauseSong;
+	push_command(cmd);
 }
 
 void I_ResumeSong(void)
@@ -694,32 +947,30 @@ void I_ResumeSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->unpause();
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kResumeSong;
+	push_command(cmd);
 }
 
 void I_SetMusicVolume(int volume)
 {
-	float vol = static_cast<float>(volume) / 100.f;
-
-	if (gain_music_channel)
-	{
-		// Music channel volume is interpreted as logarithmic rather than linear.
-		// We approximate by cubing the gain level so vol 50 roughly sounds half as loud.
-		gain_music_channel->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
-	}
+	// Music channel volume is interpreted as logarithmic rather than linear.
+	// We approximate by cubing the gain level so vol 50 roughly sounds half as loud.
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kMusicVolume;
+	cmd.a = cubed_gain(volume);
+	push_command(cmd);
 }
 
 void I_SetCurrentSongVolume(int volume)
 {
 	float vol = static_cast<float>(volume) / 100.f;
 
-	if (gain_music_player)
-	{
-		// However, different from music channel volume, musicdef volumes are explicitly linear.
-		gain_music_player->gain(std::max(vol, 0.f));
-	}
+	// However, different from music channel volume, musicdef volumes are explicitly linear.
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kSongVolume;
+	cmd.a = std::max(vol, 0.f);
+	push_command(cmd);
 }
 
 boolean I_SetSongTrack(int track)
@@ -737,10 +988,10 @@ void I_SetInternalMusicVolume(UINT8 volume)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	float gain = volume / 100.f;
-	music_player->internal_gain(gain);
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kInternalMusicVolume;
+	cmd.a = volume / 100.f;
+	push_command(cmd);
 }
 
 void I_StopFadingSong(void)
@@ -748,9 +999,9 @@ void I_StopFadingSong(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop_fade();
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kStopFadingSong;
+	push_command(cmd);
 }
 
 boolean I_FadeSongFromVolume(UINT8 target_volume, UINT8 source_volume, UINT32 ms, void (*callback)(void))
@@ -758,13 +1009,14 @@ boolean I_FadeSongFromVolume(UINT8 target_volume, UINT8 source_volume, UINT32 ms
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	float source_gain = source_volume / 100.f;
-	float target_gain = target_volume / 100.f;
-	float seconds = ms / 1000.f;
-
-	music_player->fade_from_to(source_gain, target_gain, seconds);
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kFadeSong;
+	cmd.flag = true;
+	cmd.generation = ++music_fade_generation;
+	cmd.a = source_volume / 100.f;
+	cmd.b = target_volume / 100.f;
+	cmd.c = ms / 1000.f;
+	push_command(cmd);
 
 	if (music_fade_callback)
 		music_fade_callback();
@@ -778,12 +1030,12 @@ boolean I_FadeSong(UINT8 target_volume, UINT32 ms, void (*callback)(void))
 	if (!music_player)
 		return false;
 
-	SdlAudioLockHandle _;
-
-	float target_gain = target_volume / 100.f;
-	float seconds = ms / 1000.f;
-
-	music_player->fade_to(target_gain, seconds);
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kFadeSong;
+	cmd.generation = ++music_fade_generation;
+	cmd.b = target_volume / 100.f;
+	cmd.c = ms / 1000.f;
+	push_command(cmd);
 
 	if (music_fade_callback)
 		music_fade_callback();
@@ -797,9 +1049,9 @@ static void stop_song_cb(void)
 	if (!music_player)
 		return;
 
-	SdlAudioLockHandle _;
-
-	music_player->stop();
+	AudioCommand cmd {};
+	cmd.type = AudioCommand::Type::kStopSong;
+	push_command(cmd);
 }
 
 boolean I_FadeOutStopSong(UINT32 ms)
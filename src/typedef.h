@@ -216,6 +216,7 @@ TYPEDEF (modedesc_t);
 TYPEDEF (pathfindnode_t);
 TYPEDEF (path_t);
 TYPEDEF (pathfindsetup_t);
+TYPEDEF (pathfindarena_t);
 
 // k_profiles.h
 TYPEDEF (profile_t);
@@ -255,6 +256,10 @@ TYPEDEF (mapUserProperties_t);
 // lua_hudlib_drawlist.h
 typedef struct huddrawlist_s *huddrawlist_h;
 
+// lua_alloc.h
+TYPEDEF (lua_heap_t);
+TYPEDEF (lua_heapstats_t);
+
 // lua_profile.h
 TYPEDEF (lua_timer_t);
 
@@ -281,6 +286,7 @@ TYPEDEF (matrix_t);
 // m_perfstats.h
 TYPEDEF (ps_hookinfo_t);
 TYPEDEF (ps_botinfo_t);
+TYPEDEF (ps_histogram_t);
 
 // m_queue.h
 TYPEDEF (mqueueitem_t);
@@ -296,6 +302,7 @@ TYPEDEF (jingle_t);
 TYPEDEF (tm_t);
 TYPEDEF (TryMoveResult_t);
 TYPEDEF (BasicFF_t);
+TYPEDEF (sightmarks_t);
 
 // p_maputl.h
 TYPEDEF (divline_t);
@@ -304,7 +311,6 @@ TYPEDEF (opening_t);
 
 // p_mobj.h
 TYPEDEF (mobj_t);
-TYPEDEF (precipmobj_t);
 TYPEDEF (actioncache_t);
 
 // p_polyobj.h
@@ -327,6 +333,9 @@ TYPEDEF (polyrotdisplacedata_t);
 TYPEDEF (polyflagdata_t);
 TYPEDEF (polyfadedata_t);
 
+// p_precip.h
+TYPEDEF (precipcell_t);
+
 // p_saveg.h
 TYPEDEF (savedata_t);
 TYPEDEF (savedata_cup_t);
@@ -397,7 +406,6 @@ TYPEDEF (line_t);
 TYPEDEF (side_t);
 TYPEDEF (subsector_t);
 TYPEDEF (msecnode_t);
-TYPEDEF (mprecipsecnode_t);
 TYPEDEF (lightmap_t);
 TYPEDEF (seg_t);
 
@@ -466,6 +474,7 @@ TYPEDEF (lumpinfo_t);
 TYPEDEF (virtlump_t);
 TYPEDEF (virtres_t);
 TYPEDEF (wadfile_t);
+TYPEDEF (lumpread_t);
 
 #undef TYPEDEF
 #undef TYPEDEF2
@@ -34,6 +34,11 @@
 #include <unistd.h>
 #endif
 
+#if defined (__unix__) || defined (__APPLE__)
+#include <sys/mman.h>
+#define WAD_MMAP
+#endif
+
 #define ZWAD
 
 #ifdef ZWAD
@@ -42,7 +47,10 @@
 #endif
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
+#include <mutex>
+#include <vector>
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -69,9 +77,11 @@
 #include "i_system.h"
 #include "md5.h"
 #include "lua_script.h"
+#include "core/thread_pool.h"
 #include "g_game.h" // G_SetGameModified
 
 #include "k_terrain.h"
+#include "m_argv.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -107,6 +117,46 @@ typedef struct lumpnum_cache_s
 static lumpnum_cache_t lumpnumcache[LUMPNUMCACHESIZE];
 static UINT16 lumpnumcacheindex = 0;
 
+namespace
+{
+
+// Open addressing table from lump names to lump numbers. Slots hold 1 + the value, so 0 is an empty slot.
+// Keys aren't stored, the caller compares against the lump the value points to.
+struct lumpnametable_t
+{
+	std::vector<UINT32> slots;
+	std::vector<UINT32> hashes;
+	size_t count = 0;
+};
+
+// Name lookups for the lumps of one wad. Only lumps that the linear searches would accept are indexed.
+struct wadlumpindex_t
+{
+	lumpnametable_t names;            // 8 character name -> first lump with it
+	lumpnametable_t longnames;        // long name -> first lump with it
+	lumpnametable_t folders;          // PK3 folder path -> first lump inside of it, with the path length in the upper word
+	std::vector<UINT16> nextname;     // next lump with the same 8 character name, UINT16_MAX at the end
+	std::vector<UINT16> nextlongname; // next lump with the same long name, UINT16_MAX at the end
+	bool valid = false;
+};
+
+std::array<wadlumpindex_t, MAX_WADFILES> wadlumpindexes;
+
+// Names across every wad, pointing at the lump from the latest wad that has it
+lumpnametable_t globalnames;
+lumpnametable_t globallongnames;
+
+// Read-only mapping of a whole wad file, with -mmapwads
+struct wadfilemap_t
+{
+	const UINT8 *data = nullptr;
+	size_t size = 0;
+};
+
+std::array<wadfilemap_t, MAX_WADFILES> wadfilemaps;
+
+}; // namespace
+
 //===========================================================================
 //                                                                    GLOBALS
 //===========================================================================
@@ -124,6 +174,13 @@ void W_Shutdown(void)
 	{
 		wadfile_t *wad = wadfiles[numwadfiles];
 
+#ifdef WAD_MMAP
+		if (wadfilemaps[numwadfiles].data != nullptr)
+		{
+			munmap((void *)wadfilemaps[numwadfiles].data, wadfilemaps[numwadfiles].size);
+			wadfilemaps[numwadfiles] = {};
+		}
+#endif
 		fclose(wad->handle);
 		Z_Free(wad->filename);
 		while (wad->numlumps--)
@@ -322,6 +379,257 @@ static void W_InvalidateLumpnumCache(void)
 	memset(lumpnumcache, 0, sizeof (lumpnumcache));
 }
 
+static size_t W_LumpNameTableSlot(const lumpnametable_t &table, UINT32 hash)
+{
+	return (hash ^ (hash >> 15)) & (table.slots.size() - 1);
+}
+
+// Finds the slot holding the value that matches, or the empty slot it would go in.
+template <typename F>
+static size_t W_LumpNameTableFind(const lumpnametable_t &table, UINT32 hash, F &&matches)
+{
+	const size_t mask = table.slots.size() - 1;
+	size_t i = W_LumpNameTableSlot(table, hash);
+
+	while (table.slots[i] != 0 && !(table.hashes[i] == hash && matches(table.slots[i] - 1)))
+	{
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+// Returns the value that matches, or UINT32_MAX if there isn't one.
+template <typename F>
+static UINT32 W_LumpNameTableGet(const lumpnametable_t &table, UINT32 hash, F &&matches)
+{
+	if (table.count == 0)
+	{
+		return UINT32_MAX;
+	}
+
+	const size_t i = W_LumpNameTableFind(table, hash, matches);
+	return table.slots[i] - 1;
+}
+
+// Adds a value, or replaces the value that matches.
+template <typename F>
+static void W_LumpNameTableSet(lumpnametable_t &table, UINT32 hash, UINT32 value, F &&matches)
+{
+	if ((table.count + 1) * 2 > table.slots.size())
+	{
+		// Grow, every key is already unique so entries just go in the first empty slot
+		std::vector<UINT32> oldslots(std::max<size_t>(table.slots.size() * 2, 64), 0);
+		std::vector<UINT32> oldhashes(oldslots.size(), 0);
+
+		oldslots.swap(table.slots);
+		oldhashes.swap(table.hashes);
+
+		for (size_t j = 0; j < oldslots.size(); j++)
+		{
+			if (oldslots[j] == 0)
+			{
+				continue;
+			}
+
+			size_t i = W_LumpNameTableSlot(table, oldhashes[j]);
+			while (table.slots[i] != 0)
+			{
+				i = (i + 1) & (table.slots.size() - 1);
+			}
+
+			table.slots[i] = oldslots[j];
+			table.hashes[i] = oldhashes[j];
+		}
+	}
+
+	const size_t i = W_LumpNameTableFind(table, hash, matches);
+
+	if (table.slots[i] == 0)
+	{
+		table.hashes[i] = hash;
+		table.count++;
+	}
+
+	table.slots[i] = value + 1;
+}
+
+static lumpinfo_t *W_LumpInfoForNum(lumpnum_t lumpnum)
+{
+	return wadfiles[WADFILENUM(lumpnum)]->lumpinfo + LUMPNUM(lumpnum);
+}
+
+// Builds the name index for a wad that is about to be added, and makes its lumps take precedence in the global
+// index. Lumps are indexed only if the hash checks in the linear searches would have accepted them.
+static void W_IndexWadLumps(UINT16 wad)
+{
+	wadfile_t *wadfile = wadfiles[wad];
+	wadlumpindex_t &index = wadlumpindexes[wad];
+	lumpinfo_t *lumpinfo = wadfile->lumpinfo;
+	INT32 i;
+
+	index = {};
+	index.nextname.assign(wadfile->numlumps, UINT16_MAX);
+	index.nextlongname.assign(wadfile->numlumps, UINT16_MAX);
+
+	// Go backwards so the first lump with each name ends up in the table, and the rest are chained after it in order
+	for (i = wadfile->numlumps - 1; i >= 0; i--)
+	{
+		lumpinfo_t *lump_p = lumpinfo + i;
+		UINT32 hash;
+		UINT32 first;
+
+		hash = quickncasehash(lump_p->name, 8);
+		if (lump_p->hash == hash)
+		{
+			auto matches = [&](UINT32 j) { return strncasecmp(lumpinfo[j].name, lump_p->name, 8) == 0; };
+
+			first = W_LumpNameTableGet(index.names, hash, matches);
+			if (first != UINT32_MAX)
+			{
+				index.nextname[i] = (UINT16)first;
+			}
+			W_LumpNameTableSet(index.names, hash, (UINT32)i, matches);
+		}
+
+		if (lump_p->hash == quickncasehash(lump_p->longname, 8))
+		{
+			auto matches = [&](UINT32 j) { return strcasecmp(lumpinfo[j].longname, lump_p->longname) == 0; };
+
+			hash = quickncasehash(lump_p->longname, SIZE_MAX);
+			first = W_LumpNameTableGet(index.longnames, hash, matches);
+			if (first != UINT32_MAX)
+			{
+				index.nextlongname[i] = (UINT16)first;
+			}
+			W_LumpNameTableSet(index.longnames, hash, (UINT32)i, matches);
+		}
+
+		if (wadfile->type == RET_PK3)
+		{
+			const char *slash;
+
+			for (slash = strchr(lump_p->fullname, '/'); slash != NULL; slash = strchr(slash + 1, '/'))
+			{
+				const size_t len = (slash - lump_p->fullname) + 1;
+
+				if (len > UINT16_MAX)
+				{
+					break;
+				}
+
+				auto matches = [&](UINT32 j)
+				{
+					return (j >> 16) == len && strnicmp(lumpinfo[j & 0xFFFF].fullname, lump_p->fullname, len) == 0;
+				};
+
+				W_LumpNameTableSet(index.folders, quickncasehash(lump_p->fullname, len), (UINT32)i | ((UINT32)len << 16), matches);
+			}
+		}
+	}
+
+	index.valid = true;
+
+	// This wad is newer than everything already added, so its lumps replace any with the same name
+	for (size_t j = 0; j < index.names.slots.size(); j++)
+	{
+		if (index.names.slots[j] == 0)
+		{
+			continue;
+		}
+
+		const lumpinfo_t *lump_p = lumpinfo + (index.names.slots[j] - 1);
+
+		W_LumpNameTableSet(globalnames, index.names.hashes[j], (wad << 16) | (index.names.slots[j] - 1),
+			[&](UINT32 lumpnum) { return strncasecmp(W_LumpInfoForNum(lumpnum)->name, lump_p->name, 8) == 0; });
+	}
+
+	for (size_t j = 0; j < index.longnames.slots.size(); j++)
+	{
+		if (index.longnames.slots[j] == 0)
+		{
+			continue;
+		}
+
+		const lumpinfo_t *lump_p = lumpinfo + (index.longnames.slots[j] - 1);
+
+		W_LumpNameTableSet(globallongnames, index.longnames.hashes[j], (wad << 16) | (index.longnames.slots[j] - 1),
+			[&](UINT32 lumpnum) { return strcasecmp(W_LumpInfoForNum(lumpnum)->longname, lump_p->longname) == 0; });
+	}
+}
+
+// Looks up the first lump inside of a PK3 folder from the index. Returns false if the answer isn't known from the
+// index, and the caller has to search. Otherwise *lump is the lump, or numlumps if nothing is in the folder.
+static boolean W_LookupFolderPK3(const char *name, UINT16 wad, UINT16 startlump, INT32 *lump)
+{
+	const wadlumpindex_t &index = wadlumpindexes[wad];
+	const lumpinfo_t *lumpinfo = wadfiles[wad]->lumpinfo;
+	const size_t len = strlen(name);
+	UINT32 found;
+
+	// Only whole folder paths are indexed
+	if (index.valid == false || wadfiles[wad]->type != RET_PK3 || len == 0 || len > UINT16_MAX || name[len - 1] != '/')
+	{
+		return false;
+	}
+
+	found = W_LumpNameTableGet(index.folders, quickncasehash(name, len),
+		[&](UINT32 j) { return (j >> 16) == len && strnicmp(lumpinfo[j & 0xFFFF].fullname, name, len) == 0; });
+
+	if (found == UINT32_MAX)
+	{
+		*lump = wadfiles[wad]->numlumps;
+		return true;
+	}
+
+	if ((found & 0xFFFF) < startlump)
+	{
+		// Only the first lump in each folder is known
+		return false;
+	}
+
+	*lump = found & 0xFFFF;
+	return true;
+}
+
+// Maps a wad file into memory for W_GetLumpDataPwad and W_ReadLumpHeaderPwad, if -mmapwads is on.
+// Lumps are read through the file handle as usual if this fails.
+static void W_MapWadFile(UINT16 wad)
+{
+	wadfilemaps[wad] = {};
+
+#ifdef WAD_MMAP
+	wadfile_t *wadfile = wadfiles[wad];
+	void *data;
+
+	if (!M_CheckParm("-mmapwads") || wadfile->filesize == 0)
+		return;
+
+	data = mmap(NULL, wadfile->filesize, PROT_READ, MAP_PRIVATE, fileno(wadfile->handle), 0);
+	if (data == MAP_FAILED)
+	{
+		CONS_Debug(DBG_SETUP, "Couldn't map %s, reading it normally\n", wadfile->filename);
+		return;
+	}
+
+	wadfilemaps[wad].data = static_cast<const UINT8*>(data);
+	wadfilemaps[wad].size = wadfile->filesize;
+#else
+	(void)wad;
+#endif
+}
+
+// Gets a pointer to raw lump data in a mapped wad file, or NULL if the file isn't mapped or the range is outside of it.
+static const UINT8 *W_GetMappedRange(UINT16 wad, size_t position, size_t length)
+{
+	const wadfilemap_t &map = wadfilemaps[wad];
+
+	if (map.data == nullptr || position > map.size || length > map.size - position)
+		return NULL;
+
+	return map.data + position;
+}
+
 /** Detect a file type.
  * \todo Actually detect the wad/pkzip headers and whatnot, instead of just checking the extensions.
  */
@@ -920,6 +1228,8 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup, boole
 	//
 	CONS_Printf(M_GetText("Added file %s (%u lumps)\n"), filename, numlumps);
 	wadfiles[numwadfiles] = wadfile;
+	W_IndexWadLumps(numwadfiles);
+	W_MapWadFile(numwadfiles);
 	numwadfiles++; // must come BEFORE W_LoadDehackedLumps, so any addfile called by COM_BufInsertText called by Lua doesn't overwrite what we just loaded
     if (local)
         lua_localloading = 1;
@@ -1169,7 +1479,25 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	//
 	if (startlump < wadfiles[wad]->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
+		const wadlumpindex_t &index = wadlumpindexes[wad];
+		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo;
+
+		if (index.valid)
+		{
+			UINT32 found = W_LumpNameTableGet(index.names, hash,
+				[&](UINT32 j) { return strncasecmp(lump_p[j].name, name, 8) == 0; });
+
+			// Lumps with the same name are chained in order
+			for (; found != UINT32_MAX && found != UINT16_MAX; found = index.nextname[found])
+			{
+				if (found >= startlump)
+					return (UINT16)found;
+			}
+
+			return INT16_MAX;
+		}
+
+		lump_p += startlump;
 		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
 		{
 			if (lump_p->hash != hash)
@@ -1205,7 +1533,25 @@ UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	//
 	if (startlump < wadfiles[wad]->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
+		const wadlumpindex_t &index = wadlumpindexes[wad];
+		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo;
+
+		if (index.valid)
+		{
+			UINT32 found = W_LumpNameTableGet(index.longnames, quickncasehash(name, SIZE_MAX),
+				[&](UINT32 j) { return strcasecmp(lump_p[j].longname, name) == 0; });
+
+			// Lumps with the same name are chained in order
+			for (; found != UINT32_MAX && found != UINT16_MAX; found = index.nextlongname[found])
+			{
+				if (found >= startlump)
+					return (UINT16)found;
+			}
+
+			return INT16_MAX;
+		}
+
+		lump_p += startlump;
 		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
 		{
 			if (lump_p->hash != hash)
@@ -1237,6 +1583,13 @@ UINT16 W_CheckNumForFolderStartPK3(const char *name, UINT16 wad, UINT16 startlum
 	INT32 i;
 	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
 	name_length = strlen(name);
+	if (W_LookupFolderPK3(name, wad, startlump, &i))
+	{
+		/* SLADE is special and puts a single directory entry. Skip that. */
+		if (i < wadfiles[wad]->numlumps && strlen(wadfiles[wad]->lumpinfo[i].fullname) == name_length)
+			i++;
+		return i;
+	}
 	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
 	{
 		if (strnicmp(name, lump_p->fullname, name_length) == 0)
@@ -1271,6 +1624,10 @@ UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 {
 	INT32 i;
 	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
+	if (W_LookupFolderPK3(name, wad, startlump, &i))
+	{
+		return (i < wadfiles[wad]->numlumps) ? i : INT16_MAX;
+	}
 	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
 	{
 		if (!strnicmp(name, lump_p->fullname, strlen(name)))
@@ -1288,9 +1645,8 @@ UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 //
 lumpnum_t W_CheckNumForName(const char *name)
 {
-	lumpnum_t check = INT16_MAX;
 	UINT32 hash = name ? quickncasehash(name, 8) : 0;
-	INT32 i;
+	UINT32 check;
 
 	if (name == NULL)
 		return LUMPERROR;
@@ -1298,42 +1654,17 @@ lumpnum_t W_CheckNumForName(const char *name)
 	if (!*name) // some doofus gave us an empty string?
 		return LUMPERROR;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (!lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname[8]
-			&& lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumphash == hash
-			&& strncasecmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name, 8) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
-
-	// scan wad files backwards so patch lump files take precedence
-	for (i = numwadfiles - 1; i >= 0; i--)
-	{
-		check = W_CheckNumForNamePwad(name,(UINT16)i,0);
-		if (check != INT16_MAX)
-			break; //found it
-	}
+	// The global index already points at the lump from the latest file that has this name,
+	// so patch lump files take precedence
+	check = W_LumpNameTableGet(globalnames, hash,
+		[&](UINT32 lumpnum) { return strncasecmp(W_LumpInfoForNum(lumpnum)->name, name, 8) == 0; });
 
-	if (check == INT16_MAX)
+	if (check == UINT32_MAX)
 	{
 		return LUMPERROR;
 	}
-	else
-	{
-		// Update the cache.
-		lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-		memset(lumpnumcache[lumpnumcacheindex].lumpname, '\0', LUMPNUMCACHENAME);
-		strncpy(lumpnumcache[lumpnumcacheindex].lumpname, name, 8);
-		lumpnumcache[lumpnumcacheindex].lumpnum = (i << 16) + check;
-		lumpnumcache[lumpnumcacheindex].lumphash = hash;
 
-		return lumpnumcache[lumpnumcacheindex].lumpnum;
-	}
+	return (lumpnum_t)check;
 }
 
 //
@@ -1344,9 +1675,7 @@ lumpnum_t W_CheckNumForName(const char *name)
 //
 lumpnum_t W_CheckNumForLongName(const char *name)
 {
-	lumpnum_t check = INT16_MAX;
-	UINT32 hash = name ? quickncasehash(name, LUMPNUMCACHENAME) : 0;
-	INT32 i;
+	UINT32 check;
 
 	if (name == NULL)
 		return LUMPERROR;
@@ -1354,44 +1683,15 @@ lumpnum_t W_CheckNumForLongName(const char *name)
 	if (!*name) // some doofus gave us an empty string?
 		return LUMPERROR;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumphash == hash
-			&& strcasecmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
-
-	// scan wad files backwards so patch lump files take precedence
-	for (i = numwadfiles - 1; i >= 0; i--)
-	{
-		check = W_CheckNumForLongNamePwad(name,(UINT16)i,0);
-		if (check != INT16_MAX)
-			break; //found it
-	}
+	check = W_LumpNameTableGet(globallongnames, quickncasehash(name, SIZE_MAX),
+		[&](UINT32 lumpnum) { return strcasecmp(W_LumpInfoForNum(lumpnum)->longname, name) == 0; });
 
-	if (check == INT16_MAX)
+	if (check == UINT32_MAX)
 	{
 		return LUMPERROR;
 	}
-	else
-	{
-		if (strlen(name) < LUMPNUMCACHENAME)
-		{
-			// Update the cache.
-			lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-			memset(lumpnumcache[lumpnumcacheindex].lumpname, '\0', LUMPNUMCACHENAME);
-			strlcpy(lumpnumcache[lumpnumcacheindex].lumpname, name, LUMPNUMCACHENAME);
-			lumpnumcache[lumpnumcacheindex].lumpnum = (i << 16) + check;
-			lumpnumcache[lumpnumcacheindex].lumphash = hash;
-		}
 
-		return (i << 16) + check;
-	}
+	return (lumpnum_t)check;
 }
 
 // Look for valid map data through all added files in descendant order.
@@ -1644,30 +1944,71 @@ void zerr(int ret)
 }
 #endif
 
-/** Reads bytes from the head of a lump.
-  * Note: If the lump is compressed, the whole thing has to be read anyway.
+/** Reads bytes from a wad file at a position, without moving the file
+  * position, so reads can be made from several threads at once.
   *
-  * \param wad Wad number to read from.
-  * \param lump Lump number to read from.
-  * \param dest Buffer in memory to serve as destination.
+  * \param handle File to read from.
+  * \param dest Buffer to read into.
   * \param size Number of bytes to read.
-  * \param offest Number of bytes to offset.
-  * \return Number of bytes read (should equal size).
-  * \sa W_ReadLump, W_RawReadLumpHeader
+  * \param position Offset into the file to read from.
+  * \return Number of bytes read.
   */
-size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
+static size_t W_ReadFileAt(FILE *handle, void *dest, size_t size, size_t position)
+{
+#ifdef WAD_MMAP
+	const int fd = fileno(handle);
+	size_t total = 0;
+
+	while (total < size)
+	{
+		ssize_t count = pread(fd, static_cast<UINT8*>(dest) + total, size - total, (off_t)(position + total));
+
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count <= 0)
+			break;
+
+		total += count;
+	}
+
+	return total;
+#else
+	static std::mutex readmutex;
+	std::lock_guard<std::mutex> lock(readmutex);
+
+	fseek(handle, (long)position, SEEK_SET);
+	return fread(dest, 1, size, handle);
+#endif
+}
+
+/** Makes one lump read, without touching anything only the main thread may
+  * use. Failures are left in read->error for W_FinishLumpRead to report.
+  *
+  * \param read Read to make. Its result is set to the number of bytes read.
+  */
+static void W_DoLumpRead(lumpread_t *read)
 {
+	const UINT16 wad = read->wad;
+	const UINT16 lump = read->lump;
+	void *dest = read->dest;
+	size_t size = read->size;
+	const size_t offset = read->offset;
 	size_t lumpsize;
 	lumpinfo_t *l;
 	FILE *handle;
+	const UINT8 *mapped;
+
+	read->result = 0;
+	read->error = LUMPREAD_OK;
+	read->zerror = 0;
 
 	if (!TestValidLump(wad,lump))
-		return 0;
+		return;
 
 	lumpsize = wadfiles[wad]->lumpinfo[lump].size;
 	// empty resource (usually markers like S_START, F_END ..)
 	if (!lumpsize || lumpsize<offset)
-		return 0;
+		return;
 
 	// zero size means read all the lump
 	if (!size || size+offset > lumpsize)
@@ -1677,22 +2018,31 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	// We setup the desired file handle to read the lump data.
 	l = wadfiles[wad]->lumpinfo + lump;
 	handle = wadfiles[wad]->handle;
-	fseek(handle, (long)(l->position + offset), SEEK_SET);
+
+	// If the file is mapped, the data is read straight from the mapping instead of seeking the shared handle.
+	mapped = W_GetMappedRange(wad, l->position + offset,
+		(l->compression == CM_NOCOMPRESSION) ? size : l->disksize);
 
 	// But let's not copy it yet. We support different compression formats on lumps, so we need to take that into account.
 	switch(wadfiles[wad]->lumpinfo[lump].compression)
 	{
 	case CM_NOCOMPRESSION:		// If it's uncompressed, we directly write the data into our destination, and return the bytes read.
-#ifdef NO_PNG_LUMPS
 		{
-			size_t bytesread = fread(dest, 1, size, handle);
+			size_t bytesread;
+			if (mapped != NULL)
+			{
+				M_Memcpy(dest, mapped, size);
+				bytesread = size;
+			}
+			else
+				bytesread = W_ReadFileAt(handle, dest, size, l->position + offset);
+#ifdef NO_PNG_LUMPS
 			if (Picture_IsLumpPNG((UINT8 *)dest, bytesread))
-				Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
-			return bytesread;
-		}
-#else
-		return fread(dest, 1, size, handle);
+				read->error = LUMPREAD_PNG;
 #endif
+			read->result = bytesread;
+			return;
+		}
 	case CM_LZF:		// Is it LZF compressed? Used by ZWADs.
 		{
 #ifdef ZWAD
@@ -1700,41 +2050,51 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			char *decData; // Lump's decompressed real data.
 			size_t retval; // Helper var, lzf_decompress returns 0 when an error occurs.
 
-			rawData = static_cast<char*>(Z_Malloc(l->disksize, PU_STATIC, NULL));
-			decData = static_cast<char*>(Z_Malloc(l->size, PU_STATIC, NULL));
+			// Temporary buffers come from malloc, not the zone, so this can run on any thread.
+			rawData = (mapped != NULL) ? NULL : static_cast<char*>(malloc(l->disksize));
+			decData = static_cast<char*>(malloc(l->size));
 
-			if (fread(rawData, 1, l->disksize, handle) < l->disksize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
-			retval = lzf_decompress(rawData, l->disksize, decData, l->size);
-#ifndef AVOID_ERRNO
-			if (retval == 0) // If this was returned, check if errno was set
+			if ((mapped == NULL && rawData == NULL) || decData == NULL)
+				read->error = LUMPREAD_NOMEMORY;
+			else if (mapped == NULL && W_ReadFileAt(handle, rawData, l->disksize, l->position + offset) < l->disksize)
+				read->error = LUMPREAD_READFAILED;
+			else
 			{
-				// errno is a global var set by the lzf functions when something goes wrong.
-				if (errno == E2BIG)
-					I_Error("wad %d, lump %d: compressed data too big (bigger than %s)", wad, lump, sizeu1(l->size));
-				else if (errno == EINVAL)
-					I_Error("wad %d, lump %d: invalid compressed data", wad, lump);
-			}
-			// Otherwise, fall back on below error (if zero was actually the correct size then ???)
+				retval = lzf_decompress((mapped != NULL) ? static_cast<const void*>(mapped) : rawData, l->disksize, decData, l->size);
+#ifndef AVOID_ERRNO
+				if (retval == 0) // If this was returned, check if errno was set
+				{
+					// errno is set by the lzf functions when something goes wrong. It's per-thread.
+					if (errno == E2BIG)
+						read->error = LUMPREAD_TOOBIG;
+					else if (errno == EINVAL)
+						read->error = LUMPREAD_INVALID;
+				}
+				// Otherwise, fall back on below error (if zero was actually the correct size then ???)
 #endif
-			if (retval != l->size)
-			{
-				I_Error("wad %d, lump %d: decompressed to wrong number of bytes (expected %s, got %s)", wad, lump, sizeu1(l->size), sizeu2(retval));
+				if (read->error == LUMPREAD_OK && retval != l->size)
+				{
+					read->error = LUMPREAD_WRONGSIZE;
+					read->result = retval;
+				}
 			}
 
-			if (!decData) // Did we get no data at all?
-				return 0;
-			M_Memcpy(dest, decData + offset, size);
-			Z_Free(rawData);
-			Z_Free(decData);
+			if (read->error == LUMPREAD_OK)
+			{
+				M_Memcpy(dest, decData + offset, size);
 #ifdef NO_PNG_LUMPS
-			if (Picture_IsLumpPNG((UINT8 *)dest, size))
-				Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
+				if (Picture_IsLumpPNG((UINT8 *)dest, size))
+					read->error = LUMPREAD_PNG;
 #endif
-			return size;
+				read->result = size;
+			}
+
+			free(rawData);
+			free(decData);
+			return;
 #else
 			//I_Error("ZWAD files not supported on this platform.");
-			return 0;
+			return;
 #endif
 
 		}
@@ -1749,11 +2109,22 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			unsigned long rawSize = l->disksize;
 			unsigned long decSize = size;
 
-			rawData = static_cast<UINT8*>(Z_Malloc(rawSize, PU_STATIC, NULL));
+			// Temporary buffers come from malloc, not the zone, so this can run on any thread.
+			rawData = (mapped != NULL) ? NULL : static_cast<UINT8*>(malloc(rawSize));
 			decData = static_cast<UINT8*>(dest);
 
-			if (fread(rawData, 1, rawSize, handle) < rawSize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			if (mapped == NULL && rawData == NULL)
+			{
+				read->error = LUMPREAD_NOMEMORY;
+				return;
+			}
+
+			if (mapped == NULL && W_ReadFileAt(handle, rawData, rawSize, l->position + offset) < rawSize)
+			{
+				read->error = LUMPREAD_READFAILED;
+				free(rawData);
+				return;
+			}
 
 			strm.zalloc = Z_NULL;
 			strm.zfree = Z_NULL;
@@ -1762,7 +2133,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			strm.total_in = strm.avail_in = rawSize;
 			strm.total_out = strm.avail_out = decSize;
 
-			strm.next_in = rawData;
+			strm.next_in = (mapped != NULL) ? const_cast<UINT8*>(mapped) : rawData;
 			strm.next_out = decData;
 
 			zErr = inflateInit2(&strm, -15);
@@ -1772,29 +2143,95 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 				if (zErr != Z_OK && zErr != Z_STREAM_END)
 				{
 					size = 0;
-					zerr(zErr);
+					read->zerror = zErr;
 				}
 				(void)inflateEnd(&strm);
 			}
 			else
 			{
 				size = 0;
-				zerr(zErr);
+				read->zerror = zErr;
 			}
 
-			Z_Free(rawData);
+			free(rawData);
 
 #ifdef NO_PNG_LUMPS
 			if (Picture_IsLumpPNG((UINT8 *)dest, size))
-				Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
+				read->error = LUMPREAD_PNG;
 #endif
-			return size;
+			read->result = size;
+			return;
 		}
 #endif
 	default:
+		read->error = LUMPREAD_UNSUPPORTED;
+	}
+}
+
+/** Reports what went wrong with a lump read, if anything.
+  * Only call this from the main thread, since it may I_Error.
+  *
+  * \param read A read made by W_DoLumpRead.
+  */
+static void W_FinishLumpRead(const lumpread_t *read)
+{
+	const UINT16 wad = read->wad;
+	const UINT16 lump = read->lump;
+
+#ifdef HAVE_ZLIB
+	if (read->zerror != Z_OK)
+		zerr(read->zerror);
+#endif
+
+	switch (read->error)
+	{
+	case LUMPREAD_OK:
+		break;
+	case LUMPREAD_NOMEMORY:
+		I_Error("wad %d, lump %d: out of memory decompressing", wad, lump);
+		break;
+	case LUMPREAD_READFAILED:
+		I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+		break;
+	case LUMPREAD_TOOBIG:
+		I_Error("wad %d, lump %d: compressed data too big (bigger than %s)", wad, lump, sizeu1(wadfiles[wad]->lumpinfo[lump].size));
+		break;
+	case LUMPREAD_INVALID:
+		I_Error("wad %d, lump %d: invalid compressed data", wad, lump);
+		break;
+	case LUMPREAD_WRONGSIZE:
+		I_Error("wad %d, lump %d: decompressed to wrong number of bytes (expected %s, got %s)", wad, lump, sizeu1(wadfiles[wad]->lumpinfo[lump].size), sizeu2(read->result));
+		break;
+	case LUMPREAD_PNG:
+#ifdef NO_PNG_LUMPS
+		Picture_ThrowPNGError(wadfiles[wad]->lumpinfo[lump].fullname, wadfiles[wad]->filename);
+#endif
+		break;
+	case LUMPREAD_UNSUPPORTED:
 		I_Error("wad %d, lump %d: unsupported compression type!", wad, lump);
+		break;
 	}
-	return 0;
+}
+
+/** Reads bytes from the head of a lump.
+  * Note: If the lump is compressed, the whole thing has to be read anyway.
+  *
+  * \param wad Wad number to read from.
+  * \param lump Lump number to read from.
+  * \param dest Buffer in memory to serve as destination.
+  * \param size Number of bytes to read.
+  * \param offest Number of bytes to offset.
+  * \return Number of bytes read (should equal size).
+  * \sa W_ReadLump, W_RawReadLumpHeader
+  */
+size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
+{
+	lumpread_t read = {wad, lump, dest, size, offset, 0, LUMPREAD_OK, 0};
+
+	W_DoLumpRead(&read);
+	W_FinishLumpRead(&read);
+
+	return read.result;
 }
 
 size_t W_ReadLumpHeader(lumpnum_t lumpnum, void *dest, size_t size, size_t offset)
@@ -1819,6 +2256,79 @@ void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest)
 	W_ReadLumpHeaderPwad(wad, lump, dest, 0, 0);
 }
 
+/** Reads several lumps, inflating compressed ones on the thread pool.
+  * Decompressing deflated PK3 lumps is most of the cost of reading them,
+  * and W_DoLumpRead is safe to call from any thread. Failures are only
+  * reported once the whole batch is done, back on the calling thread.
+  *
+  * \param reads Reads to make. The result of each one is stored in it.
+  * \param count Number of reads.
+  */
+void W_ReadLumpsParallel(lumpread_t *reads, size_t count)
+{
+	// Batches big enough to be worth a task each, without starving threads on small lumps.
+	constexpr size_t kReadsPerTask = 4;
+
+	size_t i;
+
+	if (srb2::g_main_threadpool == nullptr || count <= 1)
+	{
+		for (i = 0; i < count; i++)
+		{
+			W_DoLumpRead(&reads[i]);
+			W_FinishLumpRead(&reads[i]);
+		}
+		return;
+	}
+
+	srb2::g_main_threadpool->begin_sema();
+	for (i = 0; i < count; i += kReadsPerTask)
+	{
+		lumpread_t *first = reads + i;
+		lumpread_t *last = reads + std::min(i + kReadsPerTask, count);
+
+		srb2::g_main_threadpool->schedule([first, last]() -> void {
+			for (lumpread_t *read = first; read < last; read++)
+				W_DoLumpRead(read);
+		});
+	}
+	srb2::ThreadPool::Sema sema = srb2::g_main_threadpool->end_sema();
+	srb2::g_main_threadpool->notify_sema(sema);
+	srb2::g_main_threadpool->wait_sema(sema);
+
+	for (i = 0; i < count; i++)
+		W_FinishLumpRead(&reads[i]);
+}
+
+/** Gets a lump's data without reading or copying it, for uncompressed
+  * lumps in files mapped with -mmapwads.
+  *
+  * \param wad Wad file the lump is in.
+  * \param lump Lump number in the wad file.
+  * \return A read-only view of the whole lump, valid until shutdown. NULL if
+  *         the lump isn't available this way, in which case read it normally.
+  *         This isn't zone memory, so never free it or change its tag.
+  */
+const void *W_GetLumpDataPwad(UINT16 wad, UINT16 lump)
+{
+	lumpinfo_t *l;
+
+	if (!TestValidLump(wad,lump))
+		return NULL;
+
+	l = wadfiles[wad]->lumpinfo + lump;
+
+	if (l->compression != CM_NOCOMPRESSION || l->size == 0)
+		return NULL;
+
+	return W_GetMappedRange(wad, l->position, l->size);
+}
+
+const void *W_GetLumpData(lumpnum_t lumpnum)
+{
+	return W_GetLumpDataPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum));
+}
+
 // ==========================================================================
 // W_CacheLumpNum
 // ==========================================================================
@@ -1846,6 +2356,47 @@ void *W_CacheLumpNum(lumpnum_t lumpnum, INT32 tag)
 	return W_CacheLumpNumPwad(WADFILENUM(lumpnum),LUMPNUM(lumpnum),tag);
 }
 
+/** Caches several lumps, like calling W_CacheLumpNum on each one,
+  * reading the ones that aren't cached yet in parallel.
+  *
+  * \param lumps Lumps to cache.
+  * \param count Number of lumps.
+  * \param tag Zone tag to give every lump.
+  */
+void W_CacheLumpNums(const lumpnum_t *lumps, size_t count, INT32 tag)
+{
+	std::vector<lumpread_t> reads;
+	size_t i;
+
+	reads.reserve(count);
+
+	// The zone isn't thread safe, so allocate everything here first.
+	for (i = 0; i < count; i++)
+	{
+		UINT16 wad = WADFILENUM(lumps[i]);
+		UINT16 lump = LUMPNUM(lumps[i]);
+		lumpcache_t *lumpcache;
+
+		if (!TestValidLump(wad,lump))
+			continue;
+
+		lumpcache = wadfiles[wad]->lumpcache;
+		if (!lumpcache[lump])
+		{
+			lumpread_t read = {};
+
+			read.wad = wad;
+			read.lump = lump;
+			read.dest = Z_Malloc(W_LumpLengthPwad(wad, lump), tag, &lumpcache[lump]);
+			reads.push_back(read);
+		}
+		else
+			Z_ChangeTag(lumpcache[lump], tag);
+	}
+
+	W_ReadLumpsParallel(reads.data(), reads.size());
+}
+
 //
 // W_CacheLumpNumForce
 //
@@ -2044,6 +2595,54 @@ void *W_CachePatchNum(lumpnum_t lumpnum, INT32 tag)
 	return W_CachePatchNumPwad(WADFILENUM(lumpnum),LUMPNUM(lumpnum),tag);
 }
 
+/** Caches several patches, like calling W_CachePatchNum on each one.
+  * The lumps of patches that aren't cached yet are read in parallel,
+  * then converted one at a time.
+  *
+  * \param lumps Lumps to cache.
+  * \param count Number of lumps.
+  * \param tag Zone tag to give every patch.
+  */
+void W_CachePatchNums(const lumpnum_t *lumps, size_t count, INT32 tag)
+{
+	// Sprite frames often share lumps between angles, so only read each one once.
+	std::vector<lumpnum_t> unique(lumps, lumps + count);
+	std::vector<lumpread_t> reads;
+	size_t i;
+
+	std::sort(unique.begin(), unique.end());
+	unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+	reads.reserve(unique.size());
+
+	for (lumpnum_t lumpnum : unique)
+	{
+		UINT16 wad = WADFILENUM(lumpnum);
+		UINT16 lump = LUMPNUM(lumpnum);
+		lumpread_t read = {};
+
+		if (!TestValidLump(wad,lump) || wadfiles[wad]->patchcache[lump])
+			continue;
+
+		read.wad = wad;
+		read.lump = lump;
+		read.size = W_LumpLengthPwad(wad, lump);
+		read.dest = Z_Malloc(read.size, PU_STATIC, NULL);
+		reads.push_back(read);
+	}
+
+	W_ReadLumpsParallel(reads.data(), reads.size());
+
+	// MakePatch allocates from the zone, so finish up on this thread.
+	for (lumpread_t &read : reads)
+	{
+		MakePatch(read.dest, read.size, tag, &wadfiles[read.wad]->patchcache[read.lump]);
+		Z_Free(read.dest);
+	}
+
+	for (i = 0; i < count; i++)
+		W_CachePatchNum(lumps[i], tag);
+}
+
 void W_UnlockCachedPatch(void *patch)
 {
 	if (!patch)
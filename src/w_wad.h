@@ -198,9 +198,44 @@ size_t W_ReadLumpHeader(lumpnum_t lump, void *dest, size_t size, size_t offest);
 void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest);
 void W_ReadLump(lumpnum_t lump, void *dest);
 
+// Why a lump read failed. Worker threads can't call I_Error, so they leave this
+// in the lumpread_t for the main thread to report.
+typedef enum
+{
+	LUMPREAD_OK,
+	LUMPREAD_NOMEMORY,
+	LUMPREAD_READFAILED,
+	LUMPREAD_TOOBIG,
+	LUMPREAD_INVALID,
+	LUMPREAD_WRONGSIZE, // result holds the size it decompressed to
+	LUMPREAD_PNG,
+	LUMPREAD_UNSUPPORTED,
+} lumpreaderror_t;
+
+// One read for W_ReadLumpsParallel
+struct lumpread_t
+{
+	UINT16 wad;
+	UINT16 lump;
+	void *dest;
+	size_t size; // 0 reads the whole lump
+	size_t offset;
+	size_t result; // bytes read, set by W_ReadLumpsParallel
+	lumpreaderror_t error;
+	INT32 zerror; // zlib error, reported with zerr; the read still returns 0 bytes
+};
+
+// Reads several lumps at once, decompressing them on the thread pool
+void W_ReadLumpsParallel(lumpread_t *reads, size_t count);
+
+// Read-only view of an uncompressed lump in a file mapped with -mmapwads, NULL if not available
+const void *W_GetLumpDataPwad(UINT16 wad, UINT16 lump);
+const void *W_GetLumpData(lumpnum_t lumpnum);
+
 void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag);
 void *W_CacheLumpNum(lumpnum_t lump, INT32 tag);
 void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag);
+void W_CacheLumpNums(const lumpnum_t *lumps, size_t count, INT32 tag); // batch W_CacheLumpNum, results discarded
 
 boolean W_IsLumpCached(lumpnum_t lump, void *ptr);
 boolean W_IsPatchCached(lumpnum_t lump, void *ptr);
@@ -213,6 +248,7 @@ void *W_CachePatchLongName(const char *name, INT32 tag);
 // Performs any necessary conversions from PNG images.
 void *W_CachePatchNumPwad(UINT16 wad, UINT16 lump, INT32 tag);
 void *W_CachePatchNum(lumpnum_t lumpnum, INT32 tag);
+void W_CachePatchNums(const lumpnum_t *lumps, size_t count, INT32 tag); // batch W_CachePatchNum, results discarded
 
 // Returns a Software patch.
 // Performs any necessary conversions from PNG images.
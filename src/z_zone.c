@@ -40,6 +40,7 @@
 #include "z_zone.h"
 #include "m_misc.h" // M_Memcpy
 #include "lua_script.h"
+#include "lua_alloc.h" // Lua heap info
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h" // For hardware memory info
@@ -53,6 +54,14 @@ static boolean Z_calloc = false;
 
 #define ZONEID 0xa441d13d
 
+// Level lifetime blocks are carved out of larger chunks instead of being
+// malloc'd one at a time. Valgrind and ZDEBUG builds keep every block as its
+// own allocation, so overruns are still caught there.
+#if !defined (HAVE_VALGRIND) && !defined (ZDEBUG)
+#define ZONE_LEVELARENA
+#endif
+
+typedef struct zonechunk_s zonechunk_t;
 
 typedef struct memblock_s
 {
@@ -66,6 +75,8 @@ typedef struct memblock_s
 	const char *ownerfile;
 	INT32 ownerline;
 
+	zonechunk_t *chunk; // the level arena chunk this block is in, NULL if it was malloc'd
+
 	struct memblock_s *next, *prev;
 } memblock_t;
 
@@ -73,8 +84,46 @@ typedef struct memblock_s
 #define MEMORY(x) (void *)((uintptr_t)(x) + sizeof(memblock_t) + ALIGNPAD)
 #define MEMBLOCK(x) (memblock_t *)((uintptr_t)(x) - ALIGNPAD - sizeof(memblock_t))
 
-// both the head and tail of the zone memory block list
-static memblock_t head;
+// Each tag below NUMTAGLISTS-1 has its own block list, so freeing a range of
+// tags only has to visit the blocks that are actually being freed. Any other
+// tag goes in the last list.
+#define NUMTAGLISTS 128
+#define TAGLIST(tag) (((tag) >= 0 && (tag) < NUMTAGLISTS-1) ? (tag) : NUMTAGLISTS-1)
+
+// both the head and tail of each zone memory block list
+static memblock_t heads[NUMTAGLISTS];
+
+// Whether a block list can hold any tag from lowtag to hightag.
+static inline boolean Z_TagListInRange(INT32 list, INT32 lowtag, INT32 hightag)
+{
+	if (list < NUMTAGLISTS-1)
+		return (list >= lowtag && list <= hightag);
+
+	// the last list has every tag that doesn't get its own
+	return (lowtag < 0 || hightag >= NUMTAGLISTS-1);
+}
+
+// bytes allocated in each block list, as counted by Z_TagsUsage
+static size_t tagusage[NUMTAGLISTS];
+
+#ifdef ZONE_LEVELARENA
+#define ARENACHUNKSIZE (1<<20)
+#define ARENAMAXBLOCK (ARENACHUNKSIZE/8) // anything larger is malloc'd as usual
+#define ARENAMAXFREECHUNKS 32 // how many empty chunks to keep for the next level
+
+struct zonechunk_s
+{
+	zonechunk_t *next; // only used while in the free list
+	size_t used; // bytes handed out so far, including padding
+	size_t live; // number of blocks still allocated in this chunk
+	boolean current; // whether new blocks are being carved out of this chunk
+	max_align_t data[];
+};
+
+static zonechunk_t *currentchunk;
+static zonechunk_t *freechunks;
+static size_t numfreechunks;
+#endif
 
 //
 // Function prototypes
@@ -94,10 +143,13 @@ static void Command_Memdump_f(void);
 void Z_Init(void)
 {
 	UINT32 total, memfree;
+	INT32 i;
 
-	memset(&head, 0x00, sizeof(head));
+	memset(heads, 0x00, sizeof(heads));
+	memset(tagusage, 0x00, sizeof(tagusage));
 
-	head.next = head.prev = &head;
+	for (i = 0; i < NUMTAGLISTS; i++)
+		heads[i].next = heads[i].prev = &heads[i];
 
 	memfree = I_GetFreeMem(&total)>>20;
 	CONS_Printf("System memory: %uMB - Free: %uMB\n", total>>20, memfree);
@@ -112,6 +164,125 @@ void Z_Init(void)
 // Zone memory allocation
 // ----------------------
 
+/** Links a block into the list for its tag.
+  *
+  * \param block The block to link.
+  */
+static void Z_LinkBlock(memblock_t *block)
+{
+	const INT32 list = TAGLIST(block->tag);
+	memblock_t *head = &heads[list];
+
+	block->next = head->next;
+	block->prev = head;
+	head->next = block;
+	block->next->prev = block;
+
+	tagusage[list] += block->size + sizeof *block;
+}
+
+/** Unlinks a block from the list for its tag.
+  *
+  * \param block The block to unlink.
+  */
+static void Z_UnlinkBlock(memblock_t *block)
+{
+	block->prev->next = block->next;
+	block->next->prev = block->prev;
+
+	tagusage[TAGLIST(block->tag)] -= block->size + sizeof *block;
+}
+
+#ifdef ZONE_LEVELARENA
+/** Returns an empty chunk to the free list, or to the system if there are
+  * enough spare chunks already.
+  *
+  * \param chunk The chunk to release.
+  */
+static void Z_ReleaseChunk(zonechunk_t *chunk)
+{
+	if (numfreechunks >= ARENAMAXFREECHUNKS)
+	{
+		free(chunk);
+		return;
+	}
+
+	chunk->used = 0;
+	chunk->current = false;
+	chunk->next = freechunks;
+	freechunks = chunk;
+	numfreechunks++;
+}
+
+/** Carves space for a block out of the current level arena chunk.
+  *
+  * \param blocksize Size of the block, including the header.
+  * \param chunkout Set to the chunk the block was placed in.
+  * \return The space for the block, or NULL if it is too large for the arena.
+  */
+static void *Z_ArenaAlloc(size_t blocksize, zonechunk_t **chunkout)
+{
+	const size_t size = (blocksize + (alignof (max_align_t) - 1)) & ~(alignof (max_align_t) - 1);
+	void *p;
+
+	if (blocksize > ARENAMAXBLOCK)
+		return NULL;
+
+	if (currentchunk == NULL || currentchunk->used + size > ARENACHUNKSIZE)
+	{
+		if (currentchunk != NULL)
+		{
+			currentchunk->current = false;
+			if (currentchunk->live == 0)
+				Z_ReleaseChunk(currentchunk);
+		}
+
+		if (freechunks != NULL)
+		{
+			currentchunk = freechunks;
+			freechunks = freechunks->next;
+			numfreechunks--;
+		}
+		else
+		{
+			currentchunk = malloc(sizeof (zonechunk_t) + ARENACHUNKSIZE);
+			if (currentchunk == NULL)
+				return NULL;
+		}
+
+		currentchunk->next = NULL;
+		currentchunk->used = 0;
+		currentchunk->live = 0;
+		currentchunk->current = true;
+	}
+
+	p = (UINT8 *)currentchunk->data + currentchunk->used;
+	currentchunk->used += size;
+	currentchunk->live++;
+
+	*chunkout = currentchunk;
+	return p;
+}
+
+/** Gives a block's space back to its level arena chunk. The chunk is reused
+  * once every block in it has been freed.
+  *
+  * \param chunk The chunk the block was in.
+  */
+static void Z_ArenaFree(zonechunk_t *chunk)
+{
+	I_Assert(chunk->live > 0);
+
+	if (--chunk->live > 0)
+		return;
+
+	if (chunk->current)
+		chunk->used = 0; // start over from the beginning
+	else
+		Z_ReleaseChunk(chunk);
+}
+#endif
+
 /** Frees allocated memory.
   *
   * \param ptr A pointer to allocated memory,
@@ -155,9 +326,16 @@ void Z_Free2(void *ptr, const char *file, INT32 line)
 #ifdef VALGRIND_DESTROY_MEMPOOL
 	VALGRIND_DESTROY_MEMPOOL(block);
 #endif
-	block->prev->next = block->next;
-	block->next->prev = block->prev;
+	Z_UnlinkBlock(block);
 	TracyCFree(block);
+#ifdef ZONE_LEVELARENA
+	if (block->chunk != NULL)
+	{
+		block->id = 0;
+		Z_ArenaFree(block->chunk);
+		return;
+	}
+#endif
 	free(block);
 }
 
@@ -206,6 +384,7 @@ void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 	const char *file, INT32 line)
 {
 	memblock_t *block;
+	zonechunk_t *chunk;
 	void *ptr;
 
 	(void)(alignbits); // no longer used, so silence warnings. TODO we should figure out a solution for this
@@ -214,7 +393,15 @@ void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 	CONS_Debug(DBG_MEMORY, "Z_Malloc %s:%d\n", file, line);
 #endif
 
-	block = xm(sizeof (memblock_t) + ALIGNPAD + size);
+	block = NULL;
+	chunk = NULL;
+#ifdef ZONE_LEVELARENA
+	// Level data is freed all at once on level exit, so it can share chunks
+	if (tag == PU_LEVEL || tag == PU_LEVSPEC)
+		block = Z_ArenaAlloc(sizeof (memblock_t) + ALIGNPAD + size, &chunk);
+#endif
+	if (block == NULL)
+		block = xm(sizeof (memblock_t) + ALIGNPAD + size);
 	TracyCAlloc(block, sizeof (memblock_t) + ALIGNPAD + size);
 	ptr = MEMORY(block);
 	I_Assert((intptr_t)ptr % alignof (max_align_t) == 0);
@@ -223,17 +410,15 @@ void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 	Z_calloc = false;
 #endif
 
-	block->next = head.next;
-	block->prev = &head;
-	head.next = block;
-	block->next->prev = block;
-
 	block->tag = tag;
 	block->user = NULL;
 	block->ownerline = line;
 	block->ownerfile = file;
 	block->size = sizeof (memblock_t) + size;
 	block->realsize = size;
+	block->chunk = chunk;
+
+	Z_LinkBlock(block);
 
 #ifdef VALGRIND_CREATE_MEMPOOL
 	VALGRIND_CREATE_MEMPOOL(block, size, Z_calloc);
@@ -344,6 +529,82 @@ void *Z_Realloc2(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits,
 	return rez;
 }
 
+/** Checks the blocks in one tag list for corruption.
+  *
+  * \param list Which tag list to check.
+  * \param i Identifies from where in the code the check was made.
+  * \param blocknumon Running count of blocks checked, for error messages.
+  */
+static void Z_CheckTagList(INT32 list, INT32 i, UINT32 *blocknumon)
+{
+	memblock_t *head = &heads[list];
+	memblock_t *block;
+	void *given;
+
+	for (block = head->next; block != head; block = block->next)
+	{
+		(*blocknumon)++;
+		given = MEMORY(block);
+#ifdef ZDEBUG
+		CONS_Debug(DBG_MEMORY, "block %u owned by %s:%d\n",
+			*blocknumon, block->ownerfile, block->ownerline);
+#endif
+#ifdef VALGRIND_MEMPOOL_EXISTS
+		if (!VALGRIND_MEMPOOL_EXISTS(block))
+		{
+			I_Error("Z_CheckHeap %d: block %u"
+				"(owned by %s:%d)"
+				" should not exist", i, *blocknumon,
+				block->ownerfile, block->ownerline
+			);
+		}
+#endif
+		if (block->user != NULL && *(block->user) != given)
+		{
+			I_Error("Z_CheckHeap %d: block %u"
+				"(owned by %s:%d)"
+				" doesn't have a proper user", i, *blocknumon,
+				block->ownerfile, block->ownerline
+			);
+		}
+		if (block->next->prev != block)
+		{
+			I_Error("Z_CheckHeap %d: block %u"
+				"(owned by %s:%d)"
+				" lacks proper backlink", i, *blocknumon,
+				block->ownerfile, block->ownerline
+			);
+		}
+		if (block->prev->next != block)
+		{
+			I_Error("Z_CheckHeap %d: block %u"
+				"(owned by %s:%d)"
+				" lacks proper forward link", i, *blocknumon,
+				block->ownerfile, block->ownerline
+			);
+		}
+#ifdef VALGRIND_MAKE_MEM_DEFINED
+		VALGRIND_MAKE_MEM_DEFINED(hdr, sizeof *hdr);
+#endif
+		if (block->id != ZONEID)
+		{
+			I_Error("Z_CheckHeap %d: block %u"
+				"(owned by %s:%d)"
+				" have the wrong ID", i, *blocknumon,
+				block->ownerfile, block->ownerline
+			);
+		}
+		if (TAGLIST(block->tag) != list)
+		{
+			I_Error("Z_CheckHeap %d: block %u"
+				"(owned by %s:%d)"
+				" is in the wrong tag list", i, *blocknumon,
+				block->ownerfile, block->ownerline
+			);
+		}
+	}
+}
+
 /** Frees all memory for a given set of tags.
   *
   * \param lowtag The lowest tag to consider.
@@ -351,15 +612,25 @@ void *Z_Realloc2(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits,
   */
 void Z_FreeTags(INT32 lowtag, INT32 hightag)
 {
-	memblock_t *block, *next;
+	memblock_t *block, *next, *head;
+	UINT32 blocknumon = 0;
+	INT32 list;
 	TracyCZone(__zone, true);
 
-	Z_CheckHeap(420);
-	for (block = head.next; block != &head; block = next)
+	for (list = TAGLIST(max(lowtag, 0)); list < NUMTAGLISTS; list++)
 	{
-		next = block->next; // get link before freeing
-		if (block->tag >= lowtag && block->tag <= hightag)
-			Z_Free(MEMORY(block));
+		if (!Z_TagListInRange(list, lowtag, hightag))
+			continue;
+
+		head = &heads[list];
+		Z_CheckTagList(list, 420, &blocknumon);
+
+		for (block = head->next; block != head; block = next)
+		{
+			next = block->next; // get link before freeing
+			if (block->tag >= lowtag && block->tag <= hightag)
+				Z_Free(MEMORY(block));
+		}
 	}
 
 	TracyCZoneEnd(__zone);
@@ -373,22 +644,31 @@ void Z_FreeTags(INT32 lowtag, INT32 hightag)
   */
 void Z_IterateTags(INT32 lowtag, INT32 hightag, boolean (*iterfunc)(void *))
 {
-	memblock_t *block, *next;
+	memblock_t *block, *next, *head;
+	INT32 list;
 	TracyCZone(__zone, true);
 
 	if (!iterfunc)
 		I_Error("Z_IterateTags: no iterator function was given");
 
-	for (block = head.next; block != &head; block = next)
+	for (list = TAGLIST(max(lowtag, 0)); list < NUMTAGLISTS; list++)
 	{
-		next = block->next; // get link before possibly freeing
+		if (!Z_TagListInRange(list, lowtag, hightag))
+			continue;
+
+		head = &heads[list];
 
-		if (block->tag >= lowtag && block->tag <= hightag)
+		for (block = head->next; block != head; block = next)
 		{
-			void *mem = MEMORY(block);
-			boolean free = iterfunc(mem);
-			if (free)
-				Z_Free(mem);
+			next = block->next; // get link before possibly freeing
+
+			if (block->tag >= lowtag && block->tag <= hightag)
+			{
+				void *mem = MEMORY(block);
+				boolean free = iterfunc(mem);
+				if (free)
+					Z_Free(mem);
+			}
 		}
 	}
 
@@ -431,65 +711,11 @@ void Z_CheckMemCleanup(void)
   */
 void Z_CheckHeap(INT32 i)
 {
-	memblock_t *block;
 	UINT32 blocknumon = 0;
-	void *given;
+	INT32 list;
 
-	for (block = head.next; block != &head; block = block->next)
-	{
-		blocknumon++;
-		given = MEMORY(block);
-#ifdef ZDEBUG
-		CONS_Debug(DBG_MEMORY, "block %u owned by %s:%d\n",
-			blocknumon, block->ownerfile, block->ownerline);
-#endif
-#ifdef VALGRIND_MEMPOOL_EXISTS
-		if (!VALGRIND_MEMPOOL_EXISTS(block))
-		{
-			I_Error("Z_CheckHeap %d: block %u"
-				"(owned by %s:%d)"
-				" should not exist", i, blocknumon,
-				" should not exist", i, blocknumon,
-				block->ownerfile, block->ownerline
-			);
-		}
-#endif
-		if (block->user != NULL && *(block->user) != given)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
-				"(owned by %s:%d)"
-				" doesn't have a proper user", i, blocknumon,
-				block->ownerfile, block->ownerline
-			);
-		}
-		if (block->next->prev != block)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
-				"(owned by %s:%d)"
-				" lacks proper backlink", i, blocknumon,
-				block->ownerfile, block->ownerline
-			);
-		}
-		if (block->prev->next != block)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
-				"(owned by %s:%d)"
-				" lacks proper forward link", i, blocknumon,
-				block->ownerfile, block->ownerline
-			);
-		}
-#ifdef VALGRIND_MAKE_MEM_DEFINED
-		VALGRIND_MAKE_MEM_DEFINED(hdr, sizeof *hdr);
-#endif
-		if (block->id != ZONEID)
-		{
-			I_Error("Z_CheckHeap %d: block %u"
-				"(owned by %s:%d)"
-				" have the wrong ID", i, blocknumon,
-				block->ownerfile, block->ownerline
-			);
-		}
-	}
+	for (list = 0; list < NUMTAGLISTS; list++)
+		Z_CheckTagList(list, i, &blocknumon);
 }
 
 // ------------------------
@@ -524,7 +750,9 @@ void Z_ChangeTag(void *ptr, INT32 tag)
 		I_Error("Internal memory management error: "
 			"tried to make block purgable but it has no owner");
 
+	Z_UnlinkBlock(block);
 	block->tag = tag;
+	Z_LinkBlock(block);
 }
 
 /** Changes a memory block's user.
@@ -574,12 +802,20 @@ size_t Z_TagsUsage(INT32 lowtag, INT32 hightag)
 {
 	size_t cnt = 0;
 	memblock_t *rover;
+	INT32 list;
 
-	for (rover = head.next; rover != &head; rover = rover->next)
+	for (list = TAGLIST(max(lowtag, 0)); list < NUMTAGLISTS-1 && list <= hightag; list++)
+		cnt += tagusage[list];
+
+	if (hightag >= NUMTAGLISTS-1 || lowtag < 0)
 	{
-		if (rover->tag < lowtag || rover->tag > hightag)
-			continue;
-		cnt += rover->size + sizeof *rover;
+		// the last list holds every other tag, so it has to be checked block by block
+		for (rover = heads[NUMTAGLISTS-1].next; rover != &heads[NUMTAGLISTS-1]; rover = rover->next)
+		{
+			if (rover->tag < lowtag || rover->tag > hightag)
+				continue;
+			cnt += rover->size + sizeof *rover;
+		}
 	}
 
 	return cnt;
@@ -613,6 +849,17 @@ static void Command_Memfree_f(void)
 	CONS_Printf(M_GetText("All purgable           : %7s KB\n"),
 		sizeu1(Z_TagsUsage(PU_PURGELEVEL, INT32_MAX)>>10));
 
+	if (gLheap)
+	{
+		const lua_heapstats_t *lua = LUA_HeapStats(gLheap);
+
+		CONS_Printf("\x82%s", M_GetText("Lua Memory Info\n"));
+		CONS_Printf(M_GetText("In use                 : %7s KB\n"), sizeu1(lua->live>>10));
+		CONS_Printf(M_GetText("Peak                   : %7s KB\n"), sizeu1(lua->peak>>10));
+		CONS_Printf(M_GetText("Reserved               : %7s KB\n"), sizeu1(lua->reserved>>10));
+		CONS_Printf(M_GetText("Allocations last tic   : %7u\n"), lua->ticallocs);
+	}
+
 #ifdef HWRENDER
 	if (rendermode == render_opengl)
 	{
@@ -639,7 +886,7 @@ static void Command_Memdump_f(void)
 {
 	memblock_t *block;
 	INT32 mintag = 0, maxtag = INT32_MAX;
-	INT32 i;
+	INT32 i, list;
 
 	if ((i = COM_CheckParm("-min")))
 		mintag = atoi(COM_Argv(i + 1));
@@ -647,12 +894,13 @@ static void Command_Memdump_f(void)
 	if ((i = COM_CheckParm("-max")))
 		maxtag = atoi(COM_Argv(i + 1));
 
-	for (block = head.next; block != &head; block = block->next)
-		if (block->tag >= mintag && block->tag <= maxtag)
-		{
-			char *filename = strrchr(block->ownerfile, PATHSEP[0]);
-			CONS_Printf("[%3d] %s (%s) bytes @ %s:%d\n", block->tag, sizeu1(block->size), sizeu2(block->realsize), filename ? filename + 1 : block->ownerfile, block->ownerline);
-		}
+	for (list = 0; list < NUMTAGLISTS; list++)
+		for (block = heads[list].next; block != &heads[list]; block = block->next)
+			if (block->tag >= mintag && block->tag <= maxtag)
+			{
+				char *filename = strrchr(block->ownerfile, PATHSEP[0]);
+				CONS_Printf("[%3d] %s (%s) bytes @ %s:%d\n", block->tag, sizeu1(block->size), sizeu2(block->realsize), filename ? filename + 1 : block->ownerfile, block->ownerline);
+			}
 }
 
 /** Creates a copy of a string.